@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,12 +11,55 @@
 #define PORT 60000
 #define BUFFER_SIZE 1024
 
+// 心跳：客户端C空闲时发"PING\n"，服务器直接回"PONG\n"，不转发给别的客户端。
+// 客户端C发来的是以换行结尾的命令和心跳，心跳可能和命令粘在同一次recv里，也可能被切成两半，
+// 所以只在消息边界（连接开头或换行之后）上剔除完整的心跳，末尾半个心跳留到下次recv拼上再判断。
+// 其他客户端的数据（如客户端A的二进制天气记录）里碰巧出现"PING\n"也不会被误删
+#define HEARTBEAT_PING "PING\n"
+#define HEARTBEAT_PONG "PONG\n"
+
 // 全局变量，需要在多线程间共享
 int client_a_fd = -1;
 int client_b_fd = -1;
 int client_c_fd = -1;  // 新增客户端C
 pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 
+// 客户端C连接的心跳剔除状态
+typedef struct {
+    char carry[sizeof(HEARTBEAT_PING)];     // 上次recv末尾的半个心跳
+    int carry_len;
+    int at_boundary;                        // 下一个字节是否在消息边界上
+} heartbeat_state_t;
+
+// 剔除buffer中处在消息边界上的心跳，返回剔除的个数，*len更新为要转发的长度。
+// buffer开头已经拼上了上次留下的半个心跳，这次末尾的半个心跳存进st->carry
+static int strip_heartbeats(char *buffer, int *len, heartbeat_state_t *st) {
+    const int n = sizeof(HEARTBEAT_PING) - 1;
+    int count = 0;
+    int r = 0, w = 0;
+    st->carry_len = 0;
+    while (r < *len) {
+        if (st->at_boundary) {
+            int left = *len - r;
+            if (left >= n && memcmp(buffer + r, HEARTBEAT_PING, n) == 0) {
+                r += n;
+                count++;
+                continue;
+            }
+            if (left < n && memcmp(buffer + r, HEARTBEAT_PING, left) == 0) {
+                memcpy(st->carry, buffer + r, left);
+                st->carry_len = left;
+                break;
+            }
+        }
+        st->at_boundary = buffer[r] == '\n';
+        buffer[w++] = buffer[r++];
+    }
+    *len = w;
+    buffer[w] = '\0';
+    return count;
+}
+
 void *handle_client(void *arg) {
     int client_fd = *(int *)arg;
     free(arg);
@@ -39,16 +83,16 @@ void *handle_client(void *arg) {
         client_a_fd = client_fd;
         printf("设置为客户端A\n");
         
-        // 如果客户端B已连接，通知客户端A
+        // 如果客户端B已连接，通知客户端A（通知和其他文本消息一样以换行结尾）
         if (client_b_fd != -1) {
-            const char *msg = "CLIENT_B_CONNECTED";
+            const char *msg = "CLIENT_B_CONNECTED\n";
             send(client_a_fd, msg, strlen(msg), 0);
             printf("已通知客户端A：客户端B已连接\n");
         }
         
         // 如果客户端C已连接，通知客户端A
         if (client_c_fd != -1) {
-            const char *msg = "CLIENT_C_CONNECTED";
+            const char *msg = "CLIENT_C_CONNECTED\n";
             send(client_a_fd, msg, strlen(msg), 0);
             printf("已通知客户端A：客户端C已连接\n");
         }
@@ -58,7 +102,7 @@ void *handle_client(void *arg) {
         
         // 如果客户端A已连接，通知客户端A
         if (client_a_fd != -1) {
-            const char *msg = "CLIENT_B_CONNECTED";
+            const char *msg = "CLIENT_B_CONNECTED\n";
             send(client_a_fd, msg, strlen(msg), 0);
             printf("已通知客户端A：客户端B已连接\n");
         }
@@ -68,7 +112,7 @@ void *handle_client(void *arg) {
         
         // 如果客户端A已连接，通知客户端A
         if (client_a_fd != -1) {
-            const char *msg = "CLIENT_C_CONNECTED";
+            const char *msg = "CLIENT_C_CONNECTED\n";
             send(client_a_fd, msg, strlen(msg), 0);
             printf("已通知客户端A：客户端C已连接\n");
         }
@@ -80,13 +124,20 @@ void *handle_client(void *arg) {
     }
     pthread_mutex_unlock(&lock);
     
-    // 发送连接确认
-    const char *confirm_msg = "CONNECTED";
+    // 发送连接确认（文本消息以换行结尾）
+    const char *confirm_msg = "CONNECTED\n";
     send(client_fd, confirm_msg, strlen(confirm_msg), 0);
     
+    // 角色在标识时就确定了，之后不会变
+    int is_client_c = strstr(buffer, "CLIENT_C") != NULL;
+    heartbeat_state_t heartbeat = { .carry_len = 0, .at_boundary = 1 };
+    
     while (1) {
         memset(buffer, 0, BUFFER_SIZE);
-        ret = recv(client_fd, buffer, BUFFER_SIZE, 0);
+        // 上次留下的半个心跳放在开头，和这次收到的数据拼起来判断
+        int carried = is_client_c ? heartbeat.carry_len : 0;
+        memcpy(buffer, heartbeat.carry, carried);
+        ret = recv(client_fd, buffer + carried, BUFFER_SIZE - 1 - carried, 0);
         
         if (ret <= 0) {
             printf("客户端断开连接\n");
@@ -106,22 +157,33 @@ void *handle_client(void *arg) {
             break;
         }
         
-        // 打印接收到的消息
-        printf("收到消息: %s\n", buffer);
+        if (is_client_c) {
+            ret += carried;
+            if (strip_heartbeats(buffer, &ret, &heartbeat) > 0) {
+                pthread_mutex_lock(&lock);
+                send(client_fd, HEARTBEAT_PONG, sizeof(HEARTBEAT_PONG) - 1, MSG_NOSIGNAL);
+                pthread_mutex_unlock(&lock);
+            }
+            if (ret == 0) {
+                continue;
+            }
+        }
         
         pthread_mutex_lock(&lock);
         if (client_fd == client_a_fd) {
-            // 客户端A发送的是天气信息，转发给客户端B和客户端C
+            // 客户端A发送的是二进制天气记录（或文本错误消息），按收到的字节数原样转发，不能用strlen
+            printf("收到客户端A消息: %d字节\n", ret);
             if (client_b_fd != -1) {
-                send(client_b_fd, buffer, strlen(buffer), 0);
+                send(client_b_fd, buffer, ret, 0);
                 printf("转发天气信息给客户端B\n");
             }
             if (client_c_fd != -1) {
-                send(client_c_fd, buffer, strlen(buffer), 0);
+                send(client_c_fd, buffer, ret, 0);
                 printf("转发天气信息给客户端C\n");
             }
         } else if (client_fd == client_b_fd) {
             // 客户端B发送的是城市名，转发给客户端A
+            printf("收到消息: %s\n", buffer);
             if (client_a_fd != -1) {
                 send(client_a_fd, buffer, strlen(buffer), 0);
                 printf("转发城市名给客户端A\n");
@@ -129,7 +191,7 @@ void *handle_client(void *arg) {
         } else if (client_fd == client_c_fd) {
             // 客户端C发送的是命令信息，转发给客户端B
             if (client_b_fd != -1) {
-                send(client_b_fd, buffer, strlen(buffer), 0);
+                send(client_b_fd, buffer, ret, 0);
                 printf("转发命令信息给客户端B: %s\n", buffer);
             }
         }
@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "city_resolver.h"
+
+#define NORM_LEN CITY_ID_LEN   // 归一化后城市名最大长度
+#define LEARN_MAX 64            // 地点ID缓存条数，满了按轮转覆盖最早的
+#define REJECT_TTL_S 3600       // 上游确认不存在的名字被拒绝的时长
+
+// 内置城市表：规范ID、中文名、其他别名（'|'分隔，"市"后缀和大小写、空格在归一化时处理）
+typedef struct {
+    struct {
+        const char *id;
+        const char *name;
+    } info;
+    const char *aliases;
+} city_entry_t;
+
+static const city_entry_t city_table[] = {
+    {{"beijing",      "北京"},   "peking|bj|帝都"},
+    {{"shanghai",     "上海"},   "sh|魔都|沪"},
+    {{"guangzhou",    "广州"},   "canton|gz|穗"},
+    {{"shenzhen",     "深圳"},   "sz|鹏城"},
+    {{"tianjin",      "天津"},   "tj|津"},
+    {{"chongqing",    "重庆"},   "chungking|cq|渝|山城"},
+    {{"chengdu",      "成都"},   "cd|蓉城"},
+    {{"hangzhou",     "杭州"},   "hz"},
+    {{"nanjing",      "南京"},   "nanking|nj|金陵"},
+    {{"wuhan",        "武汉"},   "wh|江城"},
+    {{"xian",         "西安"},   "sian|长安"},
+    {{"suzhou",       "苏州"},   "姑苏"},
+    {{"zhengzhou",    "郑州"},   "zz"},
+    {{"changsha",     "长沙"},   "cs|星城"},
+    {{"shenyang",     "沈阳"},   "mukden|sy"},
+    {{"qingdao",      "青岛"},   "tsingtao|qd"},
+    {{"jinan",        "济南"},   "tsinan|泉城"},
+    {{"dalian",       "大连"},   "dl"},
+    {{"xiamen",       "厦门"},   "amoy|xm|鹭岛"},
+    {{"fuzhou",       "福州"},   "foochow|榕城"},
+    {{"hefei",        "合肥"},   "hf"},
+    {{"kunming",      "昆明"},   "km|春城"},
+    {{"nanning",      "南宁"},   "nn|绿城"},
+    {{"guiyang",      "贵阳"},   "gy|筑城"},
+    {{"nanchang",     "南昌"},   "nc|洪城"},
+    {{"haikou",       "海口"},   "椰城"},
+    {{"sanya",        "三亚"},   "鹿城"},
+    {{"harbin",       "哈尔滨"}, "haerbin|hrb|冰城"},
+    {{"changchun",    "长春"},   "cc"},
+    {{"shijiazhuang", "石家庄"}, "sjz"},
+    {{"taiyuan",      "太原"},   "ty|并州"},
+    {{"huhehaote",    "呼和浩特"}, "hohhot|呼市"},
+    {{"lanzhou",      "兰州"},   "lz|金城"},
+    {{"xining",       "西宁"},   "xn"},
+    {{"yinchuan",     "银川"},   "yc"},
+    {{"wulumuqi",     "乌鲁木齐"}, "urumqi|乌市"},
+    {{"lasa",         "拉萨"},   "lhasa"},
+    {{"ningbo",       "宁波"},   "nb|甬"},
+    {{"wuxi",         "无锡"},   "wx"},
+    {{"dongguan",     "东莞"},   "dg|莞"},
+    {{"foshan",       "佛山"},   "fs|禅城"},
+    {{"zhuhai",       "珠海"},   "zh"},
+    {{"shantou",      "汕头"},   "swatow|st"},
+    {{"wenzhou",      "温州"},   "wz"},
+    {{"xuzhou",       "徐州"},   "xz|彭城"},
+    {{"hongkong",     "香港"},   "hong kong|xianggang|hkg"},
+    {{"macao",        "澳门"},   "macau|aomen"},
+    {{"taibei",       "台北"},   "taipei"},
+};
+
+#define CITY_NUM ((int)(sizeof(city_table) / sizeof(city_table[0])))
+
+// 字典树节点（左孩子右兄弟，节点池连续存放）
+typedef struct {
+    unsigned char label;
+    int16_t city;           // 以该节点结尾的城市下标，-1表示无
+    int32_t child;          // 第一个孩子，-1表示无
+    int32_t sibling;        // 下一个兄弟，-1表示无
+} trie_node_t;
+
+static trie_node_t *trie = NULL;
+static int trie_size = 0;
+static int trie_cap = 0;
+static pthread_once_t trie_once = PTHREAD_ONCE_INIT;
+
+// 归一化：去掉首尾空白（含全角空格）、字母转小写、去掉内部空格/连字符/撇号、去掉结尾的"市"
+// 返回归一化后的长度，过长或为空返回-1
+static int normalize(const char *src, char *out) {
+    int n = 0;
+    for (const unsigned char *p = (const unsigned char *)src; *p; p++) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '-' || *p == '\'') {
+            continue;
+        }
+        if (p[0] == 0xe3 && p[1] == 0x80 && p[2] == 0x80) {     // 全角空格
+            p += 2;
+            continue;
+        }
+        if (n >= NORM_LEN - 1) {
+            return -1;
+        }
+        out[n++] = (*p >= 'A' && *p <= 'Z') ? (char)(*p + 'a' - 'A') : (char)*p;
+    }
+
+    // 去掉结尾的"市"（UTF-8: e5 b8 82），但不能把整个名字去空
+    if (n > 3 && (unsigned char)out[n - 3] == 0xe5 && (unsigned char)out[n - 2] == 0xb8 &&
+        (unsigned char)out[n - 1] == 0x82) {
+        n -= 3;
+    }
+
+    out[n] = '\0';
+    return n > 0 ? n : -1;
+}
+
+static int new_node(unsigned char label) {
+    if (trie_size == trie_cap) {
+        int new_cap = trie_cap ? trie_cap * 2 : 1024;
+        trie_node_t *nodes = realloc(trie, new_cap * sizeof(trie_node_t));
+        if (nodes == NULL) {
+            return -1;
+        }
+        trie = nodes;
+        trie_cap = new_cap;
+    }
+    trie_node_t *node = &trie[trie_size];
+    node->label = label;
+    node->city = -1;
+    node->child = -1;
+    node->sibling = -1;
+    return trie_size++;
+}
+
+static void trie_insert(const char *name, int city) {
+    char key[NORM_LEN];
+    if (normalize(name, key) < 0) {
+        return;
+    }
+
+    int node = 0;   // 根节点
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        int child = trie[node].child;
+        while (child >= 0 && trie[child].label != *p) {
+            child = trie[child].sibling;
+        }
+        if (child < 0) {
+            child = new_node(*p);
+            if (child < 0) {
+                return;
+            }
+            trie[child].sibling = trie[node].child;
+            trie[node].child = child;
+        }
+        node = child;
+    }
+    if (trie[node].city < 0) {
+        trie[node].city = (int16_t)city;
+    }
+}
+
+static void trie_build(void) {
+    if (new_node(0) < 0) {
+        return;
+    }
+
+    for (int i = 0; i < CITY_NUM; i++) {
+        trie_insert(city_table[i].info.id, i);
+        trie_insert(city_table[i].info.name, i);
+
+        // 逐个插入别名
+        const char *alias = city_table[i].aliases;
+        while (alias != NULL && *alias) {
+            const char *end = strchr(alias, '|');
+            size_t len = end != NULL ? (size_t)(end - alias) : strlen(alias);
+            char buf[NORM_LEN];
+            if (len < sizeof(buf)) {
+                memcpy(buf, alias, len);
+                buf[len] = '\0';
+                trie_insert(buf, i);
+            }
+            alias = end != NULL ? end + 1 : NULL;
+        }
+    }
+}
+
+// 地点ID缓存：内置表之外的城市，按归一化后的原名记住上游的答复
+typedef struct {
+    char query[NORM_LEN];           // 归一化后的原名，空串表示空位
+    char id[CITY_ID_LEN];           // 上游返回的地点ID，负缓存时为空串
+    char name[CITY_NAME_LEN];
+    time_t reject_until;            // 负缓存到期时间（单调时钟），0表示不是负缓存
+} learned_city_t;
+
+static learned_city_t learned[LEARN_MAX];
+static int learned_next = 0;
+static pthread_mutex_t learned_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static time_t now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+// 在字典树中查找归一化后的名字，返回城市下标，-1表示不在内置表中
+static int trie_find(const char *key) {
+    pthread_once(&trie_once, trie_build);
+    if (trie_size == 0) {
+        return -1;
+    }
+
+    int node = 0;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        int child = trie[node].child;
+        while (child >= 0 && trie[child].label != *p) {
+            child = trie[child].sibling;
+        }
+        if (child < 0) {
+            return -1;
+        }
+        node = child;
+    }
+    return trie[node].city;
+}
+
+// 查找缓存条目，调用者持有learned_lock
+static learned_city_t *learned_find(const char *query) {
+    for (int i = 0; i < LEARN_MAX; i++) {
+        if (learned[i].query[0] != '\0' && strcmp(learned[i].query, query) == 0) {
+            return &learned[i];
+        }
+    }
+    return NULL;
+}
+
+// 按上游的地点ID查找缓存条目（区分大小写，地点ID原样比较），调用者持有learned_lock
+static learned_city_t *learned_find_id(const char *id) {
+    for (int i = 0; i < LEARN_MAX; i++) {
+        if (learned[i].query[0] != '\0' && learned[i].id[0] != '\0' && strcmp(learned[i].id, id) == 0) {
+            return &learned[i];
+        }
+    }
+    return NULL;
+}
+
+// 取query的缓存条目，没有就占一个位置，调用者持有learned_lock
+static learned_city_t *learned_slot(const char *query) {
+    learned_city_t *e = learned_find(query);
+    if (e == NULL) {
+        e = &learned[learned_next];
+        learned_next = (learned_next + 1) % LEARN_MAX;
+        memset(e, 0, sizeof(*e));
+        snprintf(e->query, sizeof(e->query), "%s", query);
+    }
+    return e;
+}
+
+int city_resolve(const char *input, city_info_t *out) {
+    char key[NORM_LEN];
+    if (input == NULL || out == NULL || normalize(input, key) < 0) {
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    int city = trie_find(key);
+    if (city >= 0) {
+        const city_entry_t *entry = &city_table[city];
+        snprintf(out->id, sizeof(out->id), "%s", entry->info.id);
+        snprintf(out->query, sizeof(out->query), "%s", entry->info.id);
+        snprintf(out->name, sizeof(out->name), "%s", entry->info.name);
+        out->verified = true;
+        return 0;
+    }
+
+    // 内置表之外：先看上游以前怎么答复的，没问过就用原名去问。
+    // 传进来的也可能是已经解析好的地点ID（预取、预报刷新、补发当前天气时），按ID原样认出来，
+    // 不能再当作名字归一化（地点ID区分大小写）
+    snprintf(out->id, sizeof(out->id), "%s", key);
+    snprintf(out->query, sizeof(out->query), "%s", key);
+    pthread_mutex_lock(&learned_lock);
+    learned_city_t *e = learned_find(key);
+    if (e == NULL) {
+        e = learned_find_id(input);
+        if (e != NULL) {
+            snprintf(out->query, sizeof(out->query), "%s", e->query);
+        }
+    }
+    int ret = 0;
+    if (e != NULL && e->reject_until != 0) {
+        ret = e->reject_until > now_sec() ? -1 : 0;
+    } else if (e != NULL) {
+        snprintf(out->id, sizeof(out->id), "%s", e->id);
+        snprintf(out->name, sizeof(out->name), "%s", e->name);
+        out->verified = true;
+    }
+    pthread_mutex_unlock(&learned_lock);
+    return ret;
+}
+
+void city_learn(const char *query, const char *location_id, const char *name) {
+    char key[NORM_LEN];
+    if (query == NULL || location_id == NULL || location_id[0] == '\0' || normalize(query, key) < 0 ||
+        trie_find(key) >= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&learned_lock);
+    learned_city_t *e = learned_slot(key);
+    snprintf(e->id, sizeof(e->id), "%s", location_id);
+    snprintf(e->name, sizeof(e->name), "%s", name != NULL ? name : "");
+    e->reject_until = 0;
+    pthread_mutex_unlock(&learned_lock);
+}
+
+void city_reject(const char *query) {
+    char key[NORM_LEN];
+    if (query == NULL || normalize(query, key) < 0 || trie_find(key) >= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&learned_lock);
+    learned_city_t *e = learned_slot(key);
+    if (e->id[0] == '\0') {        // 已学到地点ID的城市不会因为一次答复就作废
+        e->reject_until = now_sec() + REJECT_TTL_S;
+    }
+    pthread_mutex_unlock(&learned_lock);
+}
+
+int city_percent_encode(const char *src, char *out, size_t out_len) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t n = 0;
+
+    for (const unsigned char *p = (const unsigned char *)src; *p; p++) {
+        bool plain = (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+                     (*p >= '0' && *p <= '9') || *p == '-' || *p == '_' || *p == '.' || *p == '~';
+        size_t need = plain ? 1 : 3;
+        if (n + need >= out_len) {
+            return -1;
+        }
+        if (plain) {
+            out[n++] = (char)*p;
+        } else {
+            out[n++] = '%';
+            out[n++] = hex[*p >> 4];
+            out[n++] = hex[*p & 0x0f];
+        }
+    }
+
+    out[n] = '\0';
+    return (int)n;
+}
@@ -0,0 +1,38 @@
+#ifndef _CITY_RESOLVER_H
+#define _CITY_RESOLVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// 城市名解析
+// 把界面发来的自由格式城市名（"北京"、"北京市"、"beijing"、"Beijing "、"peking"）
+// 归一化后在内置的别名字典树中查找，得到规范的地点ID（上游接受的拼音ID，如"beijing"）。
+// 内置表之外的城市不在本地拒绝，而是用归一化后的原名去问上游；上游返回了地点ID就记进地点ID缓存，
+// 之后同名查询直接用地点ID，缓存键也随之固定。只有上游明确答复"不存在"的名字才做负缓存，
+// 一段时间内本地直接拒绝；网络错误、超时不算。规范ID同时作为缓存键，同一城市的不同写法会命中同一条缓存。
+// 字典树在第一次使用时构建，之后只读；地点ID缓存由互斥锁保护，可多线程并发查询。
+#define CITY_ID_LEN     64      // 地点ID/查询名最大长度（含结束符）
+#define CITY_NAME_LEN   24      // 中文名最大长度（含结束符），与weather_record_t.city_name相同
+
+typedef struct {
+    char id[CITY_ID_LEN];       // 规范地点ID（缓存键，心知天气的location参数）：内置城市是拼音ID，
+                                // 学到地点ID的城市是上游的地点ID，还没学到的是归一化后的原名
+    char query[CITY_ID_LEN];    // 按名字查询时用的名字（内置城市是拼音ID，其他是归一化后的原名）
+    char name[CITY_NAME_LEN];   // 中文名，还不知道时为空串
+    bool verified;              // 是否确认存在（内置城市或上游答复过）
+} city_info_t;
+
+// 解析城市名到out，成功返回0；名字为空/过长，或上游确认过不存在（负缓存未过期）返回-1。
+// input也可以是已学到的地点ID（即之前解析结果的id），得到与原先相同的结果
+int city_resolve(const char *input, city_info_t *out);
+
+// 上游按名字query查到了城市：记下它的地点ID和中文名（name可为NULL或空串）
+void city_learn(const char *query, const char *location_id, const char *name);
+
+// 上游明确答复名字query不存在：一段时间内city_resolve直接拒绝
+void city_reject(const char *query);
+
+// 百分号编码（RFC 3986，非保留字符原样保留），返回写入长度，空间不足返回-1
+int city_percent_encode(const char *src, char *out, size_t out_len);
+
+#endif
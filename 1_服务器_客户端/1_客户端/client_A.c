@@ -3,25 +3,81 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <errno.h>
 #include <pthread.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#include "forecast.h"
+#include "weather_prefetch.h"
+
 #define SERVER_IP "192.168.16.181"
 #define SERVER_PORT 60000
 #define BUFFER_SIZE 1024
+#define CACHE_CAPACITY 32     // 最多缓存的城市数
+#define CACHE_TTL 600         // 天气结果缓存有效期（秒）
+#define SERIES_CAPACITY 32    // 最多保存预报的城市数
+#define SERIES_DAYS 3         // 逐日预报天数
+#define SERIES_HOURS 24       // 逐小时预报小时数
+#define SERIES_REFRESH 3600   // 预报刷新间隔（秒）
+#define PREFETCH_BUDGET_RPM 10  // 默认预取预算（次/分钟），可用环境变量WEATHER_PREFETCH_RPM覆盖
+#define QUERY_SLOTS 8         // 同时在途的天气查询数
+#define REQUEST_QUEUE 64      // 已收到、尚未应答的请求数上限
+#define EPOLL_EVENTS 16
+#define RELAY_TAG (~0ULL)     // epoll事件数据：服务器连接
+
+// 一个请求（客户端B的城市更新或客户端C连接后补发的当前天气）
+// 请求按收到的顺序排队，结果先到的先在队列中等待，应答严格按请求顺序发出
+typedef enum {
+    REQ_WAITING,    // 等待空闲查询槽
+    REQ_RUNNING,    // 查询中
+    REQ_DONE,       // 已得到天气记录
+    REQ_FAILED      // 查询失败或城市未知
+} req_state_t;
 
-// 声明 forecast.c 中的函数
-void set_current_city(const char *city);
-const char* get_current_city();
-char* get_weather_data();
+typedef struct {
+    char input[WEATHER_CITY_LEN];     // 原始城市名，用于错误提示
+    char city[WEATHER_CITY_LEN];      // 规范地点ID，无效城市为空
+    req_state_t state;
+    weather_record_t rec;
+} request_t;
+
+// 查询槽：每个槽持有一个查询上下文，共享结果缓存
+typedef struct {
+    weather_client_t *wc;
+    int request;                          // 正在处理的请求序号，-1表示空闲
+    int reg_fds[WEATHER_HEDGE_MAX];       // 已注册到epoll的fd
+    int reg_num;
+} query_slot_t;
 
 int client_fd;
+weather_cache_t *weather_cache = NULL;
+weather_client_t *weather_ctx = NULL;   // 解析城市名、记录当前城市用的上下文
+weather_prefetch_t *weather_prefetch = NULL;
+weather_series_store_t *series_store = NULL;   // 各城市逐日/逐小时预报
 int running = 1;
 int client_b_connected = 0;
 int client_c_connected = 0;  // 新增客户端C连接状态
 
+int epoll_fd = -1;
+query_slot_t query_slots[QUERY_SLOTS];
+request_t requests[REQUEST_QUEUE];
+unsigned int req_head = 0;      // 最早的未应答请求
+unsigned int req_tail = 0;      // 下一个请求的序号
+
+// 服务器连接的接收缓冲：服务器按字节流转发，一次recv可能是半行，也可能是几行粘在一起，
+// 城市名和连接通知都以换行结尾，只处理收全的行，剩下的半行留到下次recv
+char relay_buf[BUFFER_SIZE];
+size_t relay_len = 0;
+
+// 预报刷新在后台线程中进行，不阻塞事件循环；只保留最新一个待刷新城市
+pthread_t series_thread;
+pthread_mutex_t series_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t series_cond = PTHREAD_COND_INITIALIZER;
+char series_city[WEATHER_CITY_LEN];
+
 // 信号处理函数
 void signal_handler(int sig) {
     if (sig == SIGINT) {
@@ -30,36 +86,320 @@ void signal_handler(int sig) {
     }
 }
 
-// 发送天气数据给服务器
-void send_weather_to_server() {
-    printf("正在查询 %s 的天气...\n", get_current_city());
-    
-    // 尝试多次查询，增加成功率
-    char *weather_info = NULL;
-    int max_retries = 3;
-    for (int i = 0; i < max_retries; i++) {
-        weather_info = get_weather_data();
-        if (weather_info) {
+// 预报刷新线程：有新的城市时检查预报是否过期，过期则刷新
+void *series_thread_func(void *arg) {
+    (void)arg;
+    weather_client_t *wc = weather_client_create(NULL, NULL);
+    if (wc == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&series_lock);
+    while (running) {
+        if (series_city[0] == '\0') {
+            pthread_cond_wait(&series_cond, &series_lock);
+            continue;
+        }
+        char city[WEATHER_CITY_LEN];
+        snprintf(city, sizeof(city), "%s", series_city);
+        series_city[0] = '\0';
+        pthread_mutex_unlock(&series_lock);
+
+        int age = weather_series_store_age(series_store, city);
+        if ((age < 0 || age >= SERIES_REFRESH) && weather_client_set_city(wc, city) == 0) {
+            weather_client_update_series(wc, series_store, SERIES_DAYS, SERIES_HOURS);
+        }
+
+        pthread_mutex_lock(&series_lock);
+    }
+    pthread_mutex_unlock(&series_lock);
+
+    weather_client_destroy(wc);
+    return NULL;
+}
+
+// 实况发出后再顺带刷新过期的预报，不影响实况响应时间
+void request_series_refresh(const char *city) {
+    pthread_mutex_lock(&series_lock);
+    snprintf(series_city, sizeof(series_city), "%s", city);
+    pthread_cond_signal(&series_cond);
+    pthread_mutex_unlock(&series_lock);
+}
+
+// 把查询槽当前的fd同步到epoll（fd会随重试/对冲变化）
+// 必须在每次推进查询后立即调用，此时关闭的fd号还没被别的槽复用
+void sync_slot_fds(int slot_index) {
+    query_slot_t *slot = &query_slots[slot_index];
+    struct pollfd pfds[WEATHER_HEDGE_MAX];
+    int n = slot->request >= 0 ? weather_client_pollfds(slot->wc, pfds) : 0;
+
+    // 已不再使用的fd：关闭时内核已自动移除，这里的DEL失败可以忽略
+    for (int i = 0; i < slot->reg_num; i++) {
+        bool keep = false;
+        for (int j = 0; j < n; j++) {
+            keep = keep || pfds[j].fd == slot->reg_fds[i];
+        }
+        if (!keep) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, slot->reg_fds[i], NULL);
+        }
+    }
+
+    // 当前fd：先改关注事件，不存在（新fd或同号新socket）再添加
+    for (int i = 0; i < n; i++) {
+        struct epoll_event ev;
+        ev.events = pfds[i].events;     // POLLIN/POLLOUT与EPOLLIN/EPOLLOUT取值相同
+        ev.data.u64 = ((uint64_t)slot_index << 32) | (uint32_t)pfds[i].fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pfds[i].fd, &ev) != 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pfds[i].fd, &ev);
+        }
+        slot->reg_fds[i] = pfds[i].fd;
+    }
+    slot->reg_num = n;
+}
+
+// 查询结束，记录结果并释放查询槽
+void finish_slot(int slot_index, int state) {
+    query_slot_t *slot = &query_slots[slot_index];
+    request_t *req = &requests[slot->request % REQUEST_QUEUE];
+    req->state = state == WEATHER_QUERY_DONE ? REQ_DONE : REQ_FAILED;
+    slot->request = -1;
+    sync_slot_fds(slot_index);
+}
+
+// 按请求顺序发出已完成的应答，遇到还在查询中的请求就停下
+void flush_responses() {
+    while (req_head != req_tail) {
+        request_t *req = &requests[req_head % REQUEST_QUEUE];
+        if (req->state == REQ_DONE) {
+            char text[WEATHER_RECORD_FORMAT_LEN];
+            weather_record_format(&req->rec, text, sizeof(text));
+            printf("查询结果:\n%s", text);
+
+            // 发送定长天气记录给服务器（转发给客户端B和客户端C），由显示端自行渲染
+            send(client_fd, &req->rec, sizeof(req->rec), 0);
+            printf("已发送天气记录给服务器（转发给客户端B和客户端C）\n");
+            request_series_refresh(req->city);
+        } else if (req->state == REQ_FAILED) {
+            printf("获取天气信息失败，发送错误消息\n");
+            // 发送错误消息给客户端B和客户端C（文本消息以换行结尾，接收端据此判断消息已收全）
+            char error_msg[256];
+            snprintf(error_msg, sizeof(error_msg),
+                    "无法获取 %s 的天气信息，请检查城市名是否正确\n", req->input);
+            send(client_fd, error_msg, strlen(error_msg), 0);
+        } else {
             break;
         }
-        printf("第%d次查询失败，1秒后重试...\n", i+1);
-        sleep(1);
+        req_head++;
     }
-    
-    if (weather_info) {
-        printf("查询结果:\n%s", weather_info);
-        
-        // 发送天气信息给服务器（转发给客户端B和客户端C）
-        send(client_fd, weather_info, strlen(weather_info), 0);
-        printf("已发送天气信息给服务器（转发给客户端B和客户端C）\n");
-        free(weather_info);
+}
+
+// 给等待中的请求分配空闲查询槽并开始查询
+void start_waiting_requests() {
+    for (unsigned int seq = req_head; seq != req_tail; seq++) {
+        request_t *req = &requests[seq % REQUEST_QUEUE];
+        if (req->state != REQ_WAITING) {
+            continue;
+        }
+
+        int slot_index = -1;
+        for (int i = 0; i < QUERY_SLOTS && slot_index < 0; i++) {
+            if (query_slots[i].request < 0) {
+                slot_index = i;
+            }
+        }
+        if (slot_index < 0) {
+            return;     // 没有空闲槽，等有查询结束再继续
+        }
+
+        // 切换失败时查询槽还停在上一个城市，不能拿它的天气应答这个请求
+        query_slot_t *slot = &query_slots[slot_index];
+        if (weather_client_set_city(slot->wc, req->city) != 0) {
+            req->state = REQ_FAILED;
+            continue;
+        }
+        printf("正在查询 %s 的天气...\n", req->city);
+        slot->request = seq;
+        req->state = REQ_RUNNING;
+
+        int state = weather_client_begin(slot->wc, &req->rec);
+        if (state == WEATHER_QUERY_PENDING) {
+            sync_slot_fds(slot_index);
+        } else {
+            finish_slot(slot_index, state);
+        }
+    }
+}
+
+// 收到一个请求：排队，城市未知的直接标记失败（仍按顺序应答）
+void enqueue_request(const char *input) {
+    if (req_tail - req_head >= REQUEST_QUEUE) {
+        printf("待处理请求过多，丢弃: %s\n", input);
+        return;
+    }
+
+    request_t *req = &requests[req_tail % REQUEST_QUEUE];
+    memset(req, 0, sizeof(*req));
+    snprintf(req->input, sizeof(req->input), "%s", input);
+
+    if (weather_client_set_city(weather_ctx, input) == 0) {
+        // 名字无效或上游确认过不存在的城市本地直接回错误，不发起HTTP请求
+        snprintf(req->city, sizeof(req->city), "%s", weather_client_get_city(weather_ctx));
+        req->state = REQ_WAITING;
+        weather_prefetch_record(weather_prefetch, req->city);
     } else {
-        printf("获取天气信息失败，发送错误消息\n");
-        // 发送错误消息给客户端B和客户端C
-        char error_msg[256];
-        snprintf(error_msg, sizeof(error_msg), 
-                "无法获取 %s 的天气信息，请检查城市名是否正确", get_current_city());
-        send(client_fd, error_msg, strlen(error_msg), 0);
+        req->state = REQ_FAILED;
+    }
+    req_tail++;
+}
+
+// 处理服务器转发来的一行消息（不含换行）：连接通知或客户端B的城市名
+void handle_relay_line(char *msg) {
+    msg[strcspn(msg, "\r")] = '\0';
+    if (msg[0] == '\0') {
+        return;
+    }
+    if (strcmp(msg, "CONNECTED") == 0) {
+        printf("服务器确认: %s\n", msg);
+        return;
+    }
+    // 客户端B第一次连接时查询初始天气；排在同一段数据中后面的城市更新之前
+    if (strcmp(msg, "CLIENT_B_CONNECTED") == 0) {
+        if (!client_b_connected) {
+            client_b_connected = 1;
+            printf("客户端B已连接！\n");
+            printf("正在查询初始天气数据...\n");
+            enqueue_request(weather_client_get_city(weather_ctx));
+        }
+        return;
+    }
+    // 检查是否是客户端C连接通知
+    if (strcmp(msg, "CLIENT_C_CONNECTED") == 0) {
+        client_c_connected = 1;
+        printf("客户端C已连接！\n");
+        // 发送当前天气给新连接的客户端C（客户端B还没连接时，初始天气会一起发给客户端C）
+        if (client_b_connected) {
+            enqueue_request(weather_client_get_city(weather_ctx));
+        }
+        return;
+    }
+
+    // 更新城市并查询天气
+    printf("收到客户端B的城市更新: %s\n", msg);
+    enqueue_request(msg);
+}
+
+// 从接收缓冲中取出收全的行逐条处理；缓冲满了还没有换行时整段当作一行
+void handle_relay_data() {
+    size_t pos = 0;
+    while (pos < relay_len) {
+        char *line = relay_buf + pos;
+        char *end = memchr(line, '\n', relay_len - pos);
+        if (end == NULL) {
+            if (pos > 0 || relay_len < sizeof(relay_buf) - 1) {
+                break;      // 半行，等换行
+            }
+            end = relay_buf + relay_len;
+        }
+        *end = '\0';
+        handle_relay_line(line);
+        pos = end - relay_buf + (end < relay_buf + relay_len ? 1 : 0);
+    }
+    memmove(relay_buf, relay_buf + pos, relay_len - pos);
+    relay_len -= pos;
+}
+
+// 接收服务器连接上的数据并处理收全的行，返回recv的返回值
+int recv_relay() {
+    // 留一个字节给整段当作一行时的结束符
+    int ret = recv(client_fd, relay_buf + relay_len, sizeof(relay_buf) - 1 - relay_len, 0);
+    if (ret > 0) {
+        relay_len += ret;
+        handle_relay_data();
+    }
+    return ret;
+}
+
+// 事件循环：同时处理服务器连接和所有在途的天气查询
+void event_loop() {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = RELAY_TAG;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &ev);
+
+    while (running) {
+        start_waiting_requests();
+        flush_responses();
+
+        // 等待时间取所有在途查询中最近的定时动作
+        int timeout = -1;
+        for (int i = 0; i < QUERY_SLOTS; i++) {
+            if (query_slots[i].request >= 0) {
+                int t = weather_client_timeout_ms(query_slots[i].wc);
+                if (timeout < 0 || t < timeout) {
+                    timeout = t;
+                }
+            }
+        }
+
+        struct epoll_event events[EPOLL_EVENTS];
+        int num = epoll_wait(epoll_fd, events, EPOLL_EVENTS, timeout);
+        if (num < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait失败");
+            break;
+        }
+
+        for (int i = 0; i < num; i++) {
+            if (events[i].data.u64 == RELAY_TAG) {
+                if (recv_relay() <= 0) {
+                    printf("连接断开\n");
+                    running = 0;
+                    break;
+                }
+                continue;
+            }
+
+            int slot_index = events[i].data.u64 >> 32;
+            query_slot_t *slot = &query_slots[slot_index];
+            if (slot->request < 0) {
+                continue;       // 本轮已结束的查询的残留事件
+            }
+            struct pollfd pfd;
+            pfd.fd = (int)(uint32_t)events[i].data.u64;
+            pfd.events = 0;
+            pfd.revents = events[i].events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP);
+            request_t *req = &requests[slot->request % REQUEST_QUEUE];
+            int state = weather_client_step(slot->wc, &pfd, 1, &req->rec);
+            if (state == WEATHER_QUERY_PENDING) {
+                sync_slot_fds(slot_index);
+            } else {
+                finish_slot(slot_index, state);
+            }
+        }
+
+        // 到期的对冲/截止定时
+        for (int i = 0; i < QUERY_SLOTS; i++) {
+            query_slot_t *slot = &query_slots[i];
+            if (slot->request >= 0 && weather_client_timeout_ms(slot->wc) == 0) {
+                request_t *req = &requests[slot->request % REQUEST_QUEUE];
+                int state = weather_client_step(slot->wc, NULL, 0, &req->rec);
+                if (state == WEATHER_QUERY_PENDING) {
+                    sync_slot_fds(i);
+                } else {
+                    finish_slot(i, state);
+                }
+            }
+        }
+    }
+
+    // 放弃还在途的查询
+    for (int i = 0; i < QUERY_SLOTS; i++) {
+        if (query_slots[i].request >= 0) {
+            weather_client_cancel(query_slots[i].wc);
+            query_slots[i].request = -1;
+        }
     }
 }
 
@@ -67,6 +407,49 @@ int main() {
     // 设置信号处理
     signal(SIGINT, signal_handler);
     
+    // 创建结果缓存和查询上下文
+    weather_cache = weather_cache_create(CACHE_CAPACITY, CACHE_TTL);
+    // 同机共享天气表：多个客户端A进程共用查询结果，网关等读者直接读取
+    weather_shm_t *weather_shm = weather_shm_open(true);
+    if (weather_shm == NULL) {
+        printf("打开共享天气表失败，只使用进程内缓存\n");
+    }
+    weather_cache_set_shared(weather_cache, weather_shm);
+    weather_ctx = weather_client_create("广州", weather_cache);
+    series_store = weather_series_store_create(SERIES_CAPACITY);
+    if (weather_ctx == NULL) {
+        printf("创建天气查询上下文失败\n");
+        return 1;
+    }
+    
+    // 每个查询槽一个上下文，共享同一个结果缓存
+    for (int i = 0; i < QUERY_SLOTS; i++) {
+        query_slots[i].wc = weather_client_create(NULL, weather_cache);
+        query_slots[i].request = -1;
+        if (query_slots[i].wc == NULL) {
+            printf("创建天气查询上下文失败\n");
+            return 1;
+        }
+    }
+    
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("创建epoll失败");
+        return 1;
+    }
+    pthread_create(&series_thread, NULL, series_thread_func, NULL);
+    
+    // 启动热门城市预取，预算为0表示关闭
+    int budget_rpm = PREFETCH_BUDGET_RPM;
+    const char *rpm_env = getenv("WEATHER_PREFETCH_RPM");
+    if (rpm_env != NULL) {
+        budget_rpm = atoi(rpm_env);
+    }
+    if (budget_rpm > 0) {
+        weather_prefetch = weather_prefetch_create(weather_cache, budget_rpm);
+        weather_prefetch_start(weather_prefetch);
+    }
+    
     // 创建socket
     client_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (client_fd < 0) {
@@ -102,42 +485,26 @@ int main() {
     printf("连接成功！\n");
     printf("已连接到服务器 %s:%d\n", SERVER_IP, SERVER_PORT);
     printf("我是客户端A\n");
-    printf("当前查询城市: %s\n", get_current_city());
+    printf("当前查询城市: %s\n", weather_client_get_city(weather_ctx));
     printf("等待客户端B连接...\n\n");
     
     // 发送身份标识
     send(client_fd, "CLIENT_A", 8, 0);
     
-    // 接收连接确认
-    char buffer[BUFFER_SIZE];
-    memset(buffer, 0, BUFFER_SIZE);
-    recv(client_fd, buffer, BUFFER_SIZE, 0);
-    printf("服务器确认: %s\n", buffer);
-    
     // 设置接收超时
     struct timeval tv;
     tv.tv_sec = 2;  // 2秒超时
     tv.tv_usec = 0;
     setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
     
-    // 等待客户端B连接的通知（最多等待5秒）
+    // 接收连接确认，等待客户端B连接的通知（最多等待5秒）；
+    // 确认、通知和之后的城市名可能粘在一起收到，都按行交给handle_relay_line
     printf("等待客户端B连接...\n");
     int wait_count = 0;
-    while (wait_count < 5 && running) {
-        memset(buffer, 0, BUFFER_SIZE);
-        int ret = recv(client_fd, buffer, BUFFER_SIZE, 0);
-        
-        if (ret > 0) {
-            if (strstr(buffer, "CLIENT_B_CONNECTED") != NULL) {
-                client_b_connected = 1;
-                printf("客户端B已连接！\n");
-                break;
-            } else if (strstr(buffer, "CLIENT_C_CONNECTED") != NULL) {
-                client_c_connected = 1;
-                printf("客户端C已连接！\n");
-            }
+    while (wait_count < 5 && running && !client_b_connected) {
+        if (recv_relay() > 0) {
+            continue;
         }
-        
         wait_count++;
         sleep(1);
     }
@@ -147,54 +514,29 @@ int main() {
     tv.tv_usec = 0;
     setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
     
-    // 如果客户端B已连接，发送初始天气数据
+    // 如果客户端B已连接（初始天气已排队），进入事件循环处理城市更新
     if (client_b_connected) {
-        // 获取初始天气数据
-        printf("正在查询初始天气数据...\n");
-        char *weather_info = get_weather_data();
-        if (weather_info) {
-            printf("初始天气信息:\n%s", weather_info);
-            
-            // 发送天气信息给服务器（转发给客户端B和客户端C）
-            send(client_fd, weather_info, strlen(weather_info), 0);
-            printf("已发送初始天气信息给客户端B和客户端C\n");
-            free(weather_info);
-        } else {
-            printf("获取天气信息失败\n");
-        }
-        
-        // 循环等待客户端B发送城市名
-        while (running) {
-            printf("\n等待客户端B发送城市名...\n");
-            memset(buffer, 0, BUFFER_SIZE);
-            int ret = recv(client_fd, buffer, BUFFER_SIZE, 0);
-            
-            if (ret <= 0) {
-                printf("连接断开\n");
-                running = 0;
-                break;
-            }
-            
-            // 检查是否是客户端C连接通知
-            if (strstr(buffer, "CLIENT_C_CONNECTED") != NULL) {
-                client_c_connected = 1;
-                printf("客户端C已连接！\n");
-                // 发送当前天气给新连接的客户端C
-                send_weather_to_server();
-                continue;
-            }
-            
-            // 更新城市并查询天气
-            printf("收到客户端B的城市更新: %s\n", buffer);
-            set_current_city(buffer);
-            
-            // 查询并发送天气数据
-            send_weather_to_server();
-        }
+        event_loop();
     } else {
         printf("客户端B未连接，无法继续工作\n");
     }
     
+    // 通知预报刷新线程退出
+    pthread_mutex_lock(&series_lock);
+    running = 0;
+    pthread_cond_signal(&series_cond);
+    pthread_mutex_unlock(&series_lock);
+    pthread_join(series_thread, NULL);
+    
     close(client_fd);
+    close(epoll_fd);
+    weather_prefetch_destroy(weather_prefetch);
+    for (int i = 0; i < QUERY_SLOTS; i++) {
+        weather_client_destroy(query_slots[i].wc);
+    }
+    weather_client_destroy(weather_ctx);
+    weather_series_store_destroy(series_store);
+    weather_cache_destroy(weather_cache);
+    weather_shm_close(weather_shm);
     return 0;
 }
\ No newline at end of file
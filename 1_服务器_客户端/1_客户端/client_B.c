@@ -2,84 +2,299 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#include "weather_record.h"
+#include "actuator_cmd.h"      // 网关的执行器命令表（由actuator_commands.json生成）
+
 #define SERVER_IP "192.168.16.181"
 #define SERVER_PORT 60000
 #define BUFFER_SIZE 1024
+#define REPLY_TIMEOUT_MS 10000    // 发出城市名后等待天气信息的时间
+
+// 客户端B只有一个线程：poll同时等待键盘输入和服务器连接，
+// 客户端C转发来的命令一到就执行，天气信息随时到随时显示，不再被fgets或recv阻塞。
+// 服务器按字节流转发，一次recv可能是半条消息，也可能是几条消息粘在一起，
+// 所以收到的数据先放进接收缓冲，再按消息边界逐条取出：天气记录定长，文本消息（命令、提示）以换行结尾。
 
 int client_fd;
 
+static char rx_buf[BUFFER_SIZE * 2];    // 服务器连接的接收缓冲
+static size_t rx_len = 0;
+static char line_buf[BUFFER_SIZE];      // 键盘输入缓冲（还没有遇到换行的部分）
+static size_t line_len = 0;
+static long long reply_deadline = 0;    // 等待天气信息的截止时间（毫秒），0表示没有在等
+static int led_on = 0;
+static int buzzer_on = 0;
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void show_prompt(void) {
+    printf("输入城市名更新天气查询 (如: 北京/beijing, 上海/shanghai, 广州/guangzhou): ");
+    fflush(stdout);
+}
+
+// 显示收到的天气信息
+static void show_weather(const weather_record_t *rec) {
+    char text[WEATHER_RECORD_FORMAT_LEN];
+    weather_record_format(rec, text, sizeof(text));
+    printf("\n收到天气信息:\n%s\n", text);
+}
+
+// 客户端C转发来的控制命令：按网关的命令表（actuator_cmd.h）解析，带参数的命令取出参数执行。
+// 是命令返回1（参数不合法的也算，提示后丢弃），不是命令返回0
+static int execute_command(const char *text, size_t len) {
+    actuator_cmd_t cmd;
+    int ret = actuator_cmd_parse(text, len, &cmd);
+    if (ret == ACTUATOR_CMD_UNKNOWN) {
+        return 0;
+    }
+    if (ret != 0) {
+        printf("\n忽略参数不合法的命令: %.*s\n", (int)len, text);
+        return 1;
+    }
+    switch (cmd.id) {
+    case ACTUATOR_CMD_LED_ON:
+        led_on = cmd.led_on.brightness > 0;
+        break;
+    case ACTUATOR_CMD_LED_PATTERN:
+        led_on = 1;
+        break;
+    case ACTUATOR_CMD_LED_OFF:
+        led_on = 0;
+        break;
+    case ACTUATOR_CMD_BUZZER_ON:
+        buzzer_on = 1;
+        break;
+    case ACTUATOR_CMD_BUZZER_OFF:
+        buzzer_on = 0;
+        break;
+    default:
+        break;
+    }
+    char canonical[64];
+    actuator_cmd_format(&cmd, canonical, sizeof(canonical));
+    printf("\n执行命令: %s (LED=%d 蜂鸣器=%d)\n", canonical, led_on, buzzer_on);
+    return 1;
+}
+
+// 处理一条文本消息（一行，不含换行）：服务器确认、客户端C转发来的命令，其余按文本显示
+static void handle_text(const char *text, size_t len) {
+    while (len > 0 && (text[len - 1] == '\r' || text[len - 1] == ' ' || text[len - 1] == '\0')) {
+        len--;
+    }
+    if (len == 0) {
+        return;
+    }
+    static const char confirm[] = "CONNECTED";
+    if (len == sizeof(confirm) - 1 && memcmp(text, confirm, len) == 0) {
+        printf("服务器确认: %s\n", confirm);
+        return;
+    }
+    if (!execute_command(text, len)) {
+        printf("\n收到消息: %.*s\n", (int)len, text);
+        // 客户端A的错误提示也是对城市查询的应答
+        reply_deadline = 0;
+    }
+}
+
+// 文本消息的长度（*skip为消息后面要一起跳过的换行数），0表示还没收全：
+// 文本以换行结尾；遇到下一条天气记录的开头时，前面的文本到此为止。
+// 缓冲末尾没有换行的半行、以及魔数的前几个字节留到下次recv补齐后再判断；缓冲满了（full）时整段当作文本
+static size_t text_end(const char *data, size_t len, bool full, size_t *skip) {
+    uint32_t magic = WEATHER_RECORD_MAGIC;
+    *skip = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            *skip = 1;
+            return i;
+        }
+        size_t head = len - i < sizeof(magic) ? len - i : sizeof(magic);
+        if (i > 0 && memcmp(data + i, &magic, head) == 0) {
+            return head == sizeof(magic) ? i : 0;
+        }
+    }
+    return full ? len : 0;
+}
+
+// 从接收缓冲中取出完整的消息逐条处理，剩下半条天气记录时留到下次
+static void handle_received(void) {
+    uint32_t magic = WEATHER_RECORD_MAGIC;
+    size_t pos = 0;
+    while (pos < rx_len) {
+        const char *p = rx_buf + pos;
+        size_t left = rx_len - pos;
+        size_t head = left < sizeof(magic) ? left : sizeof(magic);
+
+        if (memcmp(p, &magic, head) == 0) {
+            if (left < sizeof(weather_record_t)) {
+                break;      // 天气记录还没收全
+            }
+            if (weather_record_check(p, sizeof(weather_record_t))) {
+                weather_record_t rec;
+                memcpy(&rec, p, sizeof(rec));
+                show_weather(&rec);
+                reply_deadline = 0;
+                pos += sizeof(weather_record_t);
+                continue;
+            }
+        }
+        size_t skip;
+        size_t n = text_end(p, left, rx_len == sizeof(rx_buf), &skip);
+        if (n + skip == 0) {
+            break;      // 半行文本，等换行
+        }
+        handle_text(p, n);
+        pos += n + skip;
+    }
+    memmove(rx_buf, rx_buf + pos, rx_len - pos);
+    rx_len -= pos;
+}
+
+// 处理一行键盘输入，返回-1表示退出
+static int handle_line(char *line) {
+    line[strcspn(line, "\r")] = '\0';
+    if (strcmp(line, "quit") == 0) {
+        return -1;
+    }
+    if (line[0] == '\0') {
+        show_prompt();
+        return 0;
+    }
+    // 城市名和其他文本消息一样以换行结尾，连着输入的几个城市名不会在客户端A那里粘成一个
+    char msg[BUFFER_SIZE + 1];
+    int len = snprintf(msg, sizeof(msg), "%s\n", line);
+    if (send(client_fd, msg, len, 0) < 0) {
+        printf("发送失败: %s\n", strerror(errno));
+        return -1;
+    }
+    printf("已发送城市名: %s\n", line);
+    printf("等待客户端A返回天气信息...\n");
+    reply_deadline = now_ms() + REPLY_TIMEOUT_MS;
+    return 0;
+}
+
+// 读键盘输入，按换行切成一行一行处理，返回-1表示退出
+static int read_stdin(void) {
+    ssize_t ret = read(STDIN_FILENO, line_buf + line_len, sizeof(line_buf) - 1 - line_len);
+    if (ret <= 0) {
+        return -1;
+    }
+    line_len += ret;
+
+    char *start = line_buf;
+    char *nl;
+    while ((nl = memchr(start, '\n', line_buf + line_len - start)) != NULL) {
+        *nl = '\0';
+        if (handle_line(start) != 0) {
+            return -1;
+        }
+        start = nl + 1;
+    }
+    line_len -= start - line_buf;
+    memmove(line_buf, start, line_len);
+    // 一行太长装不下，截断当作一行
+    if (line_len == sizeof(line_buf) - 1) {
+        line_buf[line_len] = '\0';
+        line_len = 0;
+        return handle_line(line_buf);
+    }
+    return 0;
+}
+
+// 读服务器连接，返回-1表示连接断开
+static int read_server(void) {
+    ssize_t ret = recv(client_fd, rx_buf + rx_len, sizeof(rx_buf) - rx_len, 0);
+    if (ret == 0 || (ret < 0 && errno != EINTR && errno != EAGAIN)) {
+        printf("\n服务器连接已断开\n");
+        return -1;
+    }
+    if (ret > 0) {
+        rx_len += ret;
+        handle_received();
+        // 缓冲满了还凑不出一条消息，说明数据已乱，丢弃
+        if (rx_len == sizeof(rx_buf)) {
+            rx_len = 0;
+        }
+        if (reply_deadline == 0) {
+            show_prompt();
+        }
+    }
+    return 0;
+}
+
 int main() {
     client_fd = socket(AF_INET, SOCK_STREAM, 0);
-    
+
     struct sockaddr_in server_addr;
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(SERVER_PORT);
     server_addr.sin_addr.s_addr = inet_addr(SERVER_IP);
-    
-    connect(client_fd, (struct sockaddr *)&server_addr, sizeof(server_addr));
-    
+
+    if (connect(client_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        printf("连接服务器 %s:%d 失败: %s\n", SERVER_IP, SERVER_PORT, strerror(errno));
+        close(client_fd);
+        return -1;
+    }
+
     printf("已连接到服务器 %s:%d\n", SERVER_IP, SERVER_PORT);
     printf("我是客户端B (192.168.16.182)\n");
     printf("输入城市名发送给客户端A，客户端A会自动查询该城市天气\n");
     printf("输入quit退出\n\n");
-    
-    // 发送身份标识
+
+    // 发送身份标识，服务器确认和初始天气信息都在事件循环里收
     send(client_fd, "CLIENT_B", 8, 0);
-    
-    // 接收连接确认
-    char buffer[BUFFER_SIZE];
-    memset(buffer, 0, BUFFER_SIZE);
-    recv(client_fd, buffer, BUFFER_SIZE, 0);
-    printf("服务器确认: %s\n", buffer);
-    
-    // 接收初始天气信息
     printf("等待客户端A发送天气信息...\n");
-    memset(buffer, 0, BUFFER_SIZE);
-    recv(client_fd, buffer, BUFFER_SIZE, 0);
-    printf("收到天气信息:\n%s\n", buffer);
-    
-    // 发送消息
+    reply_deadline = now_ms() + REPLY_TIMEOUT_MS;
+
+    struct pollfd fds[2] = {
+        { .fd = STDIN_FILENO, .events = POLLIN },
+        { .fd = client_fd, .events = POLLIN },
+    };
     while (1) {
-        printf("输入城市名更新天气查询 (如: 北京/beijing, 上海/shanghai, 广州/guangzhou): ");
-        fflush(stdout);
-        
-        if (fgets(buffer, BUFFER_SIZE, stdin) == NULL) {
-            break;
+        int timeout = -1;
+        if (reply_deadline != 0) {
+            long long left = reply_deadline - now_ms();
+            timeout = left > 0 ? (int)left : 0;
         }
-        
-        buffer[strcspn(buffer, "\n")] = 0;
-        
-        if (strcmp(buffer, "quit") == 0) {
+
+        int n = poll(fds, 2, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("poll失败: %s\n", strerror(errno));
             break;
         }
-        
-        send(client_fd, buffer, strlen(buffer), 0);
-        printf("已发送城市名: %s\n", buffer);
-        
-    // 等待客户端A返回天气信息
-    printf("等待客户端A返回天气信息...\n");
-    memset(buffer, 0, BUFFER_SIZE);
 
-    // 设置接收超时
-    struct timeval tv;
-    tv.tv_sec = 10;  // 10秒超时
-    tv.tv_usec = 0;
-    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        // 服务器的消息先处理，命令不用排在键盘输入后面
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (read_server() != 0) {
+                break;
+            }
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (read_stdin() != 0) {
+                break;
+            }
+        }
 
-    int ret = recv(client_fd, buffer, BUFFER_SIZE, 0);
-    if (ret <= 0) {
-        printf("等待超时或连接错误\n");
-        strcpy(buffer, "等待响应超时");
+        if (reply_deadline != 0 && now_ms() >= reply_deadline) {
+            printf("\n等待超时：客户端A没有返回天气信息\n");
+            reply_deadline = 0;
+            show_prompt();
+        }
     }
 
-    printf("收到天气信息:\n%s\n", buffer);
-    }
-    
     close(client_fd);
     return 0;
-}
\ No newline at end of file
+}
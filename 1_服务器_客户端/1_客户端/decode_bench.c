@@ -0,0 +1,348 @@
+// 天气响应解码基准
+// 对fixtures下录制的上游响应，分别用生成的单遍解码器（weather_decode.c）和原先的cJSON逐级取值
+// 解码到同一个结构体，先逐字节比较两者结果是否一致，再各循环若干次统计每次解码的耗时和内存分配次数：
+//   ./decode_bench -d fixtures -n 20000
+// 结果不一致时返回1，便于脚本判断回归。
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+
+#include "cJSON.h"
+#include "weather_decode.h"
+#include "weather_series.h"
+
+typedef struct {
+    const char *name;
+    const char *file;           // fixtures下的文件名
+    size_t size;                // 解码结果结构体大小
+    int (*generated)(const char *json, size_t len, void *out);
+    int (*reference)(const char *json, size_t len, void *out);
+} decode_case_t;
+
+static unsigned long alloc_count = 0;
+
+static void *count_malloc(size_t size) {
+    alloc_count++;
+    return malloc(size);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// ---------------- 原先的cJSON解码路径（基准） ----------------
+
+static bool ref_number(cJSON *obj, const char *key, double *out) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (cJSON_IsNumber(item)) {
+        *out = item->valuedouble;
+        return true;
+    }
+    if (cJSON_IsString(item) && item->valuestring[0] != '\0') {
+        char *end;
+        *out = strtod(item->valuestring, &end);
+        return end != item->valuestring;
+    }
+    return false;
+}
+
+static int8_t ref_i8(cJSON *obj, const char *key) {
+    double v;
+    if (!ref_number(obj, key, &v) || v < -127 || v > 127) {
+        return JSON_NONE_I8;
+    }
+    return (int8_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+static uint8_t ref_u8(cJSON *obj, const char *key) {
+    double v;
+    if (!ref_number(obj, key, &v) || v < 0 || v >= JSON_NONE_U8) {
+        return JSON_NONE_U8;
+    }
+    return (uint8_t)(v + 0.5);
+}
+
+static uint16_t ref_u16(cJSON *obj, const char *key) {
+    double v;
+    if (!ref_number(obj, key, &v) || v < 0 || v >= JSON_NONE_U16) {
+        return JSON_NONE_U16;
+    }
+    return (uint16_t)v;
+}
+
+static uint16_t ref_u16_x10(cJSON *obj, const char *key) {
+    double v;
+    if (!ref_number(obj, key, &v) || v < 0 || v * 10 >= JSON_NONE_U16) {
+        return JSON_NONE_U16;
+    }
+    return (uint16_t)(v * 10 + 0.5);
+}
+
+static int16_t ref_i16_x10(cJSON *obj, const char *key) {
+    double v;
+    if (!ref_number(obj, key, &v) || v * 10 <= JSON_NONE_I16 || v * 10 > INT16_MAX) {
+        return JSON_NONE_I16;
+    }
+    return (int16_t)(v < 0 ? v * 10 - 0.5 : v * 10 + 0.5);
+}
+
+static void ref_text(cJSON *obj, const char *key, char *out, size_t out_len) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (cJSON_IsString(item)) {
+        snprintf(out, out_len, "%s", item->valuestring);
+    }
+}
+
+static const char *ref_string(cJSON *obj, const char *key) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+static cJSON *ref_results0(cJSON *root) {
+    return cJSON_GetArrayItem(cJSON_GetObjectItem(root, "results"), 0);
+}
+
+static int ref_seniverse_now(const char *json, size_t len, void *out) {
+    (void)len;
+    seniverse_now_t *now = out;
+    memset(now, 0, sizeof(*now));
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return -1;
+    }
+    cJSON *city = ref_results0(root);
+    cJSON *location = cJSON_GetObjectItem(city, "location");
+    cJSON *current = cJSON_GetObjectItem(city, "now");
+    ref_text(location, "id", now->location_id, sizeof(now->location_id));
+    ref_text(location, "name", now->city_name, sizeof(now->city_name));
+    ref_text(current, "text", now->text, sizeof(now->text));
+    ref_text(current, "wind_direction", now->wind_direction, sizeof(now->wind_direction));
+    now->code = ref_u8(current, "code");
+    now->temperature = ref_i16_x10(current, "temperature");
+    now->humidity = ref_u8(current, "humidity");
+    now->wind_degree = ref_u16(current, "wind_direction_degree");
+    now->wind_speed = ref_u16_x10(current, "wind_speed");
+    now->wind_scale = ref_u8(current, "wind_scale");
+    const char *update = ref_string(city, "last_update");
+    now->last_update = update != NULL ? weather_series_parse_time(update) : 0;
+    cJSON_Delete(root);
+    return 0;
+}
+
+static int ref_seniverse_daily(const char *json, size_t len, void *out) {
+    (void)len;
+    seniverse_daily_t *daily = out;
+    memset(daily, 0, sizeof(*daily));
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return -1;
+    }
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(ref_results0(root), "daily")) {
+        if (daily->day_num >= 15) {
+            break;
+        }
+        seniverse_daily_day_t *day = &daily->day[daily->day_num++];
+        const char *date = ref_string(item, "date");
+        day->date = date != NULL ? weather_series_parse_day(date) : -1;
+        day->high = ref_i8(item, "high");
+        day->low = ref_i8(item, "low");
+        day->code_day = ref_u8(item, "code_day");
+        day->code_night = ref_u8(item, "code_night");
+        day->humidity = ref_u8(item, "humidity");
+        day->wind_scale = ref_u8(item, "wind_scale");
+        day->rainfall = ref_u16_x10(item, "rainfall");
+    }
+    cJSON_Delete(root);
+    return 0;
+}
+
+static int ref_seniverse_hourly(const char *json, size_t len, void *out) {
+    (void)len;
+    seniverse_hourly_t *hourly = out;
+    memset(hourly, 0, sizeof(*hourly));
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return -1;
+    }
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(ref_results0(root), "hourly")) {
+        if (hourly->hour_num >= 72) {
+            break;
+        }
+        seniverse_hourly_hour_t *hour = &hourly->hour[hourly->hour_num++];
+        const char *time_text = ref_string(item, "time");
+        hour->time = time_text != NULL ? weather_series_parse_hour(time_text) : -1;
+        hour->temperature = ref_i8(item, "temperature");
+        hour->code = ref_u8(item, "code");
+        hour->humidity = ref_u8(item, "humidity");
+        hour->wind_speed = ref_u16_x10(item, "wind_speed");
+    }
+    cJSON_Delete(root);
+    return 0;
+}
+
+static int ref_wttr_now(const char *json, size_t len, void *out) {
+    (void)len;
+    wttr_now_t *now = out;
+    memset(now, 0, sizeof(*now));
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return -1;
+    }
+    cJSON *current = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "current_condition"), 0);
+    ref_text(cJSON_GetArrayItem(cJSON_GetObjectItem(current, "lang_zh"), 0), "value",
+             now->text_zh, sizeof(now->text_zh));
+    ref_text(cJSON_GetArrayItem(cJSON_GetObjectItem(current, "weatherDesc"), 0), "value",
+             now->text_en, sizeof(now->text_en));
+    now->code = ref_u16(current, "weatherCode");
+    now->temperature = ref_i16_x10(current, "temp_C");
+    now->humidity = ref_u8(current, "humidity");
+    now->wind_speed = ref_u16_x10(current, "windspeedKmph");
+    now->wind_degree = ref_u16(current, "winddirDegree");
+    cJSON_Delete(root);
+    return 0;
+}
+
+static int ref_owm_now(const char *json, size_t len, void *out) {
+    (void)len;
+    owm_now_t *now = out;
+    memset(now, 0, sizeof(*now));
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return -1;
+    }
+    cJSON *weather = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "weather"), 0);
+    cJSON *main_obj = cJSON_GetObjectItem(root, "main");
+    cJSON *wind = cJSON_GetObjectItem(root, "wind");
+    ref_text(weather, "description", now->text, sizeof(now->text));
+    now->code = ref_u16(weather, "id");
+    now->temperature = ref_i16_x10(main_obj, "temp");
+    now->humidity = ref_u8(main_obj, "humidity");
+    now->wind_speed = ref_u16_x10(wind, "speed");
+    now->wind_degree = ref_u16(wind, "deg");
+    double dt;
+    now->dt = ref_number(root, "dt", &dt) && dt > 0 ? (uint32_t)dt : 0;
+    cJSON_Delete(root);
+    return 0;
+}
+
+// ---------------- 生成的解码器 ----------------
+
+#define GENERATED(name) \
+    static int gen_##name(const char *json, size_t len, void *out) { return name##_decode(json, len, out); }
+
+GENERATED(seniverse_now)
+GENERATED(seniverse_daily)
+GENERATED(seniverse_hourly)
+GENERATED(wttr_now)
+GENERATED(owm_now)
+
+static const decode_case_t cases[] = {
+    {"seniverse_now", "now.json", sizeof(seniverse_now_t), gen_seniverse_now, ref_seniverse_now},
+    {"seniverse_now", "now_beijing.json", sizeof(seniverse_now_t), gen_seniverse_now, ref_seniverse_now},
+    {"seniverse_daily", "daily.json", sizeof(seniverse_daily_t), gen_seniverse_daily, ref_seniverse_daily},
+    {"seniverse_hourly", "hourly.json", sizeof(seniverse_hourly_t), gen_seniverse_hourly, ref_seniverse_hourly},
+    {"wttr_now", "wttr.json", sizeof(wttr_now_t), gen_wttr_now, ref_wttr_now},
+    {"owm_now", "owm.json", sizeof(owm_now_t), gen_owm_now, ref_owm_now},
+};
+
+static char *load_file(const char *dir, const char *name, size_t *len) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(size + 1);
+    if (buf != NULL && fread(buf, 1, size, fp) == (size_t)size) {
+        buf[size] = '\0';
+        *len = size;
+    } else {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+// 循环解码iterations次，返回每次的纳秒数，allocs返回每次的分配次数
+static double time_decode(int (*decode)(const char *, size_t, void *), const char *json, size_t len,
+                          void *out, int iterations, double *allocs) {
+    unsigned long before = alloc_count;
+    double start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        decode(json, len, out);
+    }
+    double elapsed = now_ns() - start;
+    *allocs = (double)(alloc_count - before) / iterations;
+    return elapsed / iterations;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "用法: %s [-d fixtures目录] [-n 每个用例的循环次数]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *dir = "fixtures";
+    int iterations = 20000;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:h")) != -1) {
+        switch (opt) {
+            case 'd': dir = optarg; break;
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (iterations <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    cJSON_Hooks hooks = {count_malloc, free};
+    cJSON_InitHooks(&hooks);
+
+    int mismatches = 0;
+    fprintf(stderr, "%-18s %-18s %7s %12s %10s %12s %10s %8s\n",
+            "解码", "文件", "字节", "cJSON ns", "分配/次", "生成 ns", "分配/次", "加速");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const decode_case_t *c = &cases[i];
+        size_t len;
+        char *json = load_file(dir, c->file, &len);
+        if (json == NULL) {
+            fprintf(stderr, "读取%s/%s失败\n", dir, c->file);
+            mismatches++;
+            continue;
+        }
+
+        // 两条路径的结果必须逐字节一致
+        void *gen_out = calloc(1, c->size);
+        void *ref_out = calloc(1, c->size);
+        int gen_ret = c->generated(json, len, gen_out);
+        int ref_ret = c->reference(json, len, ref_out);
+        if (gen_ret != 0 || ref_ret != 0 || memcmp(gen_out, ref_out, c->size) != 0) {
+            fprintf(stderr, "%s(%s): 解码结果不一致 (生成%d, cJSON%d)\n", c->name, c->file, gen_ret, ref_ret);
+            mismatches++;
+        }
+
+        double ref_allocs, gen_allocs;
+        double ref_ns = time_decode(c->reference, json, len, ref_out, iterations, &ref_allocs);
+        double gen_ns = time_decode(c->generated, json, len, gen_out, iterations, &gen_allocs);
+        fprintf(stderr, "%-16s %-16s %7zu %12.0f %10.1f %12.0f %10.1f %7.1fx\n",
+                c->name, c->file, len, ref_ns, ref_allocs, gen_ns, gen_allocs, ref_ns / gen_ns);
+
+        free(gen_out);
+        free(ref_out);
+        free(json);
+    }
+    return mismatches ? 1 : 0;
+}
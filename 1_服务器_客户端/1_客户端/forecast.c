@@ -23,267 +23,945 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <poll.h>
 #include <ctype.h>
 #include "common.h"
-#include "cJSON.h"
+#include "forecast.h"
+#include "weather_http.h"
+#include "weather_provider.h"
+#include "weather_decode.h"
 
-// 全局变量，存储当前要查询的城市
-char current_city[50] = "广州";
+// 单调时钟秒数
+static time_t monotonic_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+// 按提供方的默认值初始化，host/port为NULL/0时用提供方默认服务器；需要密钥却没有配置时返回-1
+static int endpoint_init(weather_endpoint_t *ep, const weather_provider_t *provider, const char *host, int port) {
+    const char *key = provider->key_env != NULL ? getenv(provider->key_env) : NULL;
+    if (key == NULL) {
+        key = provider->default_key;
+    }
+    if (provider->key_env != NULL && key == NULL) {
+        printf("天气提供方%s缺少API密钥（环境变量%s），跳过\n", provider->name, provider->key_env);
+        return -1;
+    }
+
+    memset(ep, 0, sizeof(*ep));
+    ep->provider = provider;
+    snprintf(ep->key, sizeof(ep->key), "%s", key != NULL ? key : "");
+    snprintf(ep->host, sizeof(ep->host), "%s", host != NULL ? host : provider->default_host);
+    ep->port = port > 0 && port <= 65535 ? port : provider->default_port;
+    return 0;
+}
+
+// 创建查询上下文
+weather_client_t *weather_client_create(const char *city, weather_cache_t *cache) {
+    weather_client_t *wc = calloc(1, sizeof(*wc));
+    if (wc == NULL) {
+        return NULL;
+    }
+
+    // 城市名无法识别时退回默认城市
+    if (weather_client_set_city(wc, city != NULL ? city : "广州") != 0) {
+        weather_client_set_city(wc, "广州");
+    }
+    wc->cache = cache;
+    wc->deadline_ms = WEATHER_DEADLINE_MS;
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        wc->attempts[i].fd = -1;
+    }
+
+    // 默认只访问心知天气线上API，环境变量可切换到本地替身服务器（见weather_stub.c）
+    const char *host = getenv("WEATHER_API_HOST");
+    const char *port = getenv("WEATHER_API_PORT");
+    endpoint_init(&wc->endpoints[0], weather_provider_find("seniverse"), host, port != NULL ? atoi(port) : 0);
+    wc->endpoint_num = 1;
+
+    const char *providers = getenv("WEATHER_PROVIDERS");
+    if (providers != NULL) {
+        weather_client_set_providers(wc, providers);
+    }
+    const char *mode = getenv("WEATHER_PROVIDER_MODE");
+    if (mode != NULL && strcasecmp(mode, "parallel") == 0) {
+        wc->sched = WEATHER_SCHED_PARALLEL;
+    }
+    return wc;
+}
+
+// 销毁查询上下文
+void weather_client_destroy(weather_client_t *wc) {
+    if (wc == NULL) {
+        return;
+    }
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        http_attempt_free(&wc->attempts[i]);
+    }
+    free(wc);
+}
+
+// 切换到解析好的城市，成功返回0
+static int use_city(weather_client_t *wc, const city_info_t *info) {
+    if (city_percent_encode(info->id, wc->location, sizeof(wc->location)) < 0) {
+        return -1;
+    }
+    wc->city_info = *info;
+    snprintf(wc->city, sizeof(wc->city), "%s", info->id);
+    return 0;
+}
+
+// 设置当前城市：先解析成规范地点ID，名字无效或上游确认过不存在直接拒绝，当前城市保持不变
+int weather_client_set_city(weather_client_t *wc, const char *city) {
+    if (wc == NULL || city == NULL) {
+        return -1;
+    }
+
+    city_info_t info;
+    if (city_resolve(city, &info) != 0) {
+        printf("未知城市: %s\n", city);
+        return -1;
+    }
+    if (use_city(wc, &info) != 0) {
+        return -1;
+    }
+
+    printf("已更新查询城市为: %s (%s)%s\n", info.name[0] != '\0' ? info.name : info.query, wc->city,
+           info.verified ? "" : "，待上游确认");
+    return 0;
+}
+
+// 设置主提供方的服务器地址
+void weather_client_set_server(weather_client_t *wc, const char *host, int port) {
+    if (wc == NULL || host == NULL || port <= 0 || port > 65535) {
+        return;
+    }
+    weather_endpoint_t *ep = &wc->endpoints[0];
+    snprintf(ep->host, sizeof(ep->host), "%s", host);
+    ep->port = port;
+    ep->addr_expire = 0;    // 地址变了，下次查询重新解析
+}
 
-// 设置当前城市
-void set_current_city(const char *city) {
-    if (city != NULL && strlen(city) > 0) {
-        strncpy(current_city, city, sizeof(current_city) - 1);
-        current_city[sizeof(current_city) - 1] = '\0';
-        printf("已更新查询城市为: %s\n", current_city);
+// 设置提供方列表，如"seniverse,wttr=127.0.0.1:8081,owm=[::1]:8082"
+int weather_client_set_providers(weather_client_t *wc, const char *spec) {
+    if (wc == NULL || spec == NULL) {
+        return -1;
+    }
+
+    weather_endpoint_t endpoints[WEATHER_PROVIDER_MAX];
+    int num = 0;
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ", ", &save); item != NULL && num < WEATHER_PROVIDER_MAX;
+         item = strtok_r(NULL, ", ", &save)) {
+        char *host = strchr(item, '=');
+        int port = 0;
+        if (host != NULL) {
+            *host++ = '\0';
+            // 主机后可带端口；IPv6地址带端口时写成[::1]:8080
+            char *colon = strrchr(host, ':');
+            if (host[0] == '[' && strchr(host, ']') != NULL) {
+                char *end = strchr(host, ']');
+                *end = '\0';
+                colon = end[1] == ':' ? end + 1 : NULL;
+                host++;
+            } else if (colon != NULL && strchr(host, ':') != colon) {
+                colon = NULL;       // 不带端口的IPv6地址
+            }
+            if (colon != NULL) {
+                *colon = '\0';
+                port = atoi(colon + 1);
+            }
+        }
+
+        const weather_provider_t *provider = weather_provider_find(item);
+        if (provider == NULL) {
+            printf("未知的天气提供方: %s\n", item);
+            continue;
+        }
+        if (endpoint_init(&endpoints[num], provider, host, port) == 0) {
+            printf("天气提供方%d: %s %s:%d\n", num, provider->name, endpoints[num].host, endpoints[num].port);
+            num++;
+        }
+    }
+
+    if (num == 0) {
+        printf("没有可用的天气提供方，保持原配置\n");
+        return -1;
+    }
+    memcpy(wc->endpoints, endpoints, num * sizeof(endpoints[0]));
+    wc->endpoint_num = num;
+    return 0;
+}
+
+// 设置多提供方调度方式
+void weather_client_set_schedule(weather_client_t *wc, weather_sched_t sched) {
+    if (wc != NULL) {
+        wc->sched = sched;
+    }
+}
+
+// 设置单次查询的截止时间（毫秒）
+void weather_client_set_deadline(weather_client_t *wc, int deadline_ms) {
+    if (wc != NULL && deadline_ms > 0) {
+        wc->deadline_ms = deadline_ms;
     }
 }
 
 // 获取当前城市
-const char* get_current_city() {
-    return current_city;
+const char *weather_client_get_city(const weather_client_t *wc) {
+    return wc->city;
 }
 
-// 获取天气数据（返回格式化字符串，需要调用者释放）
-char* get_weather_data() {
-    printf("查询城市: %s (长度: %zu)\n", current_city, strlen(current_city));
-    
-    struct hostent *he = gethostbyname("api.seniverse.com");
-    if(he == NULL) {
-        perror("DNS查询失败");
-        return NULL;
+// 解析提供方服务器地址（IPv4和IPv6，最多WEATHER_ADDR_MAX个），结果缓存一段时间
+// 两个地址族交替排列，避免某一族整体不通时所有早期尝试都落在它上面；
+// 重新解析后仍存在的地址保留之前测得的RTT。
+// 使用getaddrinfo代替不可重入的gethostbyname
+static int resolve_server(weather_endpoint_t *ep) {
+    if (ep->addr_expire != 0 && monotonic_sec() < ep->addr_expire) {
+        return 0;
     }
 
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-    bzero(&addr, len);
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
 
-    addr.sin_family = AF_INET;
-    addr.sin_addr   = *(struct in_addr*)((he->h_addr_list)[0]);
-    addr.sin_port   = htons(80);
+    char port[8];
+    snprintf(port, sizeof(port), "%d", ep->port);
 
-    printf("正在连接到天气服务器 %s:%d...\n", 
-           inet_ntoa(*(struct in_addr*)((he->h_addr_list)[0])), 80);
-    
-    // 创建TCP套接字
-    int fd = socket(AF_INET, SOCK_STREAM, 0);
-    if(connect(fd, (struct sockaddr *)&addr, len) != 0) {
+    int ret = getaddrinfo(ep->host, port, &hints, &res);
+    if (ret != 0 || res == NULL) {
+        printf("DNS查询失败(%s): %s\n", ep->host, gai_strerror(ret));
+        return -1;
+    }
+
+    // 按地址族分开，再交替合并
+    struct addrinfo *v6[WEATHER_ADDR_MAX], *v4[WEATHER_ADDR_MAX];
+    int n6 = 0, n4 = 0;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET6 && n6 < WEATHER_ADDR_MAX) {
+            v6[n6++] = ai;
+        } else if (ai->ai_family == AF_INET && n4 < WEATHER_ADDR_MAX) {
+            v4[n4++] = ai;
+        }
+    }
+
+    struct sockaddr_storage old_addrs[WEATHER_ADDR_MAX];
+    double old_rtt[WEATHER_ADDR_MAX];
+    int old_num = ep->addr_num;
+    memcpy(old_addrs, ep->addrs, sizeof(old_addrs));
+    memcpy(old_rtt, ep->addr_rtt_ms, sizeof(old_rtt));
+
+    ep->addr_num = 0;
+    for (int i = 0; (i < n6 || i < n4) && ep->addr_num < WEATHER_ADDR_MAX; i++) {
+        struct addrinfo *pick[2] = { i < n6 ? v6[i] : NULL, i < n4 ? v4[i] : NULL };
+        for (int k = 0; k < 2 && ep->addr_num < WEATHER_ADDR_MAX; k++) {
+            if (pick[k] == NULL) {
+                continue;
+            }
+            int n = ep->addr_num++;
+            memset(&ep->addrs[n], 0, sizeof(ep->addrs[n]));
+            memcpy(&ep->addrs[n], pick[k]->ai_addr, pick[k]->ai_addrlen);
+            ep->addr_lens[n] = pick[k]->ai_addrlen;
+            ep->addr_rtt_ms[n] = 0;
+            for (int j = 0; j < old_num; j++) {
+                if (memcmp(&old_addrs[j], &ep->addrs[n], pick[k]->ai_addrlen) == 0) {
+                    ep->addr_rtt_ms[n] = old_rtt[j];
+                }
+            }
+        }
+    }
+    ep->addr_expire = monotonic_sec() + WEATHER_ADDR_TTL;
+    freeaddrinfo(res);
+    return ep->addr_num > 0 ? 0 : -1;
+}
+
+// 地址的可读形式 "ip:port"
+static void addr_to_string(const struct sockaddr_storage *ss, char *out, size_t len) {
+    char ip[INET6_ADDRSTRLEN] = "?";
+    int port = 0;
+    if (ss->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)ss;
+        inet_ntop(AF_INET6, &in6->sin6_addr, ip, sizeof(ip));
+        port = ntohs(in6->sin6_port);
+        snprintf(out, len, "[%s]:%d", ip, port);
+    } else {
+        const struct sockaddr_in *in4 = (const struct sockaddr_in *)ss;
+        inet_ntop(AF_INET, &in4->sin_addr, ip, sizeof(ip));
+        port = ntohs(in4->sin_port);
+        snprintf(out, len, "%s:%d", ip, port);
+    }
+}
+
+// 记录一次建连结果，平滑方式同TCP的SRTT（新样本占1/4）
+static void record_connect(weather_endpoint_t *ep, int index, double ms) {
+    double *rtt = &ep->addr_rtt_ms[index];
+    *rtt = *rtt == 0 ? ms : *rtt * 0.75 + ms * 0.25;
+}
+
+// 记录提供方的一次查询耗时，平滑方式同上
+static void record_score(weather_endpoint_t *ep, double ms) {
+    ep->score_ms = ep->score_ms == 0 ? ms : ep->score_ms * 0.75 + ms * 0.25;
+}
+
+static double endpoint_score(const weather_endpoint_t *ep) {
+    return ep->score_ms != 0 ? ep->score_ms : WEATHER_SCORE_UNKNOWN_MS;
+}
+
+// 按RTT从小到大排出本次查询的地址顺序，未测量的按WEATHER_RTT_UNKNOWN_MS计，相同时保持解析顺序
+static void order_addresses(weather_endpoint_t *ep) {
+    for (int i = 0; i < ep->addr_num; i++) {
+        int idx = i;
+        double key = ep->addr_rtt_ms[i] != 0 ? ep->addr_rtt_ms[i] : WEATHER_RTT_UNKNOWN_MS;
+        int j = i - 1;
+        while (j >= 0) {
+            int o = ep->addr_order[j];
+            double ok = ep->addr_rtt_ms[o] != 0 ? ep->addr_rtt_ms[o] : WEATHER_RTT_UNKNOWN_MS;
+            if (ok <= key) {
+                break;
+            }
+            ep->addr_order[j + 1] = o;
+            j--;
+        }
+        ep->addr_order[j + 1] = idx;
+    }
+}
+
+// 排出本次查询的候选顺序：参与查询的提供方按成绩从好到差排序（相同时保持配置顺序），
+// 第k轮取每个提供方RTT第k小的地址。这样对冲和失败补发总是先换提供方，再换同一提供方的其他地址。
+static void plan_candidates(weather_client_t *wc) {
+    int rank[WEATHER_PROVIDER_MAX];
+    int num = 0;
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        if (!wc->endpoints[i].in_query) {
+            continue;
+        }
+        double key = endpoint_score(&wc->endpoints[i]);
+        int j = num - 1;
+        while (j >= 0 && endpoint_score(&wc->endpoints[rank[j]]) > key) {
+            rank[j + 1] = rank[j];
+            j--;
+        }
+        rank[j + 1] = i;
+        num++;
+    }
+
+    wc->query_eps = num;
+    wc->cand_num = 0;
+    wc->cand_pos = 0;
+    for (int k = 0; k < WEATHER_ADDR_MAX; k++) {
+        for (int r = 0; r < num; r++) {
+            const weather_endpoint_t *ep = &wc->endpoints[rank[r]];
+            if (k < ep->addr_num) {
+                wc->cand_ep[wc->cand_num] = (uint8_t)rank[r];
+                wc->cand_addr[wc->cand_num] = (uint8_t)ep->addr_order[k];
+                wc->cand_num++;
+            }
+        }
+    }
+}
+
+// 取下一个候选，跳过本次查询中已放弃的提供方，用完后从头循环；没有可用候选返回-1
+static int next_candidate(weather_client_t *wc) {
+    for (int i = 0; i < wc->cand_num; i++) {
+        int c = (wc->cand_pos + i) % wc->cand_num;
+        if (wc->endpoints[wc->cand_ep[c]].in_query) {
+            wc->cand_pos = c + 1;
+            return c;
+        }
+    }
+    return -1;
+}
+
+static int cmp_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+// 对冲延迟：取最近成功请求耗时的p95，样本不足时用默认值
+static double hedge_delay_ms(const weather_client_t *wc) {
+    if (wc->latency_num < WEATHER_LATENCY_MIN_SAMPLES) {
+        return WEATHER_HEDGE_DEFAULT_MS;
+    }
+
+    uint16_t sorted[WEATHER_LATENCY_SAMPLES];
+    memcpy(sorted, wc->latency_ms, wc->latency_num * sizeof(sorted[0]));
+    qsort(sorted, wc->latency_num, sizeof(sorted[0]), cmp_u16);
+
+    double delay = sorted[wc->latency_num * 95 / 100];
+    if (delay < WEATHER_HEDGE_MIN_MS) {
+        delay = WEATHER_HEDGE_MIN_MS;
+    }
+    if (delay > wc->deadline_ms / 2) {
+        delay = wc->deadline_ms / 2;
+    }
+    return delay;
+}
+
+static void record_latency(weather_client_t *wc, double ms) {
+    wc->latency_ms[wc->latency_pos] = ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+    wc->latency_pos = (wc->latency_pos + 1) % WEATHER_LATENCY_SAMPLES;
+    if (wc->latency_num < WEATHER_LATENCY_SAMPLES) {
+        wc->latency_num++;
+    }
+}
+
+// 尝试失败（连接、收发、状态码或解码），计入所问提供方的成绩
+static void attempt_failed(weather_client_t *wc, int slot) {
+    weather_endpoint_t *ep = &wc->endpoints[wc->attempt_ep[slot]];
+    record_score(ep, WEATHER_SCORE_FAIL_MS);
+    ep->failures++;
+}
+
+// 用第cand个候选在slot上发起一次新的尝试
+static void start_attempt(weather_client_t *wc, int slot, int cand) {
+    http_attempt_t *a = &wc->attempts[slot];
+    weather_endpoint_t *ep = &wc->endpoints[wc->cand_ep[cand]];
+    int addr_index = wc->cand_addr[cand];
+    char addr[INET6_ADDRSTRLEN + 8];
+    addr_to_string(&ep->addrs[addr_index], addr, sizeof(addr));
+    printf("%s%s服务器 %s...\n", wc->query_started == 0 ? "正在连接到" : "发起对冲/并行连接到",
+           ep->provider->name, addr);
+
+    a->addr_index = addr_index;
+    wc->attempt_ep[slot] = wc->cand_ep[cand];
+    wc->last_start_ms = http_now_ms();
+    wc->query_started++;
+    if (http_attempt_start(a, (struct sockaddr *)&ep->addrs[addr_index], ep->addr_lens[addr_index],
+                           ep->request, ep->req_len) != 0) {
         perror("连接天气服务器失败");
-        close(fd);
-        return NULL;
+        record_connect(ep, addr_index, WEATHER_RTT_FAIL_MS);
+        attempt_failed(wc, slot);
     }
-    
-    printf("已连接到天气服务器\n");
-    
-    // 准备HTTP请求
-    char request[1024];
-    snprintf(request, 1024, 
-             "GET /v3/weather/now.json?key=SK4cNZ6Q9wXmiwJ0r&location=%s&language=zh-Hans&unit=c HTTP/1.1\r\n"
-             "Host: api.seniverse.com\r\n"
+}
+
+// 生成发给某个提供方的GET请求，成功返回0
+static int build_request(weather_endpoint_t *ep, const char *path) {
+    int req_len = snprintf(ep->request, sizeof(ep->request), 
+             "GET %s HTTP/1.1\r\n"
+             "Host: %s\r\n"
              "User-Agent: WeatherClient/1.0\r\n"
+             "Accept-Encoding: " HTTP_ACCEPT_ENCODING "\r\n"
              "Connection: close\r\n\r\n", 
-             current_city);
-    
-    printf("发送的HTTP请求:\n%s\n", request);
-    
-    // 发送请求
-    if(write(fd, request, strlen(request)) <= 0) {
-        perror("发送请求失败");
-        close(fd);
-        return NULL;
+             path, ep->host);
+    if (req_len <= 0 || req_len >= (int)sizeof(ep->request)) {
+        printf("请求过长\n");
+        return -1;
     }
     
-    printf("请求已发送，等待响应...\n");
-    
-    // 接收完整响应
-    char *response = NULL;
-    size_t response_size = 0;
-    size_t total_read = 0;
-    char buffer[4096];
-    
-    while(1) {
-        int n = read(fd, buffer, sizeof(buffer) - 1);
-        if(n <= 0) {
+    printf("发送的HTTP请求:\n%s\n", ep->request);
+    ep->req_len = req_len;
+    return 0;
+}
+
+// 准备一次查询：调用者已为要问的提供方生成请求并置上in_query，
+// 这里解析地址、排出候选顺序、初始化对冲计时；rec非NULL表示实况查询，收到响应即解码。成功返回0
+static int query_begin(weather_client_t *wc, weather_record_t *rec) {
+    // 上一次查询胜出的尝试还拿着响应缓冲（http_get的返回值），现在可以还给缓冲池了
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        http_attempt_cancel(&wc->attempts[i]);
+    }
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        weather_endpoint_t *ep = &wc->endpoints[i];
+        if (ep->in_query && resolve_server(ep) != 0) {
+            ep->in_query = false;
+        }
+        if (ep->in_query) {
+            order_addresses(ep);
+        }
+    }
+    plan_candidates(wc);
+    if (wc->cand_num == 0) {
+        return -1;
+    }
+
+    wc->query_start_ms = http_now_ms();
+    wc->hedge_delay_ms = hedge_delay_ms(wc);
+    wc->next_hedge_ms = wc->query_start_ms;
+    wc->query_started = 0;
+    wc->body = NULL;
+    wc->decode_rec = rec;
+    // 排序模式下只问成绩最好的，其他提供方的成绩不会更新；定期并行探测一次，
+    // 让恢复或变快的提供方有机会重新排到前面（第一次查询也是探测，所有提供方都有成绩）
+    wc->probing = wc->sched == WEATHER_SCHED_RANKED && wc->query_eps > 1 &&
+                  wc->query_count % WEATHER_PROBE_EVERY == 0;
+    wc->query_count++;
+    return 0;
+}
+
+// 准备实况查询：为每个提供方生成各自格式的请求
+static int now_begin(weather_client_t *wc, weather_record_t *rec) {
+    char path[512];
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        weather_endpoint_t *ep = &wc->endpoints[i];
+        ep->in_query = ep->provider->now_path(&wc->city_info, ep->key, path, sizeof(path)) > 0 &&
+                       build_request(ep, path) == 0;
+    }
+    wc->not_found_eps = 0;
+    return query_begin(wc, rec);
+}
+
+// 结束查询：取消落后的尝试，winner为NULL表示失败
+static int query_finish(weather_client_t *wc, http_attempt_t *winner) {
+    int winner_ep = winner != NULL ? wc->attempt_ep[winner - wc->attempts] : -1;
+    double now = http_now_ms();
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        http_attempt_t *a = &wc->attempts[i];
+        if (a != winner && a->fd >= 0) {
+            printf("取消未完成的请求\n");
+            // 被取消的提供方至少要这么久才能回答：比当前成绩还慢时计入，慢的提供方因此排到后面；
+            // 比当前成绩快时这个样本只是下限，不能说明它变快了，不计入
+            weather_endpoint_t *loser = &wc->endpoints[wc->attempt_ep[i]];
+            if (wc->attempt_ep[i] != winner_ep && now - a->start_ms > endpoint_score(loser)) {
+                record_score(loser, now - a->start_ms);
+            }
+        }
+        if (a != winner) {
+            http_attempt_cancel(a);
+        }
+    }
+
+    if (winner == NULL) {
+        // 地址可能已失效，下次重新解析
+        for (int i = 0; i < wc->endpoint_num; i++) {
+            wc->endpoints[i].addr_expire = 0;
+        }
+        wc->body = NULL;
+        return WEATHER_QUERY_FAILED;
+    }
+
+    weather_endpoint_t *ep = &wc->endpoints[winner_ep];
+    double elapsed = now - winner->start_ms;
+    record_latency(wc, elapsed);
+    record_score(ep, elapsed);
+    ep->wins++;
+    printf("请求完成: %s 耗时%.1fms，共%d次尝试，对冲延迟%.0fms\n",
+           ep->provider->name, elapsed, wc->query_started, wc->hedge_delay_ms);
+    // 实况查询已解码到decode_rec，响应缓冲立即还给缓冲池
+    if (wc->decode_rec != NULL) {
+        http_attempt_cancel(winner);
+        wc->body = NULL;
+    }
+    return WEATHER_QUERY_DONE;
+}
+
+// 当前在途尝试需要关注的fd，返回个数
+static int query_pollfds(const weather_client_t *wc, struct pollfd *pfds) {
+    int n = 0;
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        short events = http_attempt_events(&wc->attempts[i]);
+        if (events != 0) {
+            pfds[n].fd = wc->attempts[i].fd;
+            pfds[n].events = events;
+            pfds[n].revents = 0;
+            n++;
+        }
+    }
+    return n;
+}
+
+// 最早可以再发起尝试的时间：到了对冲时间，或最近发起的连接迟迟未建立（连接赛跑）
+static double next_start_ms(const weather_client_t *wc) {
+    double next = wc->next_hedge_ms;
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        if (wc->attempts[i].state == HTTP_CONNECTING) {
+            double stagger = wc->last_start_ms + WEATHER_CONNECT_STAGGER_MS;
+            if (stagger < next) {
+                next = stagger;
+            }
             break;
         }
-        
-        // 扩展响应缓冲区
-        char *new_response = realloc(response, response_size + n + 1);
-        if(new_response == NULL) {
-            free(response);
-            close(fd);
-            return NULL;
-        }
-        
-        response = new_response;
-        memcpy(response + response_size, buffer, n);
-        response_size += n;
-        response[response_size] = '\0';
-        total_read += n;
     }
-    
-    close(fd);
-    
-    if(response == NULL) {
-        printf("没有收到响应\n");
-        return NULL;
+    return next;
+}
+
+// 距下一次定时动作（发起尝试或到达截止时间）的毫秒数
+static int query_timeout_ms(const weather_client_t *wc) {
+    double now = http_now_ms();
+    double wake = wc->query_start_ms + wc->deadline_ms;
+    bool can_start = wc->query_started < WEATHER_ATTEMPT_MAX;
+    if (can_start && next_start_ms(wc) < wake) {
+        wake = next_start_ms(wc);
     }
-    
-    printf("收到响应，总大小: %zu字节\n", response_size);
-    
-    // 查找JSON开始位置（跳过HTTP头）
-    char *json_start = strstr(response, "\r\n\r\n");
-    if(json_start == NULL) {
-        json_start = strstr(response, "\n\n");
+    return wake <= now ? 0 : (int)(wake - now) + 1;
+}
+
+// 连接刚建立：记录该地址的建连耗时，同一提供方其他还在连接中的尝试赛跑落败，取消
+// （不同提供方的尝试是在比谁先给出结果，不在这里取消）
+static void connect_won(weather_client_t *wc, int slot) {
+    http_attempt_t *winner = &wc->attempts[slot];
+    weather_endpoint_t *ep = &wc->endpoints[wc->attempt_ep[slot]];
+    record_connect(ep, winner->addr_index, winner->connect_ms);
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        http_attempt_t *a = &wc->attempts[i];
+        if (a != winner && a->state == HTTP_CONNECTING && wc->attempt_ep[i] == wc->attempt_ep[slot]) {
+            printf("连接赛跑落败，取消连接\n");
+            record_connect(ep, a->addr_index, http_now_ms() - a->start_ms);
+            http_attempt_cancel(a);
+        }
     }
-    
-    if(json_start != NULL) {
-        json_start += 4;  // 跳过 \r\n\r\n
-    } else {
-        json_start = response;
+}
+
+// 把实况响应体解码成天气记录，补全城市信息并检查必需字段，成功返回0
+static int decode_now(weather_client_t *wc, const weather_endpoint_t *ep, const char *body, weather_record_t *rec) {
+    weather_record_init(rec);
+    if (ep->provider->decode_now(body, rec) != 0) {
+        return -1;
     }
-    
-    printf("JSON数据开始位置: %ld\n", json_start - response);
-    
-    // 跳过可能的空白字符
-    while(*json_start && isspace((unsigned char)*json_start)) {
-        json_start++;
+
+    // 按原名查到了内置表之外的城市：记下上游的地点ID，之后用地点ID查询，缓存键也换成地点ID
+    if (!wc->city_info.verified && rec->city_id[0] != '\0') {
+        city_info_t info;
+        city_learn(wc->city_info.query, rec->city_id, rec->city_name);
+        if (city_resolve(wc->city_info.query, &info) == 0 && info.verified && use_city(wc, &info) == 0) {
+            printf("已记下城市 %s 的地点ID: %s\n", info.query, info.id);
+        }
     }
-    
-    // 解析JSON - 使用json_start而不是之前的json变量
-    cJSON *root = cJSON_Parse(json_start);
-    if(root == NULL) {
-        printf("JSON解析失败\n");
-        free(response);
-        return NULL;
+
+    // 规范ID一般不超过15字节（原名查询的长名字会被截断），记录的其余部分已清零
+    memset(rec->city_id, 0, sizeof(rec->city_id));
+    strncpy(rec->city_id, wc->city, sizeof(rec->city_id) - 1);
+    // 有的提供方只返回英文地名，统一用中文名
+    if (rec->city_name[0] == '\0' && wc->city_info.name[0] != '\0') {
+        snprintf(rec->city_name, sizeof(rec->city_name), "%s", wc->city_info.name);
     }
-    
-    cJSON *results = cJSON_GetObjectItem(root, "results");
-    if(!cJSON_IsArray(results) || cJSON_GetArraySize(results) == 0) {
-        printf("没有找到results数组或数组为空\n");
-        cJSON_Delete(root);
-        free(response);
-        return NULL;
+
+    if (rec->text[0] == '\0' || rec->temp_x10 == WEATHER_RECORD_NONE_I16) {
+        printf("%s的响应缺少必需字段: 天气/温度\n", ep->provider->name);
+        return -1;
     }
-    
-    cJSON *city_data = cJSON_GetArrayItem(results, 0);
-    if(city_data == NULL) {
-        printf("city_data为空\n");
-        cJSON_Delete(root);
-        free(response);
+    return 0;
+}
+
+// 是否还有提供方可问
+static bool any_in_query(const weather_client_t *wc) {
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        if (wc->endpoints[i].in_query) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 推进查询：处理pfds中就绪的事件，再按需发起（对冲）尝试、检查截止时间
+// 返回WEATHER_QUERY_PENDING/DONE/FAILED，DONE时实况查询已解码到decode_rec，其他查询wc->body指向响应体
+//
+// 连接赛跑（happy eyeballs）：地址按测得的RTT排序，连接超过WEATHER_CONNECT_STAGGER_MS仍未建立
+// 就并行连接下一个候选，先建立的胜出，同一提供方其余还在连接中的立即取消。
+// 对冲请求：尝试超过p95耗时仍未返回时，再向下一个候选（优先换提供方）发起一个尝试，
+// 谁先返回有效响应就用谁，其余的立即取消；某个尝试提前失败时也马上补发。
+// 并行模式（以及排序模式的定期探测）下，查询一开始就向每个提供方各发一个尝试。
+// 整个过程不超过上下文的截止时间，最多WEATHER_ATTEMPT_MAX次尝试。
+static int query_step(weather_client_t *wc, const struct pollfd *pfds, int n) {
+    for (int i = 0; i < n; i++) {
+        if (pfds[i].revents == 0) {
+            continue;
+        }
+        // 按fd找到对应的尝试（可能已在本轮被取消）
+        int slot = -1;
+        for (int j = 0; j < WEATHER_HEDGE_MAX; j++) {
+            if (wc->attempts[j].fd == pfds[i].fd && http_attempt_events(&wc->attempts[j]) != 0) {
+                slot = j;
+            }
+        }
+        if (slot < 0) {
+            continue;
+        }
+        http_attempt_t *a = &wc->attempts[slot];
+        weather_endpoint_t *ep = &wc->endpoints[wc->attempt_ep[slot]];
+        http_state_t prev = a->state;
+        size_t rx_before = a->rx_bytes;
+        http_state_t state = http_attempt_step(a, pfds[i].revents);
+        wc->rx_bytes += a->rx_bytes - rx_before;
+        if (prev == HTTP_CONNECTING && state == HTTP_FAILED) {
+            record_connect(ep, a->addr_index, WEATHER_RTT_FAIL_MS);
+        } else if (prev == HTTP_CONNECTING) {
+            connect_won(wc, slot);
+        }
+        if (state == HTTP_FAILED) {
+            attempt_failed(wc, slot);
+        }
+        if (state != HTTP_DONE) {
+            continue;
+        }
+
+        int status = 0;
+        printf("收到%s响应，网络%zu字节，解码后%zu字节%s\n", ep->provider->name, a->rx_bytes,
+               a->len - a->header_len, a->gzip ? "（已解压）" : "");
+        wc->body = http_attempt_body(a, &status);
+        if (wc->body != NULL &&
+            (wc->decode_rec == NULL || decode_now(wc, ep, wc->body, wc->decode_rec) == 0)) {
+            return query_finish(wc, a);
+        }
+        a->state = HTTP_FAILED;
+        attempt_failed(wc, slot);
+        // 4xx是确定性的错误（如城市不存在），这个提供方重试也没用
+        if (status >= 400 && status < 500) {
+            if (ep->in_query && status == 404) {
+                wc->not_found_eps++;        // 同一提供方的对冲尝试只算一次
+            }
+            ep->in_query = false;
+            if (!any_in_query(wc)) {
+                // 问到的提供方都明确答复城市不存在才做负缓存，密钥错误、超时等不算
+                if (!wc->city_info.verified && wc->not_found_eps == wc->query_eps) {
+                    printf("上游答复城市不存在: %s\n", wc->city_info.query);
+                    city_reject(wc->city_info.query);
+                }
+                return query_finish(wc, NULL);
+            }
+        }
+    }
+
+    double now = http_now_ms();
+    if (now >= wc->query_start_ms + wc->deadline_ms) {
+        printf("查询超过截止时间 %dms，放弃\n", wc->deadline_ms);
+        return query_finish(wc, NULL);
+    }
+
+    // 没有在途尝试，或到了对冲时间且还有空位，就发起新尝试
+    while (1) {
+        int free_slot = -1;
+        int active = 0;
+        for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+            if (http_attempt_events(&wc->attempts[i]) != 0) {
+                active++;
+            } else if (free_slot < 0) {
+                free_slot = i;
+            }
+        }
+
+        bool can_start = wc->query_started < WEATHER_ATTEMPT_MAX && free_slot >= 0;
+        bool burst = (wc->sched == WEATHER_SCHED_PARALLEL || wc->probing) && wc->query_started < wc->query_eps;
+        if (can_start && (active == 0 || burst || now >= next_start_ms(wc))) {
+            int cand = next_candidate(wc);
+            if (cand >= 0) {
+                start_attempt(wc, free_slot, cand);
+                wc->next_hedge_ms = now + wc->hedge_delay_ms;
+                continue;
+            }
+        }
+        if (active == 0) {
+            return query_finish(wc, NULL);      // 尝试次数或候选用完
+        }
+        return WEATHER_QUERY_PENDING;
+    }
+}
+
+// 阻塞驱动已开始的查询直到完成，返回WEATHER_QUERY_DONE或WEATHER_QUERY_FAILED
+static int query_run(weather_client_t *wc) {
+    int state = query_step(wc, NULL, 0);
+    while (state == WEATHER_QUERY_PENDING) {
+        struct pollfd pfds[WEATHER_HEDGE_MAX];
+        int n = query_pollfds(wc, pfds);
+        int ret = poll(pfds, n, query_timeout_ms(wc));
+        if (ret < 0 && errno != EINTR) {
+            perror("poll失败");
+            return query_finish(wc, NULL);
+        }
+        state = query_step(wc, pfds, ret > 0 ? n : 0);
+    }
+    return state;
+}
+
+// 向指定提供方发送GET请求并阻塞等待完整响应，返回响应体（JSON）起始位置，失败返回NULL
+// 返回的指针指向上下文内的响应缓冲，下次请求前有效。
+static char *http_get(weather_client_t *wc, weather_endpoint_t *target, const char *path) {
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        wc->endpoints[i].in_query = false;
+    }
+    if (build_request(target, path) != 0) {
         return NULL;
     }
-    
-    cJSON *location = cJSON_GetObjectItem(city_data, "location");
-    cJSON *now = cJSON_GetObjectItem(city_data, "now");
-    
-    if(location == NULL || now == NULL) {
-        printf("location或now为空\n");
-        cJSON_Delete(root);
-        free(response);
+    target->in_query = true;
+    if (query_begin(wc, NULL) != 0) {
         return NULL;
     }
-    
-    // 安全地提取天气信息
-    const char *city_name = NULL;
-    const char *weather = NULL;
-    const char *temperature = NULL;
-    const char *humidity = NULL;
-    const char *wind_direction = NULL;
-    const char *wind_speed = NULL;
-    const char *wind_scale = NULL;
-    
-    cJSON *city_name_item = cJSON_GetObjectItem(location, "name");
-    cJSON *weather_item = cJSON_GetObjectItem(now, "text");
-    cJSON *temperature_item = cJSON_GetObjectItem(now, "temperature");
-    cJSON *humidity_item = cJSON_GetObjectItem(now, "humidity");
-    cJSON *wind_direction_item = cJSON_GetObjectItem(now, "wind_direction");
-    cJSON *wind_speed_item = cJSON_GetObjectItem(now, "wind_speed");
-    cJSON *wind_scale_item = cJSON_GetObjectItem(now, "wind_scale");
-    
-    if(city_name_item != NULL && cJSON_IsString(city_name_item)) {
-        city_name = city_name_item->valuestring;
+    return query_run(wc) == WEATHER_QUERY_DONE ? wc->body : NULL;
+}
+
+// 查询天气，use_cache为false时跳过缓存查找，成功返回0
+static int fetch_weather(weather_client_t *wc, weather_record_t *rec, bool use_cache) {
+    if (wc == NULL || rec == NULL) {
+        return -1;
     }
-    
-    if(weather_item != NULL && cJSON_IsString(weather_item)) {
-        weather = weather_item->valuestring;
+
+    printf("查询城市: %s\n", wc->city);
+
+    // 先查共享缓存，命中则不访问网络
+    if (use_cache && weather_cache_get(wc->cache, wc->city, rec)) {
+        printf("命中缓存: %s\n", wc->city);
+        return 0;
     }
-    
-    if(temperature_item != NULL && cJSON_IsString(temperature_item)) {
-        temperature = temperature_item->valuestring;
+
+    if (now_begin(wc, rec) != 0 || query_run(wc) != WEATHER_QUERY_DONE) {
+        return -1;
     }
-    
-    if(humidity_item != NULL) {
-        if(cJSON_IsString(humidity_item)) {
-            humidity = humidity_item->valuestring;
-        } else if(cJSON_IsNumber(humidity_item)) {
-            static char humidity_str[10];
-            snprintf(humidity_str, sizeof(humidity_str), "%d", (int)humidity_item->valuedouble);
-            humidity = humidity_str;
-        }
+    weather_cache_put(wc->cache, wc->city, rec);
+    return 0;
+}
+
+// 开始异步查询当前城市的实况
+int weather_client_begin(weather_client_t *wc, weather_record_t *rec) {
+    if (wc == NULL || rec == NULL) {
+        return WEATHER_QUERY_FAILED;
     }
-    
-    if(wind_direction_item != NULL && cJSON_IsString(wind_direction_item)) {
-        wind_direction = wind_direction_item->valuestring;
+
+    if (weather_cache_get(wc->cache, wc->city, rec)) {
+        printf("命中缓存: %s\n", wc->city);
+        return WEATHER_QUERY_DONE;
     }
-    
-    if(wind_speed_item != NULL && cJSON_IsString(wind_speed_item)) {
-        wind_speed = wind_speed_item->valuestring;
+
+    if (now_begin(wc, rec) != 0) {
+        return WEATHER_QUERY_FAILED;
     }
-    
-    if(wind_scale_item != NULL && cJSON_IsString(wind_scale_item)) {
-        wind_scale = wind_scale_item->valuestring;
+    return weather_client_step(wc, NULL, 0, rec);
+}
+
+int weather_client_pollfds(const weather_client_t *wc, struct pollfd *pfds) {
+    return query_pollfds(wc, pfds);
+}
+
+int weather_client_timeout_ms(const weather_client_t *wc) {
+    return query_timeout_ms(wc);
+}
+
+// 推进异步查询，完成时记录已在收到响应时解码好
+int weather_client_step(weather_client_t *wc, const struct pollfd *pfds, int n, weather_record_t *rec) {
+    int state = query_step(wc, pfds, n);
+    if (state != WEATHER_QUERY_DONE) {
+        return state;
     }
-    
-    // 检查所有必需字段是否都有值
-    if(city_name == NULL || weather == NULL || temperature == NULL) {
-        printf("缺少必需字段: city_name=%p, weather=%p, temperature=%p\n", 
-               city_name, weather, temperature);
-        cJSON_Delete(root);
-        free(response);
-        return NULL;
+    if (rec != wc->decode_rec) {
+        *rec = *wc->decode_rec;
     }
-    
-    // 如果其他字段为空，使用默认值
-    if(humidity == NULL) {
-        humidity = "N/A";
+    weather_cache_put(wc->cache, wc->city, rec);
+    return WEATHER_QUERY_DONE;
+}
+
+// 放弃进行中的异步查询
+void weather_client_cancel(weather_client_t *wc) {
+    if (wc == NULL) {
+        return;
+    }
+    for (int i = 0; i < WEATHER_HEDGE_MAX; i++) {
+        http_attempt_cancel(&wc->attempts[i]);
+    }
+    wc->body = NULL;
+}
+
+// 获取天气记录，成功返回0
+int weather_client_fetch(weather_client_t *wc, weather_record_t *rec) {
+    return fetch_weather(wc, rec, true);
+}
+
+// 跳过缓存直接查询并刷新缓存
+int weather_client_refresh(weather_client_t *wc, weather_record_t *rec) {
+    return fetch_weather(wc, rec, false);
+}
+
+// 预报由第一个支持预报的提供方提供
+static weather_endpoint_t *series_endpoint(weather_client_t *wc) {
+    for (int i = 0; i < wc->endpoint_num; i++) {
+        if (wc->endpoints[i].provider->series) {
+            return &wc->endpoints[i];
+        }
     }
-    if(wind_direction == NULL) {
-        wind_direction = "N/A";
+    printf("没有支持预报的天气提供方\n");
+    return NULL;
+}
+
+// 查询逐日预报写入series
+static int fetch_daily(weather_client_t *wc, int days, weather_series_t *series) {
+    weather_endpoint_t *ep = series_endpoint(wc);
+    if(ep == NULL) {
+        return -1;
     }
-    if(wind_speed == NULL) {
-        wind_speed = "N/A";
+    char path[512];
+    snprintf(path, sizeof(path), "/v3/weather/daily.json?key=%s&location=%s&language=zh-Hans&unit=c&start=0&days=%d",
+             ep->key, wc->location, days);
+
+    char *json = http_get(wc, ep, path);
+    seniverse_daily_t daily;
+    if(json == NULL || seniverse_daily_decode(json, strlen(json), &daily) != 0 || daily.day_num == 0) {
+        printf("逐日预报解析失败\n");
+        return -1;
     }
-    if(wind_scale == NULL) {
-        wind_scale = "N/A";
+
+    int n = 0;
+    for(; n < daily.day_num && n < days && n < SERIES_DAYS_MAX; n++) {
+        const seniverse_daily_day_t *day = &daily.day[n];
+        if(n == 0) {
+            series->day0 = day->date;
+        } else if(day->date != series->day0 + n) {
+            break;      // 日期不连续，后面的丢弃
+        }
+        series->high[n] = day->high;
+        series->low[n] = day->low;
+        series->code_day[n] = day->code_day;
+        series->code_night[n] = day->code_night;
+        series->humidity[n] = day->humidity;
+        series->wind_scale[n] = day->wind_scale;
+        series->rainfall_x10[n] = day->rainfall;
     }
-    
-    printf("提取到的数据: 城市=%s, 天气=%s, 温度=%s, 湿度=%s, 风向=%s, 风速=%s, 风力=%s\n", 
-           city_name, weather, temperature, humidity, wind_direction, wind_speed, wind_scale);
-    
-    // 创建格式化字符串
-    char *weather_str = malloc(400);
-    if (weather_str == NULL) {
-        cJSON_Delete(root);
-        free(response);
-        return NULL;
+    series->day_num = (uint8_t)n;
+    return n > 0 ? 0 : -1;
+}
+
+// 查询逐小时预报写入series
+static int fetch_hourly(weather_client_t *wc, int hours, weather_series_t *series) {
+    weather_endpoint_t *ep = series_endpoint(wc);
+    if(ep == NULL) {
+        return -1;
     }
-    
-    // 格式化输出，包含所有天气信息
-    snprintf(weather_str, 400, 
-             " 城市: %s\n"
-             " 天气: %s\n"
-             " 温度: %s°C\n"
-             " 湿度: %s%%\n"
-             " 风向: %s\n"
-             " 风速: %s\n"
-             " 风力: %s\n",
-             city_name, weather, temperature, humidity, 
-             wind_direction, wind_speed, wind_scale);
-    
-    // 清理
-    cJSON_Delete(root);
-    free(response);
-    
-    return weather_str;
-}
\ No newline at end of file
+    char path[512];
+    snprintf(path, sizeof(path), "/v3/weather/hourly.json?key=%s&location=%s&language=zh-Hans&unit=c&start=0&hours=%d",
+             ep->key, wc->location, hours);
+
+    char *json = http_get(wc, ep, path);
+    seniverse_hourly_t hourly;
+    if(json == NULL || seniverse_hourly_decode(json, strlen(json), &hourly) != 0 || hourly.hour_num == 0) {
+        printf("逐小时预报解析失败\n");
+        return -1;
+    }
+
+    int n = 0;
+    for(; n < hourly.hour_num && n < hours && n < SERIES_HOURS_MAX; n++) {
+        const seniverse_hourly_hour_t *hour = &hourly.hour[n];
+        if(n == 0) {
+            series->hour0 = hour->time;
+        } else if(hour->time != series->hour0 + n) {
+            break;
+        }
+        series->hour_temp[n] = hour->temperature;
+        series->hour_code[n] = hour->code;
+        series->hour_humidity[n] = hour->humidity;
+        series->hour_wind_x10[n] = hour->wind_speed;
+    }
+    series->hour_num = (uint8_t)n;
+    return n > 0 ? 0 : -1;
+}
+
+// 查询逐日和逐小时预报，写入存储
+int weather_client_update_series(weather_client_t *wc, weather_series_store_t *store, int days, int hours) {
+    if(wc == NULL || store == NULL) {
+        return -1;
+    }
+
+    weather_series_t series;
+    memset(&series, 0, sizeof(series));
+    snprintf(series.city, sizeof(series.city), "%s", wc->city);
+
+    // 两类预报都取不到才算失败，只有一类时也保存
+    int daily_ret = days > 0 ? fetch_daily(wc, days, &series) : -1;
+    int hourly_ret = hours > 0 ? fetch_hourly(wc, hours, &series) : -1;
+    if(daily_ret != 0 && hourly_ret != 0) {
+        return -1;
+    }
+
+    weather_series_store_put(store, &series);
+    printf("已更新 %s 的预报: %d天, %d小时\n", series.city, series.day_num, series.hour_num);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#ifndef _FORECAST_H
+#define _FORECAST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <poll.h>
+#include <netinet/in.h>
+
+#include "weather_cache.h"
+#include "weather_series.h"
+#include "weather_http.h"
+#include "city_resolver.h"
+#include "weather_provider.h"
+
+#define WEATHER_CITY_LEN      64
+#define WEATHER_REQUEST_LEN   1024
+#define WEATHER_ADDR_TTL      300     // 解析出的服务器地址复用时间（秒）
+#define WEATHER_HOST_LEN      128
+#define WEATHER_DEFAULT_HOST  "api.seniverse.com"
+#define WEATHER_DEFAULT_PORT  80
+#define WEATHER_ADDR_MAX      8       // 最多保存的解析地址数（IPv4和IPv6）
+#define WEATHER_CONNECT_STAGGER_MS 250  // 连接仍未建立时，隔多久向下一个地址再发起连接
+#define WEATHER_RTT_UNKNOWN_MS 200    // 没有测量过的地址按此RTT排序
+#define WEATHER_RTT_FAIL_MS   2000    // 连接失败的地址按此值计入RTT，后续排到后面
+
+#define WEATHER_DEADLINE_MS   5000    // 单次查询默认截止时间
+#define WEATHER_HEDGE_MAX     3       // 同时在途的尝试数（连接赛跑+对冲请求）
+#define WEATHER_ATTEMPT_MAX   4       // 单次查询最多尝试次数
+#define WEATHER_HEDGE_DEFAULT_MS 300  // 耗时样本不足时的对冲延迟
+#define WEATHER_HEDGE_MIN_MS  20      // 对冲延迟下限
+#define WEATHER_LATENCY_SAMPLES 64    // 用于估计p95的最近耗时样本数
+#define WEATHER_LATENCY_MIN_SAMPLES 8
+
+#define WEATHER_PROVIDER_MAX  4       // 最多同时配置的提供方数
+#define WEATHER_SCORE_UNKNOWN_MS 500  // 还没有成绩的提供方按此耗时排序
+#define WEATHER_SCORE_FAIL_MS 3000    // 失败（连接/状态码/解码）按此耗时计入成绩
+#define WEATHER_PROBE_EVERY   16      // 排序模式下每隔这么多次查询并行问一次所有提供方，刷新落后者的成绩
+
+// 异步查询状态
+#define WEATHER_QUERY_FAILED  -1
+#define WEATHER_QUERY_PENDING 0
+#define WEATHER_QUERY_DONE    1
+
+// 多提供方调度方式
+typedef enum {
+    WEATHER_SCHED_RANKED,       // 按成绩排序，先问最快的，超过对冲延迟或失败再问下一个
+    WEATHER_SCHED_PARALLEL      // 同时问所有提供方（最多WEATHER_HEDGE_MAX个），用最先到的有效结果
+} weather_sched_t;
+
+// 一个提供方的服务器和统计
+typedef struct {
+    const weather_provider_t *provider;
+    char host[WEATHER_HOST_LEN];
+    int port;
+    char key[WEATHER_KEY_LEN];            // API密钥
+
+    struct sockaddr_storage addrs[WEATHER_ADDR_MAX];  // 已解析的服务器地址（IPv4/IPv6交替排列）
+    socklen_t addr_lens[WEATHER_ADDR_MAX];
+    double addr_rtt_ms[WEATHER_ADDR_MAX]; // 各地址平滑后的建连耗时，0表示未测量
+    int addr_order[WEATHER_ADDR_MAX];     // 本次查询的地址尝试顺序（按RTT从小到大）
+    int addr_num;
+    time_t addr_expire;                   // 地址过期时间（单调时钟），0表示未解析
+
+    char request[WEATHER_REQUEST_LEN];    // 本次查询发给该提供方的HTTP请求
+    size_t req_len;
+    bool in_query;                        // 本次查询是否还在问这个提供方
+
+    double score_ms;                      // 平滑后的查询耗时（新样本占1/4），0表示还没有成绩
+    unsigned long wins;                   // 给出最终结果的次数
+    unsigned long failures;               // 失败次数
+} weather_endpoint_t;
+
+// 天气查询上下文
+// 每个线程/事件循环任务各持有一个，城市、收发缓冲、服务器地址都在上下文内，
+// 不再有全局可变状态，多个上下文可并发查询；结果缓存可以在多个上下文间共享。
+// 实况可以同时配置多个提供方（见weather_provider.h），按各自成绩排序或并行询问，取最先到的有效结果。
+typedef struct weather_client {
+    char city[WEATHER_CITY_LEN];          // 当前查询城市（规范地点ID，也是缓存键）
+    char location[WEATHER_CITY_LEN * 3];  // 百分号编码后的location参数
+    city_info_t city_info;                // 当前城市的解析结果（内置表之外的城市学到地点ID后会更新）
+
+    // 提供方，第一个是主提供方；默认只有心知天气，
+    // 环境变量WEATHER_PROVIDERS（格式同weather_client_set_providers）和WEATHER_PROVIDER_MODE可覆盖
+    weather_endpoint_t endpoints[WEATHER_PROVIDER_MAX];
+    int endpoint_num;
+    weather_sched_t sched;
+
+    // 本次查询的候选（提供方，地址）顺序：先按提供方成绩，同一轮内每个提供方取一个地址
+    uint8_t cand_ep[WEATHER_PROVIDER_MAX * WEATHER_ADDR_MAX];
+    uint8_t cand_addr[WEATHER_PROVIDER_MAX * WEATHER_ADDR_MAX];
+    int cand_num;
+    int cand_pos;
+    int query_eps;                        // 本次查询涉及的提供方数
+    unsigned long query_count;            // 已开始的查询数
+    bool probing;                         // 本次查询是否并行探测所有提供方
+
+    http_attempt_t attempts[WEATHER_HEDGE_MAX];  // 在途尝试，响应缓冲跨查询复用
+    int attempt_ep[WEATHER_HEDGE_MAX];    // 各尝试所问的提供方
+    int deadline_ms;                      // 单次查询截止时间
+    uint16_t latency_ms[WEATHER_LATENCY_SAMPLES];  // 最近成功请求耗时，估计对冲延迟
+    int latency_num;
+    int latency_pos;
+
+    // 进行中的查询（阻塞查询和事件循环驱动的异步查询共用）
+    size_t req_len;
+    double query_start_ms;
+    double hedge_delay_ms;                // 本次查询的对冲延迟
+    double next_hedge_ms;                 // 下一次可以发起对冲尝试的时间
+    double last_start_ms;                 // 最近一次发起尝试的时间
+    int query_started;                    // 已发起的尝试数
+    char *body;                           // 完成后的响应体（指向尝试的响应缓冲）
+    weather_record_t *decode_rec;         // 实况查询：在收到响应时就解码，解码失败的响应不算数
+    int not_found_eps;                    // 本次查询答复"城市不存在"（404）的提供方数
+    unsigned long long rx_bytes;          // 累计从网络收到的字节数（压缩前），供统计用
+
+    weather_cache_t *cache;               // 结果缓存句柄（不归上下文所有，可为NULL）
+} weather_client_t;
+
+// 创建查询上下文，cache可为NULL表示不使用缓存
+weather_client_t *weather_client_create(const char *city, weather_cache_t *cache);
+
+// 销毁查询上下文（不会销毁共享的缓存）
+void weather_client_destroy(weather_client_t *wc);
+
+// 设置主提供方的服务器地址（如指向本地替身服务器）
+void weather_client_set_server(weather_client_t *wc, const char *host, int port);
+
+// 设置提供方列表，逗号分隔，每项为 名字[=主机[:端口]]，如"seniverse,wttr=127.0.0.1:8081"
+// 未知或缺少密钥的提供方跳过，至少有一个可用时返回0并替换原列表，否则返回-1且原列表不变
+int weather_client_set_providers(weather_client_t *wc, const char *spec);
+
+// 设置多提供方调度方式
+void weather_client_set_schedule(weather_client_t *wc, weather_sched_t sched);
+
+// 设置单次查询的截止时间（毫秒），包括所有重试和对冲请求
+void weather_client_set_deadline(weather_client_t *wc, int deadline_ms);
+
+// 设置当前城市（中文名、拼音、别名均可，内置表之外的城市交给上游判断），
+// 成功返回0，名字无效或上游确认过不存在返回-1且当前城市不变
+int weather_client_set_city(weather_client_t *wc, const char *city);
+
+// 获取当前城市
+const char *weather_client_get_city(const weather_client_t *wc);
+
+// 获取当前城市的天气记录，成功返回0（要显示时用weather_record_format()渲染）
+int weather_client_fetch(weather_client_t *wc, weather_record_t *rec);
+
+// 跳过缓存直接查询上游并刷新缓存（供后台预取使用），返回值同上
+int weather_client_refresh(weather_client_t *wc, weather_record_t *rec);
+
+// 异步查询（供事件循环使用，每个上下文同一时间只有一个查询）：
+//   weather_client_begin() 开始查询当前城市，命中缓存直接返回DONE；
+//   之后把weather_client_pollfds()给出的fd注册到事件循环，等待时间不超过weather_client_timeout_ms()；
+//   有事件就绪或定时到期时调用weather_client_step()，直到返回DONE（rec有效）或FAILED。
+int weather_client_begin(weather_client_t *wc, weather_record_t *rec);
+
+// 当前需要关注的fd和事件（最多WEATHER_HEDGE_MAX个），返回个数；fd会随重试/对冲变化
+int weather_client_pollfds(const weather_client_t *wc, struct pollfd *pfds);
+
+// 距下一次定时动作（发起对冲或到达截止时间）的毫秒数
+int weather_client_timeout_ms(const weather_client_t *wc);
+
+// 处理就绪事件（pfds中revents非0的项，可为NULL表示只检查定时），返回WEATHER_QUERY_*
+int weather_client_step(weather_client_t *wc, const struct pollfd *pfds, int n, weather_record_t *rec);
+
+// 放弃进行中的异步查询
+void weather_client_cancel(weather_client_t *wc);
+
+// 查询逐日(days天)和逐小时(hours小时)预报并写入store，成功返回0
+int weather_client_update_series(weather_client_t *wc, weather_series_store_t *store, int days, int hours);
+
+#endif
@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""根据JSON schema生成单遍解码器（C代码）
+
+用法: python3 gen_decoder.py weather_schema.json
+在schema所在目录生成 <output>.h 和 <output>.c，运行时是json_scan.h。
+
+schema格式：
+{
+  "output": "weather_decode",               生成的文件名
+  "includes": ["weather_series.h"],         生成的.c额外包含的头文件
+  "converters": {                           字符串字段的自定义换算，如日期
+    "day": {"c_type": "int32_t", "func": "weather_series_parse_day", "none": "-1"}
+  },
+  "messages": [{
+    "name": "seniverse_now",                生成 seniverse_now_t 和 seniverse_now_decode()
+    "comment": "...",
+    "fields": [
+      {"name": "text", "path": "results[0].now.text", "type": "text", "len": 24},
+      {"name": "day", "path": "results[0].daily[]", "max": 15, "fields": [...]}
+    ]
+  }]
+}
+
+path用"."分隔对象的键，"[n]"取数组的第n个元素，"[]"表示逐个元素解码成结构体数组
+（此时字段需要max和fields，fields中的path相对于数组元素）。
+相同前缀的路径合并成一棵树，每个对象/数组节点生成一个函数，键按长度switch后memcmp比较，
+schema中没有的键整体跳过。
+"""
+
+import json
+import os
+import re
+import sys
+
+# 内置类型：C类型、缺失值、读取表达式
+BUILTIN_TYPES = {
+    "i8":      ("int8_t",   "JSON_NONE_I8",  "json_read_i8(js)"),
+    "u8":      ("uint8_t",  "JSON_NONE_U8",  "json_read_u8(js)"),
+    "u16":     ("uint16_t", "JSON_NONE_U16", "json_read_u16(js)"),
+    "u16_x10": ("uint16_t", "JSON_NONE_U16", "json_read_u16_x10(js)"),
+    "i16_x10": ("int16_t",  "JSON_NONE_I16", "json_read_i16_x10(js)"),
+    "u32":     ("uint32_t", "0",             "json_read_u32(js)"),
+    "int":     ("int32_t",  "JSON_NONE_INT", "json_read_int(js)"),
+}
+
+TYPE_COMMENTS = {
+    "i8": "缺失为JSON_NONE_I8",
+    "u8": "缺失为JSON_NONE_U8",
+    "u16": "缺失为JSON_NONE_U16",
+    "u16_x10": "x10，缺失为JSON_NONE_U16",
+    "i16_x10": "x10，缺失为JSON_NONE_I16",
+    "u32": "缺失为0",
+    "int": "缺失为JSON_NONE_INT",
+    "text": "缺失为空串",
+}
+
+CONVERTER_TEXT_LEN = 64
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Node:
+    """路径树节点：object（按键）、index（按下标）、each（逐个元素）、leaf（字段）"""
+
+    def __init__(self, kind, fname):
+        self.kind = kind
+        self.fname = fname          # 生成的函数名
+        self.children = {}          # 键或下标 -> Node
+        self.field = None           # leaf: 字段定义
+        self.array = None           # each: 数组字段定义
+        self.elem = None            # each: 元素根节点
+        self.elem_struct = None     # each: 元素结构体名
+
+
+def split_path(path):
+    """'results[0].now.text' -> [('key','results'), ('index',0), ('key','now'), ('key','text')]"""
+    steps = []
+    for part in path.split("."):
+        m = re.fullmatch(r"([^\[\]]*)((?:\[\d*\])*)", part)
+        if m is None:
+            raise SchemaError("无法解析路径: " + path)
+        if m.group(1):
+            steps.append(("key", m.group(1)))
+        for idx in re.findall(r"\[(\d*)\]", m.group(2)):
+            steps.append(("each", None) if idx == "" else ("index", int(idx)))
+    return steps
+
+
+def c_ident(text):
+    return re.sub(r"[^0-9A-Za-z_]", "_", text)
+
+
+class Generator:
+    def __init__(self, schema):
+        self.schema = schema
+        self.converters = schema.get("converters", {})
+        self.structs = []       # (name, comment, fields)，按依赖顺序
+        self.funcs = []         # 生成的函数体（按调用顺序倒序输出，保证先定义后使用）
+
+    def field_type(self, f):
+        t = f.get("type")
+        if t == "text":
+            if "len" not in f:
+                raise SchemaError("text字段需要len: " + f["name"])
+            return "char", "", None
+        if t in BUILTIN_TYPES:
+            return BUILTIN_TYPES[t][0], BUILTIN_TYPES[t][1], BUILTIN_TYPES[t][2]
+        if t in self.converters:
+            conv = self.converters[t]
+            return conv["c_type"], conv["none"], None
+        raise SchemaError("未知类型: %s (%s)" % (t, f["name"]))
+
+    # ---------------- 建树 ----------------
+
+    def build(self, prefix, fields, struct_name, comment):
+        root = Node("object", prefix + "_root")
+        for f in fields:
+            steps = split_path(f["path"])
+            if not steps:
+                raise SchemaError("空路径: " + f["name"])
+            node, name = root, prefix
+            for i, (kind, value) in enumerate(steps):
+                last = i == len(steps) - 1
+                if node.kind == "leaf":
+                    raise SchemaError("路径与字段冲突: " + f["path"])
+                if kind == "each":
+                    if not last or "fields" not in f:
+                        raise SchemaError("[]只能出现在数组字段路径末尾: " + f["path"])
+                    if node.kind != "object" or node.children:
+                        raise SchemaError("路径冲突: " + f["path"])
+                    node.kind, node.array = "each", f
+                    node.elem_struct = "%s_%s_t" % (prefix, f["name"])
+                    node.elem = self.build("%s_%s" % (prefix, f["name"]), f["fields"],
+                                           node.elem_struct, f.get("comment", ""))
+                    break
+                want = "object" if kind == "key" else "index"
+                if node.kind != want:
+                    if node.children or node.kind == "each":
+                        raise SchemaError("路径冲突: " + f["path"])
+                    node.kind = want
+                name += "_" + (c_ident(value) if kind == "key" else str(value))
+                child = node.children.get(value)
+                if child is None:
+                    child = Node("object", name)
+                    node.children[value] = child
+                if last:
+                    if child.children:
+                        raise SchemaError("路径冲突: " + f["path"])
+                    child.kind, child.field = "leaf", f
+                node = child
+        self.structs.append((struct_name, comment, fields))
+        return root
+
+    # ---------------- 生成代码 ----------------
+
+    def read_stmt(self, f, indent):
+        pad = " " * indent
+        t = f["type"]
+        if t == "text":
+            return [pad + "json_read_text(js, out->%s, sizeof(out->%s));" % (f["name"], f["name"])]
+        if t in BUILTIN_TYPES:
+            return [pad + "out->%s = %s;" % (f["name"], BUILTIN_TYPES[t][2])]
+        conv = self.converters[t]
+        return [pad + "if (json_read_text(js, text, sizeof(text))) {",
+                pad + "    out->%s = %s(text);" % (f["name"], conv["func"]),
+                pad + "}"]
+
+    def node_call(self, node, struct, indent):
+        pad = " " * indent
+        if node.kind == "leaf":
+            return self.read_stmt(node.field, indent)
+        self.gen_node(node, struct)
+        return [pad + "%s(js, out);" % node.fname]
+
+    def gen_node(self, node, struct):
+        lines = ["static void %s(json_scan_t *js, %s *out) {" % (node.fname, struct)]
+        if node.kind == "object":
+            needs_text = any(c.kind == "leaf" and c.field["type"] in self.converters
+                             for c in node.children.values())
+            lines += ["    if (!json_object_begin(js)) {", "        return;", "    }"]
+            if needs_text:
+                lines.append("    char text[%d];" % CONVERTER_TEXT_LEN)
+            lines += ["    const char *key;", "    size_t key_len;",
+                      "    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {",
+                      "        switch (key_len) {"]
+            by_len = {}
+            for key, child in node.children.items():
+                by_len.setdefault(len(key.encode("utf-8")), []).append((key, child))
+            for klen in sorted(by_len):
+                lines.append("            case %d:" % klen)
+                for key, child in by_len[klen]:
+                    lines.append('                if (memcmp(key, "%s", %d) == 0) {' % (key, klen))
+                    lines += self.node_call(child, struct, 20)
+                    lines.append("                    continue;")
+                    lines.append("                }")
+                lines.append("                break;")
+            lines += ["        }", "        json_skip(js);", "    }"]
+        elif node.kind == "index":
+            lines += ["    if (!json_array_begin(js)) {", "        return;", "    }",
+                      "    int index = 0;",
+                      "    for (bool first = true; json_array_next(js, &first); index++) {"]
+            for idx in sorted(node.children):
+                lines.append("        if (index == %d) {" % idx)
+                lines += self.node_call(node.children[idx], struct, 12)
+                lines.append("            continue;")
+                lines.append("        }")
+            lines += ["        json_skip(js);", "    }"]
+        else:   # each
+            f = node.array
+            elem_prefix = node.elem_struct[:-2]
+            self.gen_node(node.elem, node.elem_struct)
+            lines += ["    if (!json_array_begin(js)) {", "        return;", "    }",
+                      "    for (bool first = true; json_array_next(js, &first); ) {",
+                      "        if (out->%s_num >= %d) {" % (f["name"], f["max"]),
+                      "            json_skip(js);",
+                      "            continue;",
+                      "        }",
+                      "        %s *elem = &out->%s[out->%s_num++];" % (node.elem_struct, f["name"], f["name"]),
+                      "        %s_init(elem);" % elem_prefix,
+                      "        %s(js, elem);" % node.elem.fname,
+                      "    }"]
+        lines.append("}")
+        self.funcs.append("\n".join(lines))
+
+    def gen_init(self, prefix, struct, fields, static):
+        lines = ["%svoid %s_init(%s *out) {" % ("static " if static else "", prefix, struct),
+                 "    memset(out, 0, sizeof(*out));"]
+        for f in fields:
+            if "fields" in f or f["type"] == "text":
+                continue
+            _, none, _ = self.field_type(f)
+            if none != "0":
+                lines.append("    out->%s = %s;" % (f["name"], none))
+        lines.append("}")
+        return "\n".join(lines)
+
+    def struct_def(self, name, comment, fields):
+        lines = []
+        if comment:
+            lines.append("// " + comment)
+        lines.append("typedef struct {")
+        for f in fields:
+            if "fields" in f:
+                lines.append("    uint8_t %s_num;" % f["name"])
+                decl = "%s_%s_t %s[%d];" % (name[:-2], f["name"], f["name"], f["max"])
+                note = f["path"]
+            else:
+                c_type, _, _ = self.field_type(f)
+                if f["type"] == "text":
+                    decl = "char %s[%d];" % (f["name"], f["len"])
+                else:
+                    decl = "%s %s;" % (c_type, f["name"])
+                note = f["path"]
+                extra = TYPE_COMMENTS.get(f["type"])
+                if extra is None:
+                    extra = "缺失为" + self.converters[f["type"]]["none"]
+                note += "，" + extra
+            lines.append("    %-28s // %s" % (decl, note))
+        lines.append("} %s;" % name)
+        return "\n".join(lines)
+
+    def generate(self, schema_name):
+        out = self.schema["output"]
+        guard = "_" + out.upper() + "_H"
+        header = ["// 由gen_decoder.py根据%s生成，请勿手工修改" % schema_name,
+                  "#ifndef " + guard, "#define " + guard, "",
+                  "#include <stddef.h>", "#include <stdint.h>", "",
+                  '#include "json_scan.h"', ""]
+        source = ["// 由gen_decoder.py根据%s生成，请勿手工修改" % schema_name,
+                  "#include <string.h>", "", '#include "%s.h"' % out]
+        source += ['#include "%s"' % inc for inc in self.schema.get("includes", [])]
+        source.append("")
+
+        for msg in self.schema["messages"]:
+            self.structs = []
+            self.funcs = []
+            name = msg["name"]
+            struct = name + "_t"
+            root = self.build(name, msg["fields"], struct, msg.get("comment", ""))
+            for s_name, s_comment, s_fields in self.structs:
+                header.append(self.struct_def(s_name, s_comment, s_fields))
+                header.append("")
+            header.append("// 解码%s，缺失的字段取缺失值，返回0；JSON格式错误返回-1" % name)
+            header.append("int %s_decode(const char *json, size_t len, %s *out);" % (name, struct))
+            header.append("")
+
+            self.gen_node(root, struct)
+            source.append("// ---------------- %s ----------------" % name)
+            source.append("")
+            for s_name, _, s_fields in self.structs:
+                source.append(self.gen_init(s_name[:-2], s_name, s_fields, True))
+                source.append("")
+            for func in self.funcs:
+                source.append(func)
+                source.append("")
+            source += ["int %s_decode(const char *json, size_t len, %s *out) {" % (name, struct),
+                       "    json_scan_t js;",
+                       "    json_scan_init(&js, json, len);",
+                       "    %s_init(out);" % name,
+                       "    %s(&js, out);" % root.fname,
+                       "    return js.error ? -1 : 0;",
+                       "}", ""]
+
+        header.append("#endif")
+        return "\n".join(header) + "\n", "\n".join(source).rstrip("\n") + "\n"
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("用法: %s <schema.json>" % sys.argv[0], file=sys.stderr)
+        return 1
+    schema_path = sys.argv[1]
+    with open(schema_path, encoding="utf-8") as fp:
+        schema = json.load(fp)
+    try:
+        header, source = Generator(schema).generate(os.path.basename(schema_path))
+    except SchemaError as e:
+        print("schema错误: %s" % e, file=sys.stderr)
+        return 1
+
+    out_dir = os.path.dirname(os.path.abspath(schema_path))
+    base = os.path.join(out_dir, schema["output"])
+    for path, text in ((base + ".h", header), (base + ".c", source)):
+        with open(path, "w", encoding="utf-8") as fp:
+            fp.write(text)
+        print("已生成 " + path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
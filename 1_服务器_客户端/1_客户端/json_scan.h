@@ -0,0 +1,440 @@
+#ifndef _JSON_SCAN_H
+#define _JSON_SCAN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// 单遍JSON扫描器，供gen_decoder.py生成的解码器使用
+// 解码器在原始文本上顺序前进，只读取schema中声明的字段，其余的值整体跳过：
+// 不建立cJSON树、不分配内存，字段直接写进定长结构体。
+// 扫描器只做解码所需的最少检查，出错后把位置移到末尾，之后的读取都立即返回。
+// 与weather_record.h一样，网关直接包含本头文件，所以这里只放类型和内联函数。
+
+// 字段缺失、类型不对或越界时的取值（与weather_record.h、weather_series.h中的NONE值一致）
+#define JSON_NONE_I8    INT8_MIN
+#define JSON_NONE_U8    0xff
+#define JSON_NONE_U16   0xffff
+#define JSON_NONE_I16   INT16_MIN
+#define JSON_NONE_INT   INT32_MIN
+
+typedef struct {
+    const char *p;      // 当前位置
+    const char *end;
+    bool error;         // 遇到格式错误
+} json_scan_t;
+
+static inline void json_scan_init(json_scan_t *js, const char *text, size_t len) {
+    js->p = text;
+    js->end = text + len;
+    js->error = false;
+}
+
+static inline bool json_fail(json_scan_t *js) {
+    js->error = true;
+    js->p = js->end;
+    return false;
+}
+
+// 跳过空白，返回当前字符，到末尾返回'\0'
+static inline char json_peek(json_scan_t *js) {
+    while (js->p < js->end && (*js->p == ' ' || *js->p == '\n' || *js->p == '\r' || *js->p == '\t')) {
+        js->p++;
+    }
+    return js->p < js->end ? *js->p : '\0';
+}
+
+// 读一个字符串的原始内容（不处理转义），s指向引号之后
+static inline bool json_string_raw(json_scan_t *js, const char **s, size_t *len) {
+    if (json_peek(js) != '"') {
+        return json_fail(js);
+    }
+    const char *start = ++js->p;
+    while (js->p < js->end) {
+        const char *quote = memchr(js->p, '"', js->end - js->p);
+        if (quote == NULL) {
+            break;
+        }
+        // 前面有奇数个反斜杠的引号是转义的
+        const char *b = quote;
+        while (b > start && b[-1] == '\\') {
+            b--;
+        }
+        js->p = quote + 1;
+        if (((quote - b) & 1) == 0) {
+            *s = start;
+            *len = quote - start;
+            return true;
+        }
+    }
+    return json_fail(js);
+}
+
+// 跳过当前的值（任意类型，嵌套的对象和数组整体跳过）
+static inline void json_skip(json_scan_t *js) {
+    const char *s;
+    size_t n;
+    char c = json_peek(js);
+
+    if (c == '"') {
+        json_string_raw(js, &s, &n);
+        return;
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (js->p < js->end) {
+            c = *js->p;
+            if (c == '"') {
+                if (!json_string_raw(js, &s, &n)) {
+                    return;
+                }
+                continue;
+            }
+            js->p++;
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return;
+            }
+        }
+        json_fail(js);
+        return;
+    }
+
+    // 数字、true、false、null
+    const char *start = js->p;
+    while (js->p < js->end && *js->p != ',' && *js->p != '}' && *js->p != ']' &&
+           *js->p != ' ' && *js->p != '\n' && *js->p != '\r' && *js->p != '\t') {
+        js->p++;
+    }
+    if (js->p == start) {
+        json_fail(js);
+    }
+}
+
+// 进入对象，当前值不是对象时跳过它并返回false
+static inline bool json_object_begin(json_scan_t *js) {
+    if (json_peek(js) != '{') {
+        json_skip(js);
+        return false;
+    }
+    js->p++;
+    return true;
+}
+
+// 取对象的下一个键（first在进入对象时置true），之后调用者必须读取或跳过对应的值；
+// 对象结束或出错返回false
+static inline bool json_object_next(json_scan_t *js, bool *first, const char **key, size_t *key_len) {
+    char c = json_peek(js);
+    if (c == '}') {
+        js->p++;
+        return false;
+    }
+    if (!*first) {
+        if (c != ',') {
+            return json_fail(js);
+        }
+        js->p++;
+    }
+    *first = false;
+    if (!json_string_raw(js, key, key_len)) {
+        return false;
+    }
+    if (json_peek(js) != ':') {
+        return json_fail(js);
+    }
+    js->p++;
+    return true;
+}
+
+// 进入数组，当前值不是数组时跳过它并返回false
+static inline bool json_array_begin(json_scan_t *js) {
+    if (json_peek(js) != '[') {
+        json_skip(js);
+        return false;
+    }
+    js->p++;
+    return true;
+}
+
+// 数组还有下一个元素时返回true，之后调用者必须读取或跳过这个元素
+static inline bool json_array_next(json_scan_t *js, bool *first) {
+    char c = json_peek(js);
+    if (c == ']') {
+        js->p++;
+        return false;
+    }
+    if (!*first) {
+        if (c != ',') {
+            return json_fail(js);
+        }
+        js->p++;
+    }
+    *first = false;
+    if (json_peek(js) == '\0') {
+        return json_fail(js);
+    }
+    return true;
+}
+
+// 解析一段数字文本：整数和定点小数直接换算，其他形式（指数、超长）交给strtod
+static inline bool json_parse_number(const char *s, size_t n, double *out) {
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                   1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    const char *p = s, *end = s + n;
+    bool neg = p < end && *p == '-';
+    p += neg;
+
+    uint64_t mant = 0;
+    int digits = 0, frac = -1;
+    for (; p < end; p++) {
+        if (*p >= '0' && *p <= '9') {
+            mant = mant * 10 + (*p - '0');
+            digits++;
+            frac += frac >= 0;
+        } else if (*p == '.' && frac < 0) {
+            frac = 0;
+        } else {
+            break;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    if (p == end && digits <= 15) {
+        double v = frac > 0 ? (double)mant / pow10[frac] : (double)mant;
+        *out = neg ? -v : v;
+        return true;
+    }
+
+    char buf[64];
+    if (n >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+    char *num_end;
+    *out = strtod(buf, &num_end);
+    return num_end != buf;
+}
+
+// 读数值：JSON数字，或内容是数字的字符串（心知天气等上游以字符串表示数字）；
+// 其他类型和空字符串跳过并返回false
+static inline bool json_read_number(json_scan_t *js, double *out) {
+    const char *s;
+    size_t n;
+    char c = json_peek(js);
+    if (c == '"') {
+        if (!json_string_raw(js, &s, &n)) {
+            return false;
+        }
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        s = js->p;
+        json_skip(js);
+        n = js->p - s;
+    } else {
+        json_skip(js);
+        return false;
+    }
+    return json_parse_number(s, n, out);
+}
+
+// 四舍五入（远离0）
+static inline double json_round(double v) {
+    return v < 0 ? v - 0.5 : v + 0.5;
+}
+
+static inline int8_t json_read_i8(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v < -127 || v > 127) {
+        return JSON_NONE_I8;
+    }
+    return (int8_t)json_round(v);
+}
+
+static inline uint8_t json_read_u8(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v < 0 || v >= JSON_NONE_U8) {
+        return JSON_NONE_U8;
+    }
+    return (uint8_t)(v + 0.5);
+}
+
+// 整数部分（如风向角度）
+static inline uint16_t json_read_u16(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v < 0 || v >= JSON_NONE_U16) {
+        return JSON_NONE_U16;
+    }
+    return (uint16_t)v;
+}
+
+// 数值放大10倍后存为uint16（0.1精度）
+static inline uint16_t json_read_u16_x10(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v < 0 || v * 10 >= JSON_NONE_U16) {
+        return JSON_NONE_U16;
+    }
+    return (uint16_t)(v * 10 + 0.5);
+}
+
+// 数值放大10倍后存为int16（如0.1°C精度的温度）
+static inline int16_t json_read_i16_x10(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v * 10 <= JSON_NONE_I16 || v * 10 > INT16_MAX) {
+        return JSON_NONE_I16;
+    }
+    return (int16_t)json_round(v * 10);
+}
+
+// 正的整数（如Unix时间戳），缺失返回0
+static inline uint32_t json_read_u32(json_scan_t *js) {
+    double v;
+    if (!json_read_number(js, &v) || v <= 0 || v > UINT32_MAX) {
+        return 0;
+    }
+    return (uint32_t)v;
+}
+
+// 整数，只接受JSON数字（与cJSON_IsNumber后取valueint一致，小数部分截掉）
+static inline int32_t json_read_int(json_scan_t *js) {
+    char c = json_peek(js);
+    double v;
+    if (c != '-' && (c < '0' || c > '9')) {
+        json_skip(js);
+        return JSON_NONE_INT;
+    }
+    if (!json_read_number(js, &v)) {
+        return JSON_NONE_INT;
+    }
+    if (v >= INT32_MAX) {
+        return INT32_MAX;
+    }
+    return v <= JSON_NONE_INT ? JSON_NONE_INT + 1 : (int32_t)v;
+}
+
+// 写入一个Unicode码点的UTF-8编码，返回字节数
+static inline size_t json_utf8_encode(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xc0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xe0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+static inline int json_hex4(const char *s) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        int d = c >= '0' && c <= '9' ? c - '0' :
+                c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (d < 0) {
+            return -1;
+        }
+        v = v * 16 + d;
+    }
+    return v;
+}
+
+// 读字符串值，处理转义后拷贝到out；超长时在UTF-8字符边界截断。
+// 值不是字符串时跳过并返回false，out保持不变
+static inline bool json_read_text(json_scan_t *js, char *out, size_t out_len) {
+    const char *s;
+    size_t n;
+    if (json_peek(js) != '"') {
+        json_skip(js);
+        return false;
+    }
+    if (!json_string_raw(js, &s, &n) || out_len == 0) {
+        return false;
+    }
+
+    size_t len = 0, cap = out_len - 1;
+    const char *end = s + n;
+    while (s < end && len < cap) {
+        const char *bs = memchr(s, '\\', end - s);
+        size_t plain = (bs != NULL ? bs : end) - s;
+        if (plain > cap - len) {
+            plain = cap - len;
+        }
+        memcpy(out + len, s, plain);
+        len += plain;
+        s += plain;
+        if (s >= end || *s != '\\' || len >= cap) {
+            continue;
+        }
+
+        char esc = s + 1 < end ? s[1] : '\0';
+        char utf8[4];
+        size_t ulen = 1;
+        s += 2;
+        switch (esc) {
+            case 'b': utf8[0] = '\b'; break;
+            case 'f': utf8[0] = '\f'; break;
+            case 'n': utf8[0] = '\n'; break;
+            case 'r': utf8[0] = '\r'; break;
+            case 't': utf8[0] = '\t'; break;
+            case 'u': {
+                int cp = end - s >= 4 ? json_hex4(s) : -1;
+                if (cp < 0) {
+                    out[len] = '\0';
+                    return json_fail(js);
+                }
+                s += 4;
+                // 代理对
+                if (cp >= 0xd800 && cp < 0xdc00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                    int lo = json_hex4(s + 2);
+                    if (lo >= 0xdc00 && lo < 0xe000) {
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                        s += 6;
+                    }
+                }
+                ulen = json_utf8_encode((uint32_t)cp, utf8);
+                break;
+            }
+            default: utf8[0] = esc; break;     // \" \\ \/
+        }
+        if (ulen > cap - len) {
+            break;
+        }
+        memcpy(out + len, utf8, ulen);
+        len += ulen;
+    }
+
+    // 截断时去掉末尾不完整的UTF-8字符
+    if (s < end) {
+        size_t lead = len;
+        while (lead > 0 && ((unsigned char)out[lead - 1] & 0xc0) == 0x80) {
+            lead--;
+        }
+        if (lead > 0) {
+            unsigned char c = (unsigned char)out[lead - 1];
+            size_t need = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+            if (len - (lead - 1) < need) {
+                len = lead - 1;
+            }
+        }
+    }
+    out[len] = '\0';
+    return true;
+}
+
+#endif
@@ -0,0 +1,243 @@
+// 天气查询压测/回放工具
+// 多个线程各持有一个weather_client_t，轮流查询给定的城市列表，统计吞吐和延迟分布。
+// 一般配合weather_stub使用，离线回归测试client A的查询路径：
+//   ./weather_stub -p 8080 -l 50 -j 30 &
+//   ./weather_bench -H 127.0.0.1 -P 8080 -t 4 -n 200 -c beijing,shanghai,guangzhou
+// 查询过程中的日志写到stdout（默认丢弃，-v保留），统计结果写到stderr。
+// 同时统计每次查询在网络上收到的字节数和进程CPU时间，替身加-Z可对比压缩与不压缩。
+// 多提供方：-S指定提供方列表（格式同WEATHER_PROVIDERS），-m parallel并行询问，结束时输出各提供方的胜出次数和成绩：
+//   ./weather_stub -p 8080 -l 80 & ./weather_stub -p 8081 -m wttr -l 20 &
+//   ./weather_bench -S seniverse=127.0.0.1:8080,wttr=127.0.0.1:8081 -n 100
+// 堆分配计数：覆盖malloc/calloc/realloc（转给glibc的__libc_*实现），按线程统计，
+// 每个线程先把各城市查一轮作为预热（解析地址、建立解压流、缓冲池备好缓冲），之后的查询应当为0次。
+// 有查询失败时返回1，便于脚本判断回归。
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/resource.h>
+
+#include "forecast.h"
+
+#define MAX_CITIES 32
+
+typedef struct {
+    int id;
+    int queries;
+    double *latency_ms;     // 每次查询耗时
+    int failures;
+    unsigned long long rx_bytes;    // 从网络收到的字节数
+    weather_endpoint_t endpoints[WEATHER_PROVIDER_MAX];    // 结束时各提供方的统计
+    int endpoint_num;
+    weather_cache_t *cache;
+    int warmup;                 // 预热查询数（不计入堆分配统计）
+    unsigned long heap_allocs;  // 预热后的堆分配次数
+} bench_worker_t;
+
+static const char *host = "127.0.0.1";
+static int port = 8080;
+static const char *providers = NULL;
+static weather_sched_t sched = WEATHER_SCHED_RANKED;
+static char *cities[MAX_CITIES];
+static int city_num = 0;
+
+// glibc内部的分配函数，覆盖malloc等之后用它们完成实际分配
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static __thread unsigned long heap_allocs = 0;
+
+void *malloc(size_t size) {
+    heap_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    heap_allocs++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    heap_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void *bench_thread(void *arg) {
+    bench_worker_t *w = arg;
+    weather_client_t *wc = weather_client_create(NULL, w->cache);
+    if (wc == NULL) {
+        w->failures = w->queries;
+        return NULL;
+    }
+    if (providers == NULL || weather_client_set_providers(wc, providers) != 0) {
+        weather_client_set_server(wc, host, port);
+    }
+    weather_client_set_schedule(wc, sched);
+
+    unsigned long allocs_start = heap_allocs;
+    for (int i = 0; i < w->queries; i++) {
+        if (i == w->warmup) {
+            allocs_start = heap_allocs;
+        }
+        weather_client_set_city(wc, cities[(w->id + i) % city_num]);
+        double start = now_ms();
+        weather_record_t rec;
+        int ret = weather_client_fetch(wc, &rec);
+        w->latency_ms[i] = now_ms() - start;
+        if (ret != 0) {
+            w->failures++;
+        }
+    }
+
+    w->heap_allocs = heap_allocs - allocs_start;
+    w->rx_bytes = wc->rx_bytes;
+    memcpy(w->endpoints, wc->endpoints, sizeof(w->endpoints));
+    w->endpoint_num = wc->endpoint_num;
+    weather_client_destroy(wc);
+    return NULL;
+}
+
+// 进程累计CPU时间（用户态+内核态），毫秒
+static double cpu_ms(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0 +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "用法: %s [-H 主机] [-P 端口] [-t 线程数] [-n 每线程查询数] [-c 城市1,城市2] [-C] [-v]\n"
+                    "       [-S 提供方列表] [-m ranked|parallel]\n", prog);
+    fprintf(stderr, "  -C  启用共享结果缓存（默认关闭，每次都访问上游）\n");
+    fprintf(stderr, "  -S  如seniverse=127.0.0.1:8080,wttr=127.0.0.1:8081，指定后忽略-H/-P\n");
+}
+
+int main(int argc, char **argv) {
+    int threads = 1;
+    int queries = 100;
+    bool use_cache = false;
+    bool verbose = false;
+    char city_arg[512] = "beijing,shanghai,guangzhou";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "H:P:t:n:c:CvS:m:h")) != -1) {
+        switch (opt) {
+            case 'H': host = optarg; break;
+            case 'P': port = atoi(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'n': queries = atoi(optarg); break;
+            case 'c': snprintf(city_arg, sizeof(city_arg), "%s", optarg); break;
+            case 'C': use_cache = true; break;
+            case 'v': verbose = true; break;
+            case 'S': providers = optarg; break;
+            case 'm': sched = strcmp(optarg, "parallel") == 0 ? WEATHER_SCHED_PARALLEL : WEATHER_SCHED_RANKED; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (threads <= 0 || queries <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (char *tok = strtok(city_arg, ","); tok != NULL && city_num < MAX_CITIES; tok = strtok(NULL, ",")) {
+        city_info_t info;
+        if (city_resolve(tok, &info) != 0) {
+            fprintf(stderr, "无效城市名: %s\n", tok);
+            return 1;
+        }
+        cities[city_num++] = tok;
+    }
+    if (city_num == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!verbose) {
+        freopen("/dev/null", "w", stdout);
+    }
+
+    weather_cache_t *cache = use_cache ? weather_cache_create(MAX_CITIES, 600) : NULL;
+    bench_worker_t *workers = calloc(threads, sizeof(bench_worker_t));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    double *latency = calloc((size_t)threads * queries, sizeof(double));
+    if (workers == NULL || tids == NULL || latency == NULL) {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+
+    double start = now_ms();
+    double cpu_start = cpu_ms();
+    for (int i = 0; i < threads; i++) {
+        workers[i].id = i;
+        workers[i].queries = queries;
+        workers[i].latency_ms = latency + (size_t)i * queries;
+        workers[i].cache = cache;
+        workers[i].warmup = queries > city_num ? city_num : 0;
+        pthread_create(&tids[i], NULL, bench_thread, &workers[i]);
+    }
+
+    int failures = 0;
+    unsigned long long rx_bytes = 0;
+    unsigned long heap_allocs_total = 0;
+    int measured = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        failures += workers[i].failures;
+        rx_bytes += workers[i].rx_bytes;
+        heap_allocs_total += workers[i].heap_allocs;
+        measured += workers[i].queries - workers[i].warmup;
+    }
+    double elapsed = now_ms() - start;
+    double cpu = cpu_ms() - cpu_start;
+
+    int total = threads * queries;
+    qsort(latency, total, sizeof(double), cmp_double);
+
+    fprintf(stderr, "目标: %s:%d  线程: %d  查询: %d  城市数: %d  缓存: %s\n",
+            host, port, threads, total, city_num, use_cache ? "开" : "关");
+    fprintf(stderr, "总耗时: %.1fms  吞吐: %.1f次/秒  失败: %d\n",
+            elapsed, total * 1000.0 / elapsed, failures);
+    fprintf(stderr, "延迟(ms): p50=%.2f p95=%.2f p99=%.2f max=%.2f\n",
+            latency[total / 2], latency[total * 95 / 100],
+            latency[total * 99 / 100], latency[total - 1]);
+    fprintf(stderr, "网络接收: 共%llu字节  每次%.0f字节  CPU: 每次%.1fus\n",
+            rx_bytes, (double)rx_bytes / total, cpu * 1000.0 / total);
+    fprintf(stderr, "堆分配: 预热后%d次查询共%lu次  每次%.2f次\n",
+            measured, heap_allocs_total, measured > 0 ? (double)heap_allocs_total / measured : 0.0);
+
+    // 各提供方：胜出/失败次数合计，成绩取各线程平均
+    for (int e = 0; e < workers[0].endpoint_num; e++) {
+        unsigned long wins = 0, fails = 0;
+        double score = 0;
+        for (int i = 0; i < threads; i++) {
+            wins += workers[i].endpoints[e].wins;
+            fails += workers[i].endpoints[e].failures;
+            score += workers[i].endpoints[e].score_ms;
+        }
+        fprintf(stderr, "提供方 %-10s %s:%d  胜出: %lu  失败: %lu  成绩: %.1fms\n",
+                workers[0].endpoints[e].provider->name, workers[0].endpoints[e].host,
+                workers[0].endpoints[e].port, wins, fails, score / threads);
+    }
+
+    free(latency);
+    free(tids);
+    free(workers);
+    weather_cache_destroy(cache);
+    return failures > 0 ? 1 : 0;
+}
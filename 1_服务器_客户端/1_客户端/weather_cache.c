@@ -0,0 +1,172 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "weather_cache.h"
+
+typedef struct {
+    char city[WEATHER_CACHE_KEY_LEN];
+    weather_record_t rec;
+    time_t stored;          // 写入时间（单调时钟，秒），0表示空槽
+} cache_entry_t;
+
+struct weather_cache {
+    pthread_mutex_t lock;
+    int capacity;
+    int ttl_sec;
+    cache_entry_t *entries;
+    weather_shm_t *shm;     // 同机共享表（不归缓存所有，可为NULL）
+};
+
+// 单调时钟秒数，不受系统改时影响
+static time_t now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+weather_cache_t *weather_cache_create(int capacity, int ttl_sec) {
+    if (capacity <= 0 || ttl_sec <= 0) {
+        return NULL;
+    }
+
+    weather_cache_t *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->entries = calloc(capacity, sizeof(cache_entry_t));
+    if (cache->entries == NULL) {
+        free(cache);
+        return NULL;
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->capacity = capacity;
+    cache->ttl_sec = ttl_sec;
+    return cache;
+}
+
+void weather_cache_destroy(weather_cache_t *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    free(cache);
+}
+
+// 查找城市对应的槽位，调用者需持有锁
+static cache_entry_t *find_entry(weather_cache_t *cache, const char *city) {
+    for (int i = 0; i < cache->capacity; i++) {
+        cache_entry_t *e = &cache->entries[i];
+        if (e->stored != 0 && strcmp(e->city, city) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// 写入城市的记录，stored为写入时间（单调时钟），调用者需持有锁
+static void store_entry(weather_cache_t *cache, const char *city, const weather_record_t *rec, time_t stored) {
+    cache_entry_t *e = find_entry(cache, city);
+    if (e == NULL) {
+        // 优先使用空槽，否则淘汰最早写入的条目
+        e = &cache->entries[0];
+        for (int i = 0; i < cache->capacity; i++) {
+            cache_entry_t *cur = &cache->entries[i];
+            if (cur->stored == 0) {
+                e = cur;
+                break;
+            }
+            if (cur->stored < e->stored) {
+                e = cur;
+            }
+        }
+        snprintf(e->city, sizeof(e->city), "%s", city);
+    }
+    e->rec = *rec;
+    e->stored = stored;
+}
+
+// 共享表的槽只存得下WEATHER_RECORD_ID_LEN-1字节的城市键，更长的键截断后可能和别的城市撞上，不进共享表
+static bool shm_key_fits(const char *city) {
+    return strlen(city) < WEATHER_RECORD_ID_LEN;
+}
+
+bool weather_cache_get(weather_cache_t *cache, const char *city, weather_record_t *out) {
+    if (cache == NULL || city == NULL || out == NULL) {
+        return false;
+    }
+
+    bool hit = false;
+    pthread_mutex_lock(&cache->lock);
+    cache_entry_t *e = find_entry(cache, city);
+    if (e != NULL && now_sec() - e->stored < cache->ttl_sec) {
+        *out = e->rec;
+        hit = true;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (hit || cache->shm == NULL || !shm_key_fits(city)) {
+        return hit;
+    }
+
+    // 本进程没有，看看同机其他客户端A进程是否刚查过（共享表按墙上时间记录写入时间）
+    uint32_t stored;
+    if (!weather_shm_get(cache->shm, city, out, &stored)) {
+        return false;
+    }
+    long age = (long)time(NULL) - (long)stored;
+    if (age < 0 || age >= cache->ttl_sec) {
+        return false;
+    }
+    // stored为0表示空槽：单调时钟起点附近（开机不久）倒推出的时间不能落到0及以下
+    time_t stored_at = now_sec() - age;
+    pthread_mutex_lock(&cache->lock);
+    store_entry(cache, city, out, stored_at > 0 ? stored_at : 1);
+    pthread_mutex_unlock(&cache->lock);
+    return true;
+}
+
+int weather_cache_ttl_left(weather_cache_t *cache, const char *city) {
+    if (cache == NULL || city == NULL) {
+        return -1;
+    }
+
+    int left = -1;
+    pthread_mutex_lock(&cache->lock);
+    cache_entry_t *e = find_entry(cache, city);
+    if (e != NULL) {
+        time_t remain = e->stored + cache->ttl_sec - now_sec();
+        if (remain > 0) {
+            left = (int)remain;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return left;
+}
+
+void weather_cache_put(weather_cache_t *cache, const char *city, const weather_record_t *rec) {
+    if (cache == NULL || city == NULL || rec == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    store_entry(cache, city, rec, now_sec());
+    pthread_mutex_unlock(&cache->lock);
+
+    // 同时发布到同机共享表，供其他进程无锁读取。槽按缓存键存，与查找时用同一个键
+    if (cache->shm != NULL && shm_key_fits(city)) {
+        weather_record_t shared = *rec;
+        snprintf(shared.city_id, sizeof(shared.city_id), "%s", city);
+        weather_shm_put(cache->shm, &shared);
+    }
+}
+
+void weather_cache_set_shared(weather_cache_t *cache, weather_shm_t *shm) {
+    if (cache != NULL) {
+        cache->shm = shm;
+    }
+}
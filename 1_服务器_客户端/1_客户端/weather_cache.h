@@ -0,0 +1,35 @@
+#ifndef _WEATHER_CACHE_H
+#define _WEATHER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "weather_record.h"
+#include "weather_shm.h"
+
+#define WEATHER_CACHE_KEY_LEN   64
+
+// 天气结果缓存（按城市保存最近一次查询结果，线程安全，可被多个查询上下文共享）
+typedef struct weather_cache weather_cache_t;
+
+// 创建缓存：capacity为最多缓存的城市数，ttl_sec为结果有效期（秒）
+weather_cache_t *weather_cache_create(int capacity, int ttl_sec);
+
+// 销毁缓存
+void weather_cache_destroy(weather_cache_t *cache);
+
+// 查询缓存，命中且未过期时把天气记录拷贝到out并返回true
+bool weather_cache_get(weather_cache_t *cache, const char *city, weather_record_t *out);
+
+// 查询某个城市结果的剩余有效期（秒），不存在或已过期返回-1
+int weather_cache_ttl_left(weather_cache_t *cache, const char *city);
+
+// 写入/更新某个城市的天气记录
+void weather_cache_put(weather_cache_t *cache, const char *city, const weather_record_t *rec);
+
+// 关联同机共享天气表（见weather_shm.h）：写入时同时发布到共享表，
+// 本地未命中时再查共享表（其他客户端A进程的结果，同样按ttl判断是否过期）。
+// 共享表的槽按城市键存，键长超过槽的容量（WEATHER_RECORD_ID_LEN-1字节）的城市只在本进程缓存
+void weather_cache_set_shared(weather_cache_t *cache, weather_shm_t *shm);
+
+#endif
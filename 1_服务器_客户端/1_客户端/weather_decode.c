@@ -0,0 +1,769 @@
+// 由gen_decoder.py根据weather_schema.json生成，请勿手工修改
+#include <string.h>
+
+#include "weather_decode.h"
+#include "weather_series.h"
+
+// ---------------- seniverse_now ----------------
+
+static void seniverse_now_init(seniverse_now_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->code = JSON_NONE_U8;
+    out->temperature = JSON_NONE_I16;
+    out->humidity = JSON_NONE_U8;
+    out->wind_degree = JSON_NONE_U16;
+    out->wind_speed = JSON_NONE_U16;
+    out->wind_scale = JSON_NONE_U8;
+}
+
+static void seniverse_now_results_0_now(json_scan_t *js, seniverse_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 4:
+                if (memcmp(key, "text", 4) == 0) {
+                    json_read_text(js, out->text, sizeof(out->text));
+                    continue;
+                }
+                if (memcmp(key, "code", 4) == 0) {
+                    out->code = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "humidity", 8) == 0) {
+                    out->humidity = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 10:
+                if (memcmp(key, "wind_speed", 10) == 0) {
+                    out->wind_speed = json_read_u16_x10(js);
+                    continue;
+                }
+                if (memcmp(key, "wind_scale", 10) == 0) {
+                    out->wind_scale = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 11:
+                if (memcmp(key, "temperature", 11) == 0) {
+                    out->temperature = json_read_i16_x10(js);
+                    continue;
+                }
+                break;
+            case 14:
+                if (memcmp(key, "wind_direction", 14) == 0) {
+                    json_read_text(js, out->wind_direction, sizeof(out->wind_direction));
+                    continue;
+                }
+                break;
+            case 21:
+                if (memcmp(key, "wind_direction_degree", 21) == 0) {
+                    out->wind_degree = json_read_u16(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_now_results_0_location(json_scan_t *js, seniverse_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 2:
+                if (memcmp(key, "id", 2) == 0) {
+                    json_read_text(js, out->location_id, sizeof(out->location_id));
+                    continue;
+                }
+                break;
+            case 4:
+                if (memcmp(key, "name", 4) == 0) {
+                    json_read_text(js, out->city_name, sizeof(out->city_name));
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_now_results_0(json_scan_t *js, seniverse_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    char text[64];
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 3:
+                if (memcmp(key, "now", 3) == 0) {
+                    seniverse_now_results_0_now(js, out);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "location", 8) == 0) {
+                    seniverse_now_results_0_location(js, out);
+                    continue;
+                }
+                break;
+            case 11:
+                if (memcmp(key, "last_update", 11) == 0) {
+                    if (json_read_text(js, text, sizeof(text))) {
+                        out->last_update = weather_series_parse_time(text);
+                    }
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_now_results(json_scan_t *js, seniverse_now_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            seniverse_now_results_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_now_root(json_scan_t *js, seniverse_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 7:
+                if (memcmp(key, "results", 7) == 0) {
+                    seniverse_now_results(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int seniverse_now_decode(const char *json, size_t len, seniverse_now_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    seniverse_now_init(out);
+    seniverse_now_root(&js, out);
+    return js.error ? -1 : 0;
+}
+
+// ---------------- seniverse_daily ----------------
+
+static void seniverse_daily_day_init(seniverse_daily_day_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->date = -1;
+    out->high = JSON_NONE_I8;
+    out->low = JSON_NONE_I8;
+    out->code_day = JSON_NONE_U8;
+    out->code_night = JSON_NONE_U8;
+    out->humidity = JSON_NONE_U8;
+    out->wind_scale = JSON_NONE_U8;
+    out->rainfall = JSON_NONE_U16;
+}
+
+static void seniverse_daily_init(seniverse_daily_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+static void seniverse_daily_day_root(json_scan_t *js, seniverse_daily_day_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    char text[64];
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 3:
+                if (memcmp(key, "low", 3) == 0) {
+                    out->low = json_read_i8(js);
+                    continue;
+                }
+                break;
+            case 4:
+                if (memcmp(key, "date", 4) == 0) {
+                    if (json_read_text(js, text, sizeof(text))) {
+                        out->date = weather_series_parse_day(text);
+                    }
+                    continue;
+                }
+                if (memcmp(key, "high", 4) == 0) {
+                    out->high = json_read_i8(js);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "code_day", 8) == 0) {
+                    out->code_day = json_read_u8(js);
+                    continue;
+                }
+                if (memcmp(key, "humidity", 8) == 0) {
+                    out->humidity = json_read_u8(js);
+                    continue;
+                }
+                if (memcmp(key, "rainfall", 8) == 0) {
+                    out->rainfall = json_read_u16_x10(js);
+                    continue;
+                }
+                break;
+            case 10:
+                if (memcmp(key, "code_night", 10) == 0) {
+                    out->code_night = json_read_u8(js);
+                    continue;
+                }
+                if (memcmp(key, "wind_scale", 10) == 0) {
+                    out->wind_scale = json_read_u8(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_daily_results_0_daily(json_scan_t *js, seniverse_daily_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    for (bool first = true; json_array_next(js, &first); ) {
+        if (out->day_num >= 15) {
+            json_skip(js);
+            continue;
+        }
+        seniverse_daily_day_t *elem = &out->day[out->day_num++];
+        seniverse_daily_day_init(elem);
+        seniverse_daily_day_root(js, elem);
+    }
+}
+
+static void seniverse_daily_results_0(json_scan_t *js, seniverse_daily_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 5:
+                if (memcmp(key, "daily", 5) == 0) {
+                    seniverse_daily_results_0_daily(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_daily_results(json_scan_t *js, seniverse_daily_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            seniverse_daily_results_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_daily_root(json_scan_t *js, seniverse_daily_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 7:
+                if (memcmp(key, "results", 7) == 0) {
+                    seniverse_daily_results(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int seniverse_daily_decode(const char *json, size_t len, seniverse_daily_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    seniverse_daily_init(out);
+    seniverse_daily_root(&js, out);
+    return js.error ? -1 : 0;
+}
+
+// ---------------- seniverse_hourly ----------------
+
+static void seniverse_hourly_hour_init(seniverse_hourly_hour_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->time = -1;
+    out->temperature = JSON_NONE_I8;
+    out->code = JSON_NONE_U8;
+    out->humidity = JSON_NONE_U8;
+    out->wind_speed = JSON_NONE_U16;
+}
+
+static void seniverse_hourly_init(seniverse_hourly_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+static void seniverse_hourly_hour_root(json_scan_t *js, seniverse_hourly_hour_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    char text[64];
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 4:
+                if (memcmp(key, "time", 4) == 0) {
+                    if (json_read_text(js, text, sizeof(text))) {
+                        out->time = weather_series_parse_hour(text);
+                    }
+                    continue;
+                }
+                if (memcmp(key, "code", 4) == 0) {
+                    out->code = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "humidity", 8) == 0) {
+                    out->humidity = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 10:
+                if (memcmp(key, "wind_speed", 10) == 0) {
+                    out->wind_speed = json_read_u16_x10(js);
+                    continue;
+                }
+                break;
+            case 11:
+                if (memcmp(key, "temperature", 11) == 0) {
+                    out->temperature = json_read_i8(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_hourly_results_0_hourly(json_scan_t *js, seniverse_hourly_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    for (bool first = true; json_array_next(js, &first); ) {
+        if (out->hour_num >= 72) {
+            json_skip(js);
+            continue;
+        }
+        seniverse_hourly_hour_t *elem = &out->hour[out->hour_num++];
+        seniverse_hourly_hour_init(elem);
+        seniverse_hourly_hour_root(js, elem);
+    }
+}
+
+static void seniverse_hourly_results_0(json_scan_t *js, seniverse_hourly_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 6:
+                if (memcmp(key, "hourly", 6) == 0) {
+                    seniverse_hourly_results_0_hourly(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_hourly_results(json_scan_t *js, seniverse_hourly_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            seniverse_hourly_results_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void seniverse_hourly_root(json_scan_t *js, seniverse_hourly_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 7:
+                if (memcmp(key, "results", 7) == 0) {
+                    seniverse_hourly_results(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int seniverse_hourly_decode(const char *json, size_t len, seniverse_hourly_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    seniverse_hourly_init(out);
+    seniverse_hourly_root(&js, out);
+    return js.error ? -1 : 0;
+}
+
+// ---------------- wttr_now ----------------
+
+static void wttr_now_init(wttr_now_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->code = JSON_NONE_U16;
+    out->temperature = JSON_NONE_I16;
+    out->humidity = JSON_NONE_U8;
+    out->wind_speed = JSON_NONE_U16;
+    out->wind_degree = JSON_NONE_U16;
+}
+
+static void wttr_now_current_condition_0_lang_zh_0(json_scan_t *js, wttr_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 5:
+                if (memcmp(key, "value", 5) == 0) {
+                    json_read_text(js, out->text_zh, sizeof(out->text_zh));
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_current_condition_0_lang_zh(json_scan_t *js, wttr_now_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            wttr_now_current_condition_0_lang_zh_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_current_condition_0_weatherDesc_0(json_scan_t *js, wttr_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 5:
+                if (memcmp(key, "value", 5) == 0) {
+                    json_read_text(js, out->text_en, sizeof(out->text_en));
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_current_condition_0_weatherDesc(json_scan_t *js, wttr_now_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            wttr_now_current_condition_0_weatherDesc_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_current_condition_0(json_scan_t *js, wttr_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 6:
+                if (memcmp(key, "temp_C", 6) == 0) {
+                    out->temperature = json_read_i16_x10(js);
+                    continue;
+                }
+                break;
+            case 7:
+                if (memcmp(key, "lang_zh", 7) == 0) {
+                    wttr_now_current_condition_0_lang_zh(js, out);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "humidity", 8) == 0) {
+                    out->humidity = json_read_u8(js);
+                    continue;
+                }
+                break;
+            case 11:
+                if (memcmp(key, "weatherDesc", 11) == 0) {
+                    wttr_now_current_condition_0_weatherDesc(js, out);
+                    continue;
+                }
+                if (memcmp(key, "weatherCode", 11) == 0) {
+                    out->code = json_read_u16(js);
+                    continue;
+                }
+                break;
+            case 13:
+                if (memcmp(key, "windspeedKmph", 13) == 0) {
+                    out->wind_speed = json_read_u16_x10(js);
+                    continue;
+                }
+                if (memcmp(key, "winddirDegree", 13) == 0) {
+                    out->wind_degree = json_read_u16(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_current_condition(json_scan_t *js, wttr_now_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            wttr_now_current_condition_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void wttr_now_root(json_scan_t *js, wttr_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 17:
+                if (memcmp(key, "current_condition", 17) == 0) {
+                    wttr_now_current_condition(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int wttr_now_decode(const char *json, size_t len, wttr_now_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    wttr_now_init(out);
+    wttr_now_root(&js, out);
+    return js.error ? -1 : 0;
+}
+
+// ---------------- owm_now ----------------
+
+static void owm_now_init(owm_now_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->code = JSON_NONE_U16;
+    out->temperature = JSON_NONE_I16;
+    out->humidity = JSON_NONE_U8;
+    out->wind_speed = JSON_NONE_U16;
+    out->wind_degree = JSON_NONE_U16;
+}
+
+static void owm_now_main(json_scan_t *js, owm_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 4:
+                if (memcmp(key, "temp", 4) == 0) {
+                    out->temperature = json_read_i16_x10(js);
+                    continue;
+                }
+                break;
+            case 8:
+                if (memcmp(key, "humidity", 8) == 0) {
+                    out->humidity = json_read_u8(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void owm_now_wind(json_scan_t *js, owm_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 3:
+                if (memcmp(key, "deg", 3) == 0) {
+                    out->wind_degree = json_read_u16(js);
+                    continue;
+                }
+                break;
+            case 5:
+                if (memcmp(key, "speed", 5) == 0) {
+                    out->wind_speed = json_read_u16_x10(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void owm_now_weather_0(json_scan_t *js, owm_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 2:
+                if (memcmp(key, "id", 2) == 0) {
+                    out->code = json_read_u16(js);
+                    continue;
+                }
+                break;
+            case 11:
+                if (memcmp(key, "description", 11) == 0) {
+                    json_read_text(js, out->text, sizeof(out->text));
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void owm_now_weather(json_scan_t *js, owm_now_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    int index = 0;
+    for (bool first = true; json_array_next(js, &first); index++) {
+        if (index == 0) {
+            owm_now_weather_0(js, out);
+            continue;
+        }
+        json_skip(js);
+    }
+}
+
+static void owm_now_root(json_scan_t *js, owm_now_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 2:
+                if (memcmp(key, "dt", 2) == 0) {
+                    out->dt = json_read_u32(js);
+                    continue;
+                }
+                break;
+            case 4:
+                if (memcmp(key, "main", 4) == 0) {
+                    owm_now_main(js, out);
+                    continue;
+                }
+                if (memcmp(key, "wind", 4) == 0) {
+                    owm_now_wind(js, out);
+                    continue;
+                }
+                break;
+            case 7:
+                if (memcmp(key, "weather", 7) == 0) {
+                    owm_now_weather(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int owm_now_decode(const char *json, size_t len, owm_now_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    owm_now_init(out);
+    owm_now_root(&js, out);
+    return js.error ? -1 : 0;
+}
@@ -0,0 +1,95 @@
+// 由gen_decoder.py根据weather_schema.json生成，请勿手工修改
+#ifndef _WEATHER_DECODE_H
+#define _WEATHER_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_scan.h"
+
+// 心知天气实况 /v3/weather/now.json
+typedef struct {
+    char location_id[16];        // results[0].location.id，缺失为空串
+    char city_name[24];          // results[0].location.name，缺失为空串
+    char text[24];               // results[0].now.text，缺失为空串
+    uint8_t code;                // results[0].now.code，缺失为JSON_NONE_U8
+    int16_t temperature;         // results[0].now.temperature，x10，缺失为JSON_NONE_I16
+    uint8_t humidity;            // results[0].now.humidity，缺失为JSON_NONE_U8
+    char wind_direction[16];     // results[0].now.wind_direction，缺失为空串
+    uint16_t wind_degree;        // results[0].now.wind_direction_degree，缺失为JSON_NONE_U16
+    uint16_t wind_speed;         // results[0].now.wind_speed，x10，缺失为JSON_NONE_U16
+    uint8_t wind_scale;          // results[0].now.wind_scale，缺失为JSON_NONE_U8
+    uint32_t last_update;        // results[0].last_update，缺失为0
+} seniverse_now_t;
+
+// 解码seniverse_now，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int seniverse_now_decode(const char *json, size_t len, seniverse_now_t *out);
+
+// 一天的预报
+typedef struct {
+    int32_t date;                // date，缺失为-1
+    int8_t high;                 // high，缺失为JSON_NONE_I8
+    int8_t low;                  // low，缺失为JSON_NONE_I8
+    uint8_t code_day;            // code_day，缺失为JSON_NONE_U8
+    uint8_t code_night;          // code_night，缺失为JSON_NONE_U8
+    uint8_t humidity;            // humidity，缺失为JSON_NONE_U8
+    uint8_t wind_scale;          // wind_scale，缺失为JSON_NONE_U8
+    uint16_t rainfall;           // rainfall，x10，缺失为JSON_NONE_U16
+} seniverse_daily_day_t;
+
+// 心知天气逐日预报 /v3/weather/daily.json
+typedef struct {
+    uint8_t day_num;
+    seniverse_daily_day_t day[15]; // results[0].daily[]
+} seniverse_daily_t;
+
+// 解码seniverse_daily，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int seniverse_daily_decode(const char *json, size_t len, seniverse_daily_t *out);
+
+// 一小时的预报
+typedef struct {
+    int32_t time;                // time，缺失为-1
+    int8_t temperature;          // temperature，缺失为JSON_NONE_I8
+    uint8_t code;                // code，缺失为JSON_NONE_U8
+    uint8_t humidity;            // humidity，缺失为JSON_NONE_U8
+    uint16_t wind_speed;         // wind_speed，x10，缺失为JSON_NONE_U16
+} seniverse_hourly_hour_t;
+
+// 心知天气逐小时预报 /v3/weather/hourly.json
+typedef struct {
+    uint8_t hour_num;
+    seniverse_hourly_hour_t hour[72]; // results[0].hourly[]
+} seniverse_hourly_t;
+
+// 解码seniverse_hourly，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int seniverse_hourly_decode(const char *json, size_t len, seniverse_hourly_t *out);
+
+// wttr.in实况 /{城市}?format=j1
+typedef struct {
+    char text_zh[24];            // current_condition[0].lang_zh[0].value，缺失为空串
+    char text_en[24];            // current_condition[0].weatherDesc[0].value，缺失为空串
+    uint16_t code;               // current_condition[0].weatherCode，缺失为JSON_NONE_U16
+    int16_t temperature;         // current_condition[0].temp_C，x10，缺失为JSON_NONE_I16
+    uint8_t humidity;            // current_condition[0].humidity，缺失为JSON_NONE_U8
+    uint16_t wind_speed;         // current_condition[0].windspeedKmph，x10，缺失为JSON_NONE_U16
+    uint16_t wind_degree;        // current_condition[0].winddirDegree，缺失为JSON_NONE_U16
+} wttr_now_t;
+
+// 解码wttr_now，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int wttr_now_decode(const char *json, size_t len, wttr_now_t *out);
+
+// OpenWeatherMap实况 /data/2.5/weather
+typedef struct {
+    char text[24];               // weather[0].description，缺失为空串
+    uint16_t code;               // weather[0].id，缺失为JSON_NONE_U16
+    int16_t temperature;         // main.temp，x10，缺失为JSON_NONE_I16
+    uint8_t humidity;            // main.humidity，缺失为JSON_NONE_U8
+    uint16_t wind_speed;         // wind.speed，x10，缺失为JSON_NONE_U16
+    uint16_t wind_degree;        // wind.deg，缺失为JSON_NONE_U16
+    uint32_t dt;                 // dt，缺失为0
+} owm_now_t;
+
+// 解码owm_now，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int owm_now_decode(const char *json, size_t len, owm_now_t *out);
+
+#endif
@@ -0,0 +1,492 @@
+#define _GNU_SOURCE
+#include <time.h>
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <sys/socket.h>
+
+#include "weather_http.h"
+
+#define HTTP_READ_CHUNK 16384   // 每次recv的大小
+#define HTTP_BUF_INIT 4096
+
+// 线程内缓冲池：响应缓冲按4K/16K/64K/256K分级，每级最多缓存POOL_KEEP个空闲缓冲，更大的直接malloc
+#define POOL_CLASSES 4
+#define POOL_KEEP 8
+
+// 分块解码状态
+enum {
+    CHUNK_SIZE,     // 块大小行
+    CHUNK_DATA,     // 块数据
+    CHUNK_CRLF,     // 块数据后的\r\n
+    CHUNK_END       // 收到大小为0的结束块，之后的trailer忽略
+};
+
+// ---------------- 线程内缓冲池 ----------------
+// 尝试开始接收时从当前线程的池里借缓冲和解压流，尝试结束（取消/失败/结果已用完）时还回去，
+// 稳态下查询不再有堆分配；缓冲不再固定属于某个尝试，同一线程的所有查询上下文共用。
+// 借和还可以在不同线程，缓冲只是换了一个池；线程退出时释放它池里的缓冲。
+
+typedef struct pool_block {
+    struct pool_block *next;        // 空闲缓冲的开头用作链表指针
+} pool_block_t;
+
+typedef struct {
+    bool registered;                // 已登记线程退出时的清理
+    pool_block_t *free[POOL_CLASSES];
+    int free_num[POOL_CLASSES];
+    z_stream *zs[POOL_KEEP];        // 空闲的解压流（已inflateInit2）
+    int zs_num;
+} http_pool_t;
+
+static __thread http_pool_t thread_pool;
+static pthread_key_t pool_key;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static size_t pool_class_size(int c) {
+    return (size_t)HTTP_BUF_INIT << (2 * c);
+}
+
+static void pool_release(void *arg) {
+    http_pool_t *pool = arg;
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        while (pool->free[c] != NULL) {
+            pool_block_t *b = pool->free[c];
+            pool->free[c] = b->next;
+            free(b);
+        }
+        pool->free_num[c] = 0;
+    }
+    while (pool->zs_num > 0) {
+        z_stream *zs = pool->zs[--pool->zs_num];
+        inflateEnd(zs);
+        free(zs);
+    }
+}
+
+static void pool_key_create(void) {
+    pthread_key_create(&pool_key, pool_release);
+}
+
+static http_pool_t *pool_get(void) {
+    http_pool_t *pool = &thread_pool;
+    if (!pool->registered) {
+        pthread_once(&pool_once, pool_key_create);
+        pthread_setspecific(pool_key, pool);
+        pool->registered = true;
+    }
+    return pool;
+}
+
+// 借一块至少need字节的缓冲，cap返回实际容量
+static char *pool_buf_get(size_t need, size_t *cap) {
+    http_pool_t *pool = pool_get();
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        if (pool_class_size(c) < need) {
+            continue;
+        }
+        *cap = pool_class_size(c);
+        pool_block_t *b = pool->free[c];
+        if (b != NULL) {
+            pool->free[c] = b->next;
+            pool->free_num[c]--;
+            return (char *)b;
+        }
+        return malloc(*cap);
+    }
+    *cap = need + need / 2;     // 超出分级的大响应，按1.5倍分配，不缓存
+    return malloc(*cap);
+}
+
+static void pool_buf_put(char *buf, size_t cap) {
+    if (buf == NULL) {
+        return;
+    }
+    http_pool_t *pool = pool_get();
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        if (pool_class_size(c) == cap && pool->free_num[c] < POOL_KEEP) {
+            pool_block_t *b = (pool_block_t *)buf;
+            b->next = pool->free[c];
+            pool->free[c] = b;
+            pool->free_num[c]++;
+            return;
+        }
+    }
+    free(buf);
+}
+
+// 借一个解压流，windowBits 15+32：自动识别gzip头和zlib头
+static z_stream *pool_inflate_get(void) {
+    http_pool_t *pool = pool_get();
+    if (pool->zs_num > 0) {
+        z_stream *zs = pool->zs[--pool->zs_num];
+        if (inflateReset(zs) == Z_OK) {
+            return zs;
+        }
+        inflateEnd(zs);
+        free(zs);
+        return NULL;
+    }
+    z_stream *zs = calloc(1, sizeof(z_stream));
+    if (zs == NULL || inflateInit2(zs, 15 + 32) != Z_OK) {
+        free(zs);
+        return NULL;
+    }
+    return zs;
+}
+
+static void pool_inflate_put(z_stream *zs) {
+    if (zs == NULL) {
+        return;
+    }
+    http_pool_t *pool = pool_get();
+    if (pool->zs_num < POOL_KEEP) {
+        pool->zs[pool->zs_num++] = zs;
+        return;
+    }
+    inflateEnd(zs);
+    free(zs);
+}
+
+// ---------------- 单次请求 ----------------
+
+double http_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int http_attempt_start(http_attempt_t *a, const struct sockaddr *addr, socklen_t addr_len,
+                       const char *request, size_t req_len) {
+    a->request = request;
+    a->req_len = req_len;
+    a->req_sent = 0;
+    a->len = 0;
+    a->start_ms = http_now_ms();
+    a->connect_ms = 0;
+    a->header_len = 0;
+    a->status = 0;
+    a->chunked = false;
+    a->gzip = false;
+    a->chunk_state = CHUNK_SIZE;
+    a->chunk_left = 0;
+    a->chunk_line_len = 0;
+    a->z_end = false;
+    a->rx_bytes = 0;
+    a->state = HTTP_FAILED;
+
+    a->fd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (a->fd < 0) {
+        return -1;
+    }
+
+    if (connect(a->fd, addr, addr_len) == 0) {
+        a->connect_ms = http_now_ms() - a->start_ms;
+        a->state = HTTP_SENDING;
+    } else if (errno == EINPROGRESS) {
+        a->state = HTTP_CONNECTING;
+    } else {
+        close(a->fd);
+        a->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+short http_attempt_events(const http_attempt_t *a) {
+    switch (a->state) {
+        case HTTP_CONNECTING:
+        case HTTP_SENDING:
+            return POLLOUT;
+        case HTTP_RECEIVING:
+            return POLLIN;
+        default:
+            return 0;
+    }
+}
+
+static http_state_t attempt_fail(http_attempt_t *a) {
+    http_attempt_cancel(a);
+    a->state = HTTP_FAILED;
+    return a->state;
+}
+
+// 保证buf末尾至少还能放need字节，另留一个字节给'\0'；不够时从池里换一块更大的
+static int buf_reserve(http_attempt_t *a, size_t need) {
+    if (a->buf != NULL && a->cap - a->len > need) {
+        return 0;
+    }
+    size_t new_cap;
+    char *new_buf = pool_buf_get(a->len + need + 1, &new_cap);
+    if (new_buf == NULL) {
+        return -1;
+    }
+    if (a->len > 0) {
+        memcpy(new_buf, a->buf, a->len);
+    }
+    pool_buf_put(a->buf, a->cap);
+    a->buf = new_buf;
+    a->cap = new_cap;
+    return 0;
+}
+
+// 解压一段压缩数据，输出直接写到buf末尾
+// 输入用完时如果输出空间正好写满，zlib内部可能还留着已解出的数据，要换更大的缓冲再取一轮
+static int body_inflate(http_attempt_t *a, const char *data, size_t n) {
+    z_stream *zs = a->zs;
+    zs->next_in = (Bytef *)data;
+    zs->avail_in = n;
+
+    while (!a->z_end && (zs->avail_in > 0 || zs->avail_out == 0)) {
+        if (buf_reserve(a, HTTP_BUF_INIT) != 0) {
+            return -1;
+        }
+        zs->next_out = (Bytef *)a->buf + a->len;
+        zs->avail_out = a->cap - a->len - 1;
+        int ret = inflate(zs, Z_NO_FLUSH);
+        a->len = (char *)zs->next_out - a->buf;
+        if (ret == Z_STREAM_END) {
+            a->z_end = true;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return -1;
+        }
+    }
+    a->buf[a->len] = '\0';
+    return 0;
+}
+
+// 一段去掉分块后的响应体数据：压缩的解压，否则直接追加
+static int body_feed(http_attempt_t *a, const char *data, size_t n) {
+    if (a->gzip) {
+        return body_inflate(a, data, n);
+    }
+    if (buf_reserve(a, n) != 0) {
+        return -1;
+    }
+    memcpy(a->buf + a->len, data, n);
+    a->len += n;
+    a->buf[a->len] = '\0';
+    return 0;
+}
+
+// 分块解码，数据可以在任意位置被切开
+static int chunk_feed(http_attempt_t *a, const char *data, size_t n) {
+    while (n > 0 && a->chunk_state != CHUNK_END) {
+        size_t take;
+        switch (a->chunk_state) {
+            case CHUNK_SIZE: {
+                char c = *data++;
+                n--;
+                if (c != '\n') {
+                    if (a->chunk_line_len >= sizeof(a->chunk_line) - 1) {
+                        return -1;
+                    }
+                    a->chunk_line[a->chunk_line_len++] = c;
+                    break;
+                }
+                // 块大小行结束，chunk扩展和\r在strtoul处自然停止
+                a->chunk_line[a->chunk_line_len] = '\0';
+                a->chunk_line_len = 0;
+                char *end;
+                a->chunk_left = strtoul(a->chunk_line, &end, 16);
+                if (end == a->chunk_line) {
+                    return -1;
+                }
+                a->chunk_state = a->chunk_left == 0 ? CHUNK_END : CHUNK_DATA;
+                break;
+            }
+            case CHUNK_DATA:
+                take = n < a->chunk_left ? n : a->chunk_left;
+                if (body_feed(a, data, take) != 0) {
+                    return -1;
+                }
+                data += take;
+                n -= take;
+                a->chunk_left -= take;
+                if (a->chunk_left == 0) {
+                    a->chunk_state = CHUNK_CRLF;
+                    a->chunk_left = 2;
+                }
+                break;
+            default:    // CHUNK_CRLF
+                take = n < a->chunk_left ? n : a->chunk_left;
+                data += take;
+                n -= take;
+                a->chunk_left -= take;
+                if (a->chunk_left == 0) {
+                    a->chunk_state = CHUNK_SIZE;
+                }
+                break;
+        }
+    }
+    return 0;
+}
+
+// 响应头收完后解析状态码和编码方式，压缩的准备解压流
+static int parse_headers(http_attempt_t *a) {
+    if (sscanf(a->buf, "HTTP/%*s %d", &a->status) != 1) {
+        return -1;
+    }
+
+    a->chunked = strcasestr(a->buf, "\r\nTransfer-Encoding: chunked") != NULL;
+    a->gzip = strcasestr(a->buf, "\r\nContent-Encoding: gzip") != NULL ||
+              strcasestr(a->buf, "\r\nContent-Encoding: deflate") != NULL;
+    if (!a->gzip) {
+        return 0;
+    }
+
+    if (a->zs == NULL) {
+        a->zs = pool_inflate_get();
+        return a->zs != NULL ? 0 : -1;
+    }
+    return inflateReset((z_stream *)a->zs) == Z_OK ? 0 : -1;
+}
+
+// 处理recv收到的一段数据
+static int attempt_receive(http_attempt_t *a, const char *data, size_t n) {
+    a->rx_bytes += n;
+    if (a->header_len != 0) {
+        return a->chunked ? chunk_feed(a, data, n) : body_feed(a, data, n);
+    }
+
+    // 响应头还没收完：先追加到buf，再找空行
+    size_t old_len = a->len;
+    if (buf_reserve(a, n) != 0) {
+        return -1;
+    }
+    memcpy(a->buf + a->len, data, n);
+    a->len += n;
+    a->buf[a->len] = '\0';
+
+    char *end = strstr(a->buf + (old_len > 3 ? old_len - 3 : 0), "\r\n\r\n");
+    if (end == NULL) {
+        return 0;
+    }
+    a->header_len = end + 4 - a->buf;
+    a->len = a->header_len;
+    a->buf[a->len] = '\0';
+    if (parse_headers(a) != 0) {
+        return -1;
+    }
+
+    // 空行之后的部分已经是响应体，它一定都在这次收到的数据里
+    size_t used = a->header_len - old_len;
+    data += used;
+    n -= used;
+    return a->chunked ? chunk_feed(a, data, n) : body_feed(a, data, n);
+}
+
+// 响应是否完整：分块的要收到结束块，压缩的要解压到流结束
+static bool response_complete(const http_attempt_t *a) {
+    if (a->header_len == 0) {
+        return false;
+    }
+    if (a->chunked && a->chunk_state != CHUNK_END) {
+        return false;
+    }
+    return !a->gzip || a->z_end;
+}
+
+http_state_t http_attempt_step(http_attempt_t *a, short revents) {
+    if (a->state == HTTP_CONNECTING) {
+        int err = 0;
+        socklen_t err_len = sizeof(err);
+        if (getsockopt(a->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0) {
+            return attempt_fail(a);
+        }
+        a->connect_ms = http_now_ms() - a->start_ms;
+        a->state = HTTP_SENDING;
+    }
+
+    if (a->state == HTTP_SENDING) {
+        while (a->req_sent < a->req_len) {
+            ssize_t n = send(a->fd, a->request + a->req_sent, a->req_len - a->req_sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return a->state;
+                }
+                return attempt_fail(a);
+            }
+            a->req_sent += n;
+        }
+        a->state = HTTP_RECEIVING;
+        return a->state;
+    }
+
+    if (a->state == HTTP_RECEIVING && (revents & (POLLIN | POLLHUP | POLLERR))) {
+        char chunk[HTTP_READ_CHUNK];
+        while (1) {
+            ssize_t n = recv(a->fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                if (attempt_receive(a, chunk, n) != 0) {
+                    printf("响应解码失败\n");
+                    return attempt_fail(a);
+                }
+                continue;
+            }
+            if (n == 0) {
+                // 服务器按Connection: close关闭连接，检查响应是否完整
+                close(a->fd);
+                a->fd = -1;
+                a->state = response_complete(a) ? HTTP_DONE : HTTP_FAILED;
+                return a->state;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return a->state;
+            }
+            if (errno != EINTR) {
+                return attempt_fail(a);
+            }
+        }
+    }
+
+    return a->state;
+}
+
+void http_attempt_cancel(http_attempt_t *a) {
+    if (a->fd >= 0) {
+        close(a->fd);
+        a->fd = -1;
+    }
+    a->state = HTTP_IDLE;
+    pool_buf_put(a->buf, a->cap);
+    a->buf = NULL;
+    a->cap = 0;
+    a->len = 0;
+    a->header_len = 0;
+    pool_inflate_put(a->zs);
+    a->zs = NULL;
+}
+
+void http_attempt_free(http_attempt_t *a) {
+    http_attempt_cancel(a);
+}
+
+char *http_attempt_body(http_attempt_t *a, int *status) {
+    if (a->state != HTTP_DONE || a->header_len == 0) {
+        return NULL;
+    }
+    if (status != NULL) {
+        *status = a->status;
+    }
+
+    // 检查状态码，非200直接失败，不再去解析错误页
+    if (a->status != 200) {
+        printf("天气服务器返回错误状态: %d\n", a->status);
+        return NULL;
+    }
+
+    // 跳过可能的空白字符
+    char *body = a->buf + a->header_len;
+    while (*body && isspace((unsigned char)*body)) {
+        body++;
+    }
+    return body;
+}
@@ -0,0 +1,74 @@
+#ifndef _WEATHER_HTTP_H
+#define _WEATHER_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+// 单次非阻塞HTTP请求（一个"尝试"）
+// 由调用者用poll/epoll驱动：按http_attempt_events()关注事件，就绪后调用http_attempt_step()。
+// 响应缓冲和解压流从当前线程的缓冲池借用，尝试取消时归还，稳态下收发不做堆分配。
+typedef enum {
+    HTTP_IDLE,          // 未开始/已取消
+    HTTP_CONNECTING,    // 非阻塞connect进行中
+    HTTP_SENDING,       // 发送请求
+    HTTP_RECEIVING,     // 接收响应直到对端关闭
+    HTTP_DONE,          // 收到完整响应
+    HTTP_FAILED         // 连接或收发失败
+} http_state_t;
+
+typedef struct {
+    int fd;
+    http_state_t state;
+    const char *request;    // 请求报文（不拷贝，调用者保证有效）
+    size_t req_len;
+    size_t req_sent;
+    char *buf;              // 响应缓冲（从线程缓冲池借用）
+    size_t len;
+    size_t cap;
+    double start_ms;        // 开始时间（单调时钟）
+    double connect_ms;      // 连接建立耗时，0表示尚未建立
+    int addr_index;         // 使用的是第几个解析地址，供统计用
+
+    // 响应边收边解码：响应头原样留在buf开头，响应体去掉分块、解压后直接接在后面，
+    // 解码结果就是JSON解析器的输入，没有中间的压缩体/分块体缓冲
+    size_t header_len;      // 响应头长度（含空行），0表示响应头还没收完
+    int status;             // HTTP状态码
+    bool chunked;           // Transfer-Encoding: chunked
+    bool gzip;              // Content-Encoding: gzip/deflate
+    int chunk_state;        // 分块解码状态
+    size_t chunk_left;      // 当前块（或块后\r\n）剩余字节
+    char chunk_line[20];    // 正在接收的块大小行
+    size_t chunk_line_len;
+    void *zs;               // 解压流（z_stream，从线程缓冲池借用）
+    bool z_end;             // 压缩流已完整结束
+    size_t rx_bytes;        // 本次从网络收到的原始字节数
+} http_attempt_t;
+
+// 单调时钟毫秒数
+double http_now_ms(void);
+
+// 发起非阻塞连接，成功返回0（状态变为CONNECTING或SENDING），失败返回-1（状态为FAILED）
+int http_attempt_start(http_attempt_t *a, const struct sockaddr *addr, socklen_t addr_len,
+                       const char *request, size_t req_len);
+
+// 当前状态需要关注的poll事件
+short http_attempt_events(const http_attempt_t *a);
+
+// 事件就绪后推进状态机，返回新状态
+http_state_t http_attempt_step(http_attempt_t *a, short revents);
+
+// 取消（关闭连接），缓冲和解压流还给线程缓冲池；之后响应体不再有效
+void http_attempt_cancel(http_attempt_t *a);
+
+// 销毁前调用，同http_attempt_cancel
+void http_attempt_free(http_attempt_t *a);
+
+// 请求头中声明可接受的压缩格式
+#define HTTP_ACCEPT_ENCODING "gzip, deflate"
+
+// 取完整响应（HTTP_DONE）的响应体：检查状态码，返回已解码的响应体（以'\0'结尾），
+// 非200或失败返回NULL；status可为NULL
+char *http_attempt_body(http_attempt_t *a, int *status);
+
+#endif
@@ -0,0 +1,277 @@
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "forecast.h"
+#include "weather_prefetch.h"
+
+#define PREFETCH_MIN_HITS   2       // 至少被请求过这么多次才预取，避免为偶发城市浪费预算
+#define PREFETCH_TICK_MS    1000    // 调度周期
+
+typedef struct {
+    char city[WEATHER_CACHE_KEY_LEN];
+    uint32_t count;                 // 最近一次更新时的sketch估计值
+} hot_city_t;
+
+struct weather_prefetch {
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    uint32_t sketch[PREFETCH_SKETCH_DEPTH][PREFETCH_SKETCH_WIDTH];
+    hot_city_t hot[PREFETCH_HOT_MAX];
+    int hot_num;
+    time_t last_decay;
+
+    weather_cache_t *cache;
+    weather_client_t *wc;           // 预取线程专用的查询上下文
+    int budget_rpm;                 // 每分钟预取预算
+    double tokens;                  // 令牌桶余额
+    struct timespec last_refill;
+
+    pthread_t tid;
+    bool running;
+};
+
+// FNV-1a哈希，每行用不同种子
+static uint32_t sketch_hash(const char *s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static double elapsed_sec(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+weather_prefetch_t *weather_prefetch_create(weather_cache_t *cache, int budget_rpm) {
+    if (cache == NULL || budget_rpm <= 0) {
+        return NULL;
+    }
+
+    weather_prefetch_t *pf = calloc(1, sizeof(*pf));
+    if (pf == NULL) {
+        return NULL;
+    }
+
+    pf->wc = weather_client_create(NULL, cache);
+    if (pf->wc == NULL) {
+        free(pf);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pf->lock, NULL);
+    pthread_cond_init(&pf->wakeup, NULL);
+    pf->cache = cache;
+    pf->budget_rpm = budget_rpm;
+    pf->tokens = 1;
+    clock_gettime(CLOCK_MONOTONIC, &pf->last_refill);
+    pf->last_decay = pf->last_refill.tv_sec;
+    return pf;
+}
+
+void weather_prefetch_destroy(weather_prefetch_t *pf) {
+    if (pf == NULL) {
+        return;
+    }
+    weather_prefetch_stop(pf);
+    weather_client_destroy(pf->wc);
+    pthread_cond_destroy(&pf->wakeup);
+    pthread_mutex_destroy(&pf->lock);
+    free(pf);
+}
+
+void weather_prefetch_record(weather_prefetch_t *pf, const char *city) {
+    if (pf == NULL || city == NULL || *city == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&pf->lock);
+
+    // 更新sketch，估计值取各行最小值
+    uint32_t est = UINT32_MAX;
+    for (int d = 0; d < PREFETCH_SKETCH_DEPTH; d++) {
+        uint32_t *c = &pf->sketch[d][sketch_hash(city, d) % PREFETCH_SKETCH_WIDTH];
+        if (*c < UINT32_MAX) {
+            (*c)++;
+        }
+        if (*c < est) {
+            est = *c;
+        }
+    }
+
+    // 更新热门表：已在表中则刷新计数，否则替换计数最小的条目
+    int slot = -1, min_slot = 0;
+    for (int i = 0; i < pf->hot_num; i++) {
+        if (strcmp(pf->hot[i].city, city) == 0) {
+            slot = i;
+            break;
+        }
+        if (pf->hot[i].count < pf->hot[min_slot].count) {
+            min_slot = i;
+        }
+    }
+    if (slot < 0) {
+        if (pf->hot_num < PREFETCH_HOT_MAX) {
+            slot = pf->hot_num++;
+        } else if (est > pf->hot[min_slot].count) {
+            slot = min_slot;
+        }
+        if (slot >= 0) {
+            snprintf(pf->hot[slot].city, sizeof(pf->hot[slot].city), "%s", city);
+        }
+    }
+    if (slot >= 0) {
+        pf->hot[slot].count = est;
+    }
+
+    pthread_mutex_unlock(&pf->lock);
+}
+
+// 计数减半，让热度随时间衰减，调用者需持有锁
+static void decay_counts(weather_prefetch_t *pf) {
+    for (int d = 0; d < PREFETCH_SKETCH_DEPTH; d++) {
+        for (int w = 0; w < PREFETCH_SKETCH_WIDTH; w++) {
+            pf->sketch[d][w] >>= 1;
+        }
+    }
+    for (int i = 0; i < pf->hot_num; i++) {
+        pf->hot[i].count >>= 1;
+    }
+}
+
+static int cmp_hot_desc(const void *a, const void *b) {
+    const hot_city_t *x = a, *y = b;
+    return (x->count < y->count) - (x->count > y->count);
+}
+
+// 一个调度周期：补充令牌，按热度从高到低刷新快过期的城市
+static void prefetch_tick(weather_prefetch_t *pf) {
+    hot_city_t snapshot[PREFETCH_HOT_MAX];
+    int num;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&pf->lock);
+    if (now.tv_sec - pf->last_decay >= PREFETCH_DECAY_SEC) {
+        decay_counts(pf);
+        pf->last_decay = now.tv_sec;
+    }
+
+    // 令牌桶：每分钟补充budget_rpm个，最多积攒10秒的量（至少1个）
+    double burst = pf->budget_rpm / 6.0;
+    if (burst < 1) {
+        burst = 1;
+    }
+    pf->tokens += elapsed_sec(&pf->last_refill, &now) * pf->budget_rpm / 60.0;
+    if (pf->tokens > burst) {
+        pf->tokens = burst;
+    }
+    pf->last_refill = now;
+
+    num = pf->hot_num;
+    memcpy(snapshot, pf->hot, num * sizeof(hot_city_t));
+    pthread_mutex_unlock(&pf->lock);
+
+    qsort(snapshot, num, sizeof(hot_city_t), cmp_hot_desc);
+
+    for (int i = 0; i < num; i++) {
+        if (snapshot[i].count < PREFETCH_MIN_HITS) {
+            break;
+        }
+
+        int left = weather_cache_ttl_left(pf->cache, snapshot[i].city);
+        if (left >= PREFETCH_LEAD_SEC) {
+            continue;
+        }
+
+        // 先切换城市，切换失败（名字无法解析或已被负缓存）时跳过，不花令牌，也不会去查上一个城市
+        if (weather_client_set_city(pf->wc, snapshot[i].city) != 0) {
+            continue;
+        }
+
+        // running和令牌都在锁内读，weather_prefetch_stop之后不再发起新的查询
+        pthread_mutex_lock(&pf->lock);
+        bool allowed = pf->running && pf->tokens >= 1;
+        if (allowed) {
+            pf->tokens -= 1;
+        }
+        pthread_mutex_unlock(&pf->lock);
+        if (!allowed) {
+            break;
+        }
+
+        printf("预取热门城市: %s (热度: %u, 剩余有效期: %d秒)\n",
+               snapshot[i].city, snapshot[i].count, left);
+        weather_record_t rec;
+        weather_client_refresh(pf->wc, &rec);
+    }
+}
+
+static void *prefetch_thread_func(void *arg) {
+    weather_prefetch_t *pf = arg;
+
+    pthread_mutex_lock(&pf->lock);
+    while (pf->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += PREFETCH_TICK_MS / 1000;
+        pthread_cond_timedwait(&pf->wakeup, &pf->lock, &deadline);
+        if (!pf->running) {
+            break;
+        }
+        pthread_mutex_unlock(&pf->lock);
+        prefetch_tick(pf);
+        pthread_mutex_lock(&pf->lock);
+    }
+    pthread_mutex_unlock(&pf->lock);
+    return NULL;
+}
+
+int weather_prefetch_start(weather_prefetch_t *pf) {
+    if (pf == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pf->lock);
+    bool was_running = pf->running;
+    pf->running = true;
+    pthread_mutex_unlock(&pf->lock);
+    if (was_running) {
+        return -1;
+    }
+
+    int ret = pthread_create(&pf->tid, NULL, prefetch_thread_func, pf);
+    if (ret != 0) {
+        pthread_mutex_lock(&pf->lock);
+        pf->running = false;
+        pthread_mutex_unlock(&pf->lock);
+        printf("创建预取线程失败: %s\n", strerror(ret));
+        return -1;
+    }
+
+    printf("预取调度器已启动，预算: %d次/分钟\n", pf->budget_rpm);
+    return 0;
+}
+
+void weather_prefetch_stop(weather_prefetch_t *pf) {
+    if (pf == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pf->lock);
+    bool was_running = pf->running;
+    pf->running = false;
+    pthread_cond_signal(&pf->wakeup);
+    pthread_mutex_unlock(&pf->lock);
+
+    if (was_running) {
+        pthread_join(pf->tid, NULL);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef _WEATHER_PREFETCH_H
+#define _WEATHER_PREFETCH_H
+
+#include "weather_cache.h"
+
+#define PREFETCH_SKETCH_DEPTH   4       // count-min sketch 行数
+#define PREFETCH_SKETCH_WIDTH   256     // 每行计数器个数
+#define PREFETCH_HOT_MAX        16      // 跟踪的热门城市数
+#define PREFETCH_LEAD_SEC       60      // 缓存过期前多少秒开始预取
+#define PREFETCH_DECAY_SEC      600     // 每隔多少秒把所有计数减半（老化）
+
+// 热门城市预取调度器
+// 按城市统计请求频率（count-min sketch + 小型热门表），后台线程在热门城市的
+// 缓存条目即将过期时提前刷新，预取速率受每分钟请求预算限制。
+typedef struct weather_prefetch weather_prefetch_t;
+
+// 创建调度器：cache为要刷新的共享缓存，budget_rpm为每分钟最多预取请求数
+weather_prefetch_t *weather_prefetch_create(weather_cache_t *cache, int budget_rpm);
+
+// 启动/停止后台预取线程
+int weather_prefetch_start(weather_prefetch_t *pf);
+void weather_prefetch_stop(weather_prefetch_t *pf);
+
+// 销毁调度器（会先停止线程）
+void weather_prefetch_destroy(weather_prefetch_t *pf);
+
+// 记录一次用户查询
+void weather_prefetch_record(weather_prefetch_t *pf, const char *city);
+
+#endif
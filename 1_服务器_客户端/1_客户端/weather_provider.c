@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "weather_provider.h"
+#include "weather_decode.h"
+
+#define SENIVERSE_API_KEY "SK4cNZ6Q9wXmiwJ0r"
+
+// 风向角度转中文八方位
+static void wind_direction_text(uint16_t degree, char *out, size_t out_len) {
+    static const char *names[] = {"北", "东北", "东", "东南", "南", "西南", "西", "西北"};
+    if(degree == WEATHER_RECORD_NONE_U16) {
+        return;
+    }
+    snprintf(out, out_len, "%s", names[((degree * 2 + 45) / 90) % 8]);
+}
+
+// 风速(km/h)换算蒲福风级
+static uint8_t wind_scale_from_kmh(uint16_t speed_x10) {
+    static const uint16_t upper_x10[] = {10, 60, 120, 200, 290, 390, 500, 620, 750, 890, 1030, 1180};
+    if(speed_x10 == WEATHER_RECORD_NONE_U16) {
+        return WEATHER_RECORD_NONE_U8;
+    }
+    uint8_t scale = 0;
+    while(scale < sizeof(upper_x10) / sizeof(upper_x10[0]) && speed_x10 >= upper_x10[scale]) {
+        scale++;
+    }
+    return scale;
+}
+
+// ---------------- 心知天气 api.seniverse.com ----------------
+
+static int seniverse_now_path(const city_info_t *city, const char *key, char *path, size_t len) {
+    char location[192];
+    if(city_percent_encode(city->id, location, sizeof(location)) < 0) {
+        return -1;
+    }
+    int n = snprintf(path, len, "/v3/weather/now.json?key=%s&location=%s&language=zh-Hans&unit=c", key, location);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+static int seniverse_decode_now(const char *body, weather_record_t *rec) {
+    seniverse_now_t now;
+    if(seniverse_now_decode(body, strlen(body), &now) != 0) {
+        printf("JSON解析失败\n");
+        return -1;
+    }
+
+    memcpy(rec->city_id, now.location_id, sizeof(rec->city_id));
+    memcpy(rec->city_name, now.city_name, sizeof(rec->city_name));
+    memcpy(rec->text, now.text, sizeof(rec->text));
+    memcpy(rec->wind_direction, now.wind_direction, sizeof(rec->wind_direction));
+    rec->temp_x10 = now.temperature;
+    rec->code = now.code;
+    rec->humidity = now.humidity;
+    rec->wind_scale = now.wind_scale;
+    rec->wind_speed_x10 = now.wind_speed;
+    if(now.wind_degree < 360) {
+        rec->wind_degree = now.wind_degree;
+    }
+    rec->updated = now.last_update;
+    return 0;
+}
+
+// ---------------- wttr.in（无需密钥） ----------------
+
+// WorldWeatherOnline天气代码 -> 心知天气代码
+static uint8_t wttr_code(int code) {
+    static const struct { int16_t wwo; uint8_t code; } table[] = {
+        {113, 0}, {116, 5}, {119, 4}, {122, 9}, {143, 30}, {248, 30}, {260, 30},
+        {176, 10}, {263, 13}, {266, 13}, {293, 13}, {296, 13}, {353, 10},
+        {299, 14}, {302, 14}, {356, 14}, {305, 15}, {308, 16}, {359, 16},
+        {200, 11}, {386, 11}, {389, 11}, {392, 11}, {395, 25},
+        {179, 22}, {227, 24}, {230, 25}, {323, 22}, {326, 22}, {368, 21},
+        {329, 23}, {332, 23}, {371, 21}, {335, 24}, {338, 24},
+        {182, 20}, {185, 19}, {281, 19}, {284, 19}, {311, 19}, {314, 19},
+        {317, 20}, {320, 20}, {350, 20}, {362, 20}, {365, 20}, {374, 20}, {377, 20},
+    };
+    for(size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if(table[i].wwo == code) {
+            return table[i].code;
+        }
+    }
+    return 99;
+}
+
+static int wttr_now_path(const city_info_t *city, const char *key, char *path, size_t len) {
+    (void)key;
+    char location[192];
+    if(city_percent_encode(city->query, location, sizeof(location)) < 0) {
+        return -1;
+    }
+    int n = snprintf(path, len, "/%s?format=j1&lang=zh", location);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+static int wttr_decode_now(const char *body, weather_record_t *rec) {
+    wttr_now_t now;
+    if(wttr_now_decode(body, strlen(body), &now) != 0) {
+        printf("wttr响应解析失败\n");
+        return -1;
+    }
+
+    // 优先取中文描述
+    memcpy(rec->text, now.text_zh[0] != '\0' ? now.text_zh : now.text_en, sizeof(rec->text));
+    if(now.code != JSON_NONE_U16) {
+        rec->code = wttr_code(now.code);
+    }
+    rec->temp_x10 = now.temperature;
+    rec->humidity = now.humidity;
+    rec->wind_speed_x10 = now.wind_speed;
+    rec->wind_scale = wind_scale_from_kmh(rec->wind_speed_x10);
+    if(now.wind_degree < 360) {
+        rec->wind_degree = now.wind_degree;
+    }
+    wind_direction_text(rec->wind_degree, rec->wind_direction, sizeof(rec->wind_direction));
+    // localObsDateTime不带时区，更新时间记为未知
+    return 0;
+}
+
+// ---------------- OpenWeatherMap（需要密钥） ----------------
+
+// OpenWeatherMap天气代码 -> 心知天气代码
+static uint8_t owm_code(int id) {
+    switch(id / 100) {
+        case 2: return 11;
+        case 3: return 13;
+        case 5:
+            if(id == 500) return 13;
+            if(id == 501) return 14;
+            if(id <= 504) return id == 502 ? 15 : 16;
+            if(id == 511) return 19;
+            return 10;
+        case 6:
+            if(id == 600) return 22;
+            if(id == 601) return 23;
+            if(id == 602) return 24;
+            if(id >= 620) return 21;
+            return 20;
+        case 7:
+            if(id == 701 || id == 741) return 30;
+            if(id == 711 || id == 721) return 31;
+            if(id == 771 || id == 781) return 32;
+            return 26;
+        case 8:
+            if(id == 800) return 0;
+            if(id == 801) return 5;
+            return id == 804 ? 9 : 4;
+        default:
+            return 99;
+    }
+}
+
+static int owm_now_path(const city_info_t *city, const char *key, char *path, size_t len) {
+    char location[192];
+    if(city_percent_encode(city->query, location, sizeof(location)) < 0) {
+        return -1;
+    }
+    int n = snprintf(path, len, "/data/2.5/weather?q=%s&appid=%s&units=metric&lang=zh_cn", location, key);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+static int owm_decode_now(const char *body, weather_record_t *rec) {
+    owm_now_t now;
+    if(owm_now_decode(body, strlen(body), &now) != 0) {
+        printf("OpenWeatherMap响应解析失败\n");
+        return -1;
+    }
+
+    memcpy(rec->text, now.text, sizeof(rec->text));
+    if(now.code != JSON_NONE_U16) {
+        rec->code = owm_code(now.code);
+    }
+    rec->temp_x10 = now.temperature;
+    rec->humidity = now.humidity;
+    if(now.wind_speed != JSON_NONE_U16) {
+        rec->wind_speed_x10 = (uint16_t)((now.wind_speed * 36 + 5) / 10);     // 0.1m/s -> 0.1km/h
+        rec->wind_scale = wind_scale_from_kmh(rec->wind_speed_x10);
+    }
+    if(now.wind_degree < 360) {
+        rec->wind_degree = now.wind_degree;
+    }
+    wind_direction_text(rec->wind_degree, rec->wind_direction, sizeof(rec->wind_direction));
+    rec->updated = now.dt;
+    return 0;
+}
+
+static const weather_provider_t providers[] = {
+    {"seniverse", "api.seniverse.com", 80, SENIVERSE_API_KEY, "WEATHER_API_KEY", true,
+     seniverse_now_path, seniverse_decode_now},
+    {"wttr", "wttr.in", 80, NULL, NULL, false,
+     wttr_now_path, wttr_decode_now},
+    {"owm", "api.openweathermap.org", 80, NULL, "WEATHER_OWM_KEY", false,
+     owm_now_path, owm_decode_now},
+};
+
+const weather_provider_t *weather_provider_find(const char *name) {
+    for(size_t i = 0; i < sizeof(providers) / sizeof(providers[0]); i++) {
+        if(strcasecmp(providers[i].name, name) == 0) {
+            return &providers[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,37 @@
+#ifndef _WEATHER_PROVIDER_H
+#define _WEATHER_PROVIDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "weather_record.h"
+#include "city_resolver.h"
+
+// 天气数据提供方
+// 每个提供方只描述"怎么问"和"怎么读"：实况查询的请求路径生成和响应体解码，
+// 连接、对冲、选优都在forecast.c中统一完成。解码结果是与提供方无关的weather_record_t，
+// 天气代码统一换算成心知天气代码表，风向统一成中文八方位。
+// 响应体由gen_decoder.py根据weather_schema.json生成的解码器（weather_decode.c）单遍解码。
+#define WEATHER_KEY_LEN 64
+
+typedef struct weather_provider {
+    const char *name;               // 配置中使用的名字，如"seniverse"
+    const char *default_host;
+    int default_port;
+    const char *default_key;        // 内置API密钥，NULL表示没有
+    const char *key_env;            // 可覆盖密钥的环境变量，NULL表示不需要密钥
+    bool series;                    // 是否支持逐日/逐小时预报（目前只有心知天气）
+
+    // 生成实况查询的请求路径，返回写入长度，失败返回-1
+    int (*now_path)(const city_info_t *city, const char *key, char *path, size_t len);
+
+    // 把实况响应体解码成天气记录，成功返回0。上游返回了地点ID就填进city_id，调用者据此学习地点ID后
+    // 再改写成规范ID；city_name缺失时调用者补中文名
+    int (*decode_now)(const char *body, weather_record_t *rec);
+} weather_provider_t;
+
+// 按名字查找提供方，未知返回NULL
+const weather_provider_t *weather_provider_find(const char *name);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef _WEATHER_RECORD_H
+#define _WEATHER_RECORD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// 天气记录：客户端A -> 服务器 -> 客户端B/客户端C -> FIFO -> 云平台上报 全程传输的定长二进制结构
+// 数值字段直接是数字，只有要显示的屏幕（客户端B、日志）才调用weather_record_format()转成文本，
+// 中间环节不再反复"格式化成文本 -> 按行解析 -> 拼JSON -> 再解析JSON"。
+// 所有成员自然对齐、无填充，按主机字节序传输（开发板与服务器均为小端）。
+// 网关（huaweicloud-iot-device-quickstart）直接包含本头文件，所以这里只放类型和内联函数。
+
+#define WEATHER_RECORD_MAGIC    0x31525457u     // "WTR1"
+#define WEATHER_RECORD_VERSION  1
+
+#define WEATHER_RECORD_ID_LEN   16      // 规范地点ID（city_resolver中的拼音ID）
+#define WEATHER_RECORD_NAME_LEN 24      // 城市中文名（UTF-8）
+#define WEATHER_RECORD_TEXT_LEN 24      // 天气现象文字
+#define WEATHER_RECORD_WIND_LEN 16      // 风向文字
+#define WEATHER_RECORD_FORMAT_LEN 256   // weather_record_format()输出缓冲的建议大小
+
+#define WEATHER_RECORD_NONE_I16 INT16_MIN
+#define WEATHER_RECORD_NONE_U16 0xffff
+#define WEATHER_RECORD_NONE_U8  0xff
+
+typedef struct {
+    uint32_t magic;                         // WEATHER_RECORD_MAGIC
+    uint8_t version;                        // WEATHER_RECORD_VERSION
+    uint8_t code;                           // 天气代码（心知天气代码表 0-99）
+    uint8_t humidity;                       // 相对湿度 %
+    uint8_t wind_scale;                     // 风力等级
+    int16_t temp_x10;                       // 温度 0.1°C
+    uint16_t wind_speed_x10;                // 风速 0.1km/h
+    uint16_t wind_degree;                   // 风向角度 0-359
+    uint16_t reserved;
+    uint32_t updated;                       // 上游数据更新时间（Unix秒），0表示未知
+    char city_id[WEATHER_RECORD_ID_LEN];
+    char city_name[WEATHER_RECORD_NAME_LEN];
+    char text[WEATHER_RECORD_TEXT_LEN];
+    char wind_direction[WEATHER_RECORD_WIND_LEN];
+} weather_record_t;
+
+_Static_assert(sizeof(weather_record_t) == 100, "weather_record_t必须是100字节且无填充");
+
+// 初始化为"无数据"
+static inline void weather_record_init(weather_record_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = WEATHER_RECORD_MAGIC;
+    rec->version = WEATHER_RECORD_VERSION;
+    rec->code = WEATHER_RECORD_NONE_U8;
+    rec->humidity = WEATHER_RECORD_NONE_U8;
+    rec->wind_scale = WEATHER_RECORD_NONE_U8;
+    rec->temp_x10 = WEATHER_RECORD_NONE_I16;
+    rec->wind_speed_x10 = WEATHER_RECORD_NONE_U16;
+    rec->wind_degree = WEATHER_RECORD_NONE_U16;
+}
+
+// 判断收到的len字节是否是一条完整有效的天气记录
+static inline bool weather_record_check(const void *data, size_t len) {
+    const weather_record_t *rec = data;
+    if (data == NULL || len != sizeof(weather_record_t) ||
+        rec->magic != WEATHER_RECORD_MAGIC || rec->version != WEATHER_RECORD_VERSION) {
+        return false;
+    }
+    // 字符串字段必须以'\0'结尾
+    return rec->city_id[WEATHER_RECORD_ID_LEN - 1] == '\0' &&
+           rec->city_name[WEATHER_RECORD_NAME_LEN - 1] == '\0' &&
+           rec->text[WEATHER_RECORD_TEXT_LEN - 1] == '\0' &&
+           rec->wind_direction[WEATHER_RECORD_WIND_LEN - 1] == '\0';
+}
+
+// 渲染成给人看的文本（与原先客户端A发送的文本格式一致），返回写入长度
+static inline int weather_record_format(const weather_record_t *rec, char *out, size_t out_len) {
+    char temp[16] = "N/A", humidity[8] = "N/A", speed[16] = "N/A", scale[8] = "N/A";
+
+    if (rec->temp_x10 != WEATHER_RECORD_NONE_I16) {
+        if (rec->temp_x10 % 10 == 0) {
+            snprintf(temp, sizeof(temp), "%d", rec->temp_x10 / 10);
+        } else {
+            snprintf(temp, sizeof(temp), "%.1f", rec->temp_x10 / 10.0);
+        }
+    }
+    if (rec->humidity != WEATHER_RECORD_NONE_U8) {
+        snprintf(humidity, sizeof(humidity), "%u", rec->humidity);
+    }
+    if (rec->wind_speed_x10 != WEATHER_RECORD_NONE_U16) {
+        snprintf(speed, sizeof(speed), "%.1f", rec->wind_speed_x10 / 10.0);
+    }
+    if (rec->wind_scale != WEATHER_RECORD_NONE_U8) {
+        snprintf(scale, sizeof(scale), "%u", rec->wind_scale);
+    }
+
+    return snprintf(out, out_len,
+                    " 城市: %s\n"
+                    " 天气: %s\n"
+                    " 温度: %s°C\n"
+                    " 湿度: %s%%\n"
+                    " 风向: %s\n"
+                    " 风速: %s\n"
+                    " 风力: %s\n",
+                    rec->city_name, rec->text, temp, humidity,
+                    rec->wind_direction[0] ? rec->wind_direction : "N/A", speed, scale);
+}
+
+#endif
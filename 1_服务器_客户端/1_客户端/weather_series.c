@@ -0,0 +1,170 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "weather_series.h"
+
+struct weather_series_store {
+    pthread_mutex_t lock;
+    int capacity;
+    weather_series_t *slots;    // city[0]=='\0' 表示空槽
+};
+
+static time_t now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+weather_series_store_t *weather_series_store_create(int capacity) {
+    if (capacity <= 0) {
+        return NULL;
+    }
+
+    weather_series_store_t *store = calloc(1, sizeof(*store));
+    if (store == NULL) {
+        return NULL;
+    }
+
+    store->slots = calloc(capacity, sizeof(weather_series_t));
+    if (store->slots == NULL) {
+        free(store);
+        return NULL;
+    }
+
+    pthread_mutex_init(&store->lock, NULL);
+    store->capacity = capacity;
+    return store;
+}
+
+void weather_series_store_destroy(weather_series_store_t *store) {
+    if (store == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&store->lock);
+    free(store->slots);
+    free(store);
+}
+
+// 查找城市槽位，调用者需持有锁
+static weather_series_t *find_slot(weather_series_store_t *store, const char *city) {
+    for (int i = 0; i < store->capacity; i++) {
+        if (store->slots[i].city[0] != '\0' && strcmp(store->slots[i].city, city) == 0) {
+            return &store->slots[i];
+        }
+    }
+    return NULL;
+}
+
+void weather_series_store_put(weather_series_store_t *store, const weather_series_t *series) {
+    if (store == NULL || series == NULL || series->city[0] == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    weather_series_t *slot = find_slot(store, series->city);
+    if (slot == NULL) {
+        // 优先空槽，否则替换最久未更新的城市
+        slot = &store->slots[0];
+        for (int i = 0; i < store->capacity; i++) {
+            if (store->slots[i].city[0] == '\0') {
+                slot = &store->slots[i];
+                break;
+            }
+            if (store->slots[i].updated < slot->updated) {
+                slot = &store->slots[i];
+            }
+        }
+    }
+    *slot = *series;
+    slot->updated = now_sec();
+    pthread_mutex_unlock(&store->lock);
+}
+
+int weather_series_store_age(weather_series_store_t *store, const char *city) {
+    if (store == NULL || city == NULL) {
+        return -1;
+    }
+
+    int age = -1;
+    pthread_mutex_lock(&store->lock);
+    weather_series_t *slot = find_slot(store, city);
+    if (slot != NULL) {
+        age = (int)(now_sec() - slot->updated);
+    }
+    pthread_mutex_unlock(&store->lock);
+    return age;
+}
+
+int weather_series_store_hours(weather_series_store_t *store, const char *city,
+                               int32_t from_hour, int count, weather_hours_view_t *out) {
+    if (store == NULL || city == NULL || out == NULL || count < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    weather_series_t *s = find_slot(store, city);
+    if (s == NULL) {
+        pthread_mutex_unlock(&store->lock);
+        return -1;
+    }
+
+    // 计算区间在列内的起点和长度，每列一次memcpy；起点超出已存范围时返回0小时，起点仍落在列内
+    int64_t offset = (int64_t)from_hour - s->hour0;
+    int start = offset < 0 ? 0 : (offset > s->hour_num ? s->hour_num : (int)offset);
+    int n = s->hour_num - start;
+    if (n > count) {
+        n = count;
+    }
+    if (n < 0) {
+        n = 0;
+    }
+
+    out->hour0 = s->hour0 + start;
+    out->count = (uint8_t)n;
+    memcpy(out->temp, s->hour_temp + start, n * sizeof(out->temp[0]));
+    memcpy(out->code, s->hour_code + start, n * sizeof(out->code[0]));
+    memcpy(out->humidity, s->hour_humidity + start, n * sizeof(out->humidity[0]));
+    memcpy(out->wind_x10, s->hour_wind_x10 + start, n * sizeof(out->wind_x10[0]));
+    pthread_mutex_unlock(&store->lock);
+    return n;
+}
+
+// Howard Hinnant的days_from_civil算法，不依赖时区和libc
+int32_t weather_series_days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = (unsigned)(year - era * 400);
+    unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+int32_t weather_series_parse_day(const char *text) {
+    int y, m, d;
+    if (text == NULL || sscanf(text, "%4d-%2d-%2d", &y, &m, &d) != 3) {
+        return -1;
+    }
+    return weather_series_days_from_civil(y, m, d);
+}
+
+int32_t weather_series_parse_hour(const char *text) {
+    int y, m, d, h;
+    if (text == NULL || sscanf(text, "%4d-%2d-%2dT%2d", &y, &m, &d, &h) != 4) {
+        return -1;
+    }
+    return weather_series_days_from_civil(y, m, d) * 24 + h;
+}
+
+uint32_t weather_series_parse_time(const char *text) {
+    int y, mon, d, h, min, sec, oh = 0, om = 0;
+    char sign = '+';
+    if (text == NULL ||
+        sscanf(text, "%d-%d-%dT%d:%d:%d%c%d:%d", &y, &mon, &d, &h, &min, &sec, &sign, &oh, &om) < 6) {
+        return 0;
+    }
+    long offset = (oh * 60L + om) * 60 * (sign == '-' ? -1 : 1);
+    return (uint32_t)(weather_series_days_from_civil(y, mon, d) * 86400L + h * 3600L + min * 60L + sec - offset);
+}
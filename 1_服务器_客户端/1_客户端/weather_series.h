@@ -0,0 +1,84 @@
+#ifndef _WEATHER_SERIES_H
+#define _WEATHER_SERIES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define SERIES_DAYS_MAX     15      // 逐日预报最多保存天数
+#define SERIES_HOURS_MAX    72      // 逐小时预报最多保存小时数
+#define SERIES_CITY_LEN     64
+#define SERIES_NONE_U8      0xff    // 无数据（上游字段为空）
+#define SERIES_NONE_I8      INT8_MIN
+#define SERIES_NONE_U16     0xffff
+
+// 单个城市的预报时间序列，定宽列式存储（struct-of-arrays）
+// 每一列是连续数组，取"未来24小时"之类的区间时每列一次memcpy即可，不经过cJSON或字符串。
+// 时间都按上游返回的当地时间计：day0为自1970-01-01起的天数，hour0为自1970-01-01 00:00起的小时数。
+//
+// 内存占用（每城市每天）：
+//   逐日   high 1 + low 1 + code_day 1 + code_night 1 + humidity 1 + wind_scale 1 + rainfall 2 = 8字节
+//   逐小时 (temperature 1 + code 1 + humidity 1 + wind_speed 2) x 24 = 120字节
+//   合计 128字节/城市日；整个结构体 sizeof(weather_series_t) = 568字节/城市（x86_64）。
+typedef struct {
+    char city[SERIES_CITY_LEN];
+
+    // 逐日
+    int32_t day0;
+    uint8_t day_num;
+    int8_t high[SERIES_DAYS_MAX];             // 最高温 °C
+    int8_t low[SERIES_DAYS_MAX];              // 最低温 °C
+    uint8_t code_day[SERIES_DAYS_MAX];        // 白天天气代码（心知天气代码表 0-99）
+    uint8_t code_night[SERIES_DAYS_MAX];      // 夜间天气代码
+    uint8_t humidity[SERIES_DAYS_MAX];        // 相对湿度 %
+    uint8_t wind_scale[SERIES_DAYS_MAX];      // 风力等级
+    uint16_t rainfall_x10[SERIES_DAYS_MAX];   // 降水量 0.1mm
+
+    // 逐小时
+    int32_t hour0;
+    uint8_t hour_num;
+    int8_t hour_temp[SERIES_HOURS_MAX];       // 温度 °C
+    uint8_t hour_code[SERIES_HOURS_MAX];      // 天气代码
+    uint8_t hour_humidity[SERIES_HOURS_MAX];  // 相对湿度 %
+    uint16_t hour_wind_x10[SERIES_HOURS_MAX]; // 风速 0.1km/h
+
+    time_t updated;                           // 最近一次写入时间（单调时钟秒）
+} weather_series_t;
+
+// 一段逐小时预报的拷贝，供界面直接使用
+typedef struct {
+    int32_t hour0;
+    uint8_t count;
+    int8_t temp[SERIES_HOURS_MAX];
+    uint8_t code[SERIES_HOURS_MAX];
+    uint8_t humidity[SERIES_HOURS_MAX];
+    uint16_t wind_x10[SERIES_HOURS_MAX];
+} weather_hours_view_t;
+
+// 多城市预报存储（线程安全）
+typedef struct weather_series_store weather_series_store_t;
+
+weather_series_store_t *weather_series_store_create(int capacity);
+void weather_series_store_destroy(weather_series_store_t *store);
+
+// 写入/替换某个城市的整条序列
+void weather_series_store_put(weather_series_store_t *store, const weather_series_t *series);
+
+// 某城市序列距上次写入的秒数，不存在返回-1
+int weather_series_store_age(weather_series_store_t *store, const char *city);
+
+// 取从from_hour开始的count个小时（不足时按实际数量），返回拷贝的小时数，城市不存在返回-1
+int weather_series_store_hours(weather_series_store_t *store, const char *city,
+                               int32_t from_hour, int count, weather_hours_view_t *out);
+
+// 日期/时间换算：公历日期转自1970-01-01起的天数
+int32_t weather_series_days_from_civil(int year, int month, int day);
+
+// 解析 "2025-10-18" 为天数，解析 "2025-10-18T15:00:00+08:00" 为小时数，失败返回-1
+int32_t weather_series_parse_day(const char *text);
+int32_t weather_series_parse_hour(const char *text);
+
+// 解析 "2025-10-18T14:20:00+08:00" 为Unix秒（按时区偏移换算），失败返回0
+uint32_t weather_series_parse_time(const char *text);
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef _WEATHER_SHM_H
+#define _WEATHER_SHM_H
+
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "weather_record.h"
+
+// 同机共享的最新天气表
+// 客户端A（可以是多个进程）把每次从上游拿到的天气记录写进一块POSIX共享内存，每个城市一个槽；
+// 同一台机器上的读者（网关AgentLiteDemo、屏幕程序）只读映射后直接读，不经过服务器转发和FIFO。
+// 槽用序号锁（seqlock）保护：写者把序号改成奇数、写数据、再改回偶数；读者前后两次读到同一个偶数序号
+// 才算读到完整记录，否则重读。读者不加锁、不做系统调用，也不写共享内存，崩溃不会影响表；
+// 写者之间用每个槽的写者PID互斥：只被抢占的写者会被一直等到写完，序号只增不减；
+// 只有确认写者进程已不存在（kill(pid, 0)报ESRCH）时，下一个写者才接管它留下的奇数序号。
+// 与weather_record.h一样，网关直接包含本头文件，所以这里只放类型和内联函数。
+
+#define WEATHER_SHM_NAME        "/weather_shm"
+#define WEATHER_SHM_MAGIC       0x31485357u     // "WSH1"
+#define WEATHER_SHM_VERSION     2
+#define WEATHER_SHM_SLOTS       512     // 城市槽数（开放寻址，城市数应明显少于槽数）
+#define WEATHER_SHM_READ_TRIES  64      // 读者重读次数上限，超过视为写者卡住，本次读失败
+#define WEATHER_SHM_CHECK_SPINS 1000    // 写者每等这么多轮检查一次占着槽的写者进程是否还在
+
+#define WEATHER_SHM_HASH_EMPTY  0u      // 空槽
+#define WEATHER_SHM_HASH_CLAIM  1u      // 正在被某个写者占用，城市ID还没写完
+
+typedef struct {
+    _Atomic uint32_t seq;               // 偶数：稳定；奇数：正在写；0表示还没有写过
+    _Atomic uint32_t hash;              // 城市ID的哈希（最高位置1），槽一旦分配给某个城市就不再改变
+    char city_id[WEATHER_RECORD_ID_LEN];  // 槽所属的城市，在发布hash之前写好
+    weather_record_t rec;
+    uint32_t stored;                    // 写入时间（Unix秒），和rec一起受seq保护
+} weather_shm_slot_t;
+
+_Static_assert(sizeof(weather_shm_slot_t) == 128, "weather_shm_slot_t应为128字节，两个槽不共享缓存行");
+
+typedef struct {
+    _Atomic uint32_t magic;             // 初始化完成后才写入WEATHER_SHM_MAGIC
+    uint32_t version;
+    uint32_t slot_num;
+    uint32_t slot_size;
+    _Atomic uint32_t latest;            // 最近写入的槽下标+1，0表示还没有数据
+    _Atomic uint32_t city_num;          // 已分配的槽数
+    uint8_t reserved[104];
+    weather_shm_slot_t slots[WEATHER_SHM_SLOTS];
+    _Atomic int32_t writer[WEATHER_SHM_SLOTS];  // 各槽正在写的写者进程PID，0表示没有写者（读者不看）
+} weather_shm_t;
+
+// 城市ID的哈希（FNV-1a），最高位置1以区别于空槽和占用中标记
+static inline uint32_t weather_shm_hash(const char *city_id) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)city_id; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h | 0x80000000u;
+}
+
+static inline bool weather_shm_valid(const weather_shm_t *shm) {
+    return atomic_load_explicit(&shm->magic, memory_order_acquire) == WEATHER_SHM_MAGIC &&
+           shm->version == WEATHER_SHM_VERSION && shm->slot_num == WEATHER_SHM_SLOTS &&
+           shm->slot_size == sizeof(weather_shm_slot_t);
+}
+
+// 打开共享表：writable为true时不存在就创建（客户端A），false时只读映射（读者）。
+// 失败或表还没初始化完成返回NULL，读者可以稍后再试；打开之后的读写都不再有系统调用。
+static inline weather_shm_t *weather_shm_open(bool writable) {
+    int fd = shm_open(WEATHER_SHM_NAME, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (st.st_size < (off_t)sizeof(weather_shm_t) && (!writable || ftruncate(fd, sizeof(weather_shm_t)) != 0))) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, sizeof(weather_shm_t), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+    weather_shm_t *shm = addr;
+
+    if (writable) {
+        // 新建的共享内存全为0；多个写者同时打开时只有抢到的那个做初始化，其他的等它完成
+        uint32_t expect = 0;
+        if (atomic_compare_exchange_strong(&shm->magic, &expect, 1)) {
+            shm->version = WEATHER_SHM_VERSION;
+            shm->slot_num = WEATHER_SHM_SLOTS;
+            shm->slot_size = sizeof(weather_shm_slot_t);
+            atomic_store_explicit(&shm->magic, WEATHER_SHM_MAGIC, memory_order_release);
+        }
+        for (int i = 0; i < 1000 && atomic_load(&shm->magic) == 1; i++) {
+            usleep(1000);
+        }
+    }
+
+    if (!weather_shm_valid(shm)) {
+        if (writable) {
+            printf("共享天气表%s格式不匹配，请删除/dev/shm%s后重启\n", WEATHER_SHM_NAME, WEATHER_SHM_NAME);
+        }
+        munmap(addr, sizeof(weather_shm_t));
+        return NULL;
+    }
+    return shm;
+}
+
+static inline void weather_shm_close(weather_shm_t *shm) {
+    if (shm != NULL) {
+        munmap(shm, sizeof(weather_shm_t));
+    }
+}
+
+// 查找城市的槽，不存在返回-1
+static inline int weather_shm_find(const weather_shm_t *shm, const char *city_id) {
+    uint32_t h = weather_shm_hash(city_id);
+    for (uint32_t i = 0; i < WEATHER_SHM_SLOTS; i++) {
+        const weather_shm_slot_t *slot = &shm->slots[(h + i) % WEATHER_SHM_SLOTS];
+        uint32_t cur = atomic_load_explicit(&slot->hash, memory_order_acquire);
+        if (cur == WEATHER_SHM_HASH_EMPTY) {
+            return -1;
+        }
+        if (cur == h && strncmp(slot->city_id, city_id, WEATHER_RECORD_ID_LEN) == 0) {
+            return (int)((h + i) % WEATHER_SHM_SLOTS);
+        }
+    }
+    return -1;
+}
+
+// 查找城市的槽，不存在就占用一个空槽，表满返回-1（只有写者调用）
+static inline int weather_shm_claim(weather_shm_t *shm, const char *city_id) {
+    uint32_t h = weather_shm_hash(city_id);
+    for (uint32_t i = 0; i < WEATHER_SHM_SLOTS; i++) {
+        uint32_t idx = (h + i) % WEATHER_SHM_SLOTS;
+        weather_shm_slot_t *slot = &shm->slots[idx];
+        uint32_t cur = atomic_load_explicit(&slot->hash, memory_order_acquire);
+
+        if (cur == WEATHER_SHM_HASH_EMPTY) {
+            if (atomic_compare_exchange_strong(&slot->hash, &cur, WEATHER_SHM_HASH_CLAIM)) {
+                strncpy(slot->city_id, city_id, WEATHER_RECORD_ID_LEN - 1);
+                atomic_store_explicit(&slot->hash, h, memory_order_release);
+                atomic_fetch_add(&shm->city_num, 1);
+                return (int)idx;
+            }
+            // 被别的写者抢先占用，cur已是它写入的值，往下接着判断
+        }
+        // 别的写者正在占用，等它写好城市ID（占用者崩溃时不再等，跳过这个槽）
+        for (int spin = 0; cur == WEATHER_SHM_HASH_CLAIM && spin < 1000; spin++) {
+            sched_yield();
+            cur = atomic_load_explicit(&slot->hash, memory_order_acquire);
+        }
+        if (cur == h && strncmp(slot->city_id, city_id, WEATHER_RECORD_ID_LEN) == 0) {
+            return (int)idx;
+        }
+    }
+    return -1;
+}
+
+// 写入一条记录（按rec->city_id找槽），成功返回0，表满返回-1
+static inline int weather_shm_put(weather_shm_t *shm, const weather_record_t *rec) {
+    if (shm == NULL || rec == NULL || rec->city_id[0] == '\0') {
+        return -1;
+    }
+    int idx = weather_shm_claim(shm, rec->city_id);
+    if (idx < 0) {
+        return -1;
+    }
+    weather_shm_slot_t *slot = &shm->slots[idx];
+    _Atomic int32_t *writer = &shm->writer[idx];
+
+    // 抢写锁：把槽的写者PID由0改成自己；同一城市的多个写者（同一进程的多个线程也一样）在这里排队
+    int32_t self = (int32_t)getpid();
+    int32_t owner = 0;
+    int spins = 0;
+    while (!atomic_compare_exchange_weak_explicit(writer, &owner, self, memory_order_acquire, memory_order_relaxed)) {
+        if (owner == 0) {
+            continue;
+        }
+        // 占着槽的写者可能只是被抢占了，要等它写完；确认它的进程已经不在了才接管
+        if (++spins >= WEATHER_SHM_CHECK_SPINS) {
+            spins = 0;
+            if (kill(owner, 0) != 0 && errno == ESRCH &&
+                atomic_compare_exchange_strong_explicit(writer, &owner, self, memory_order_acquire,
+                                                        memory_order_relaxed)) {
+                break;
+            }
+        }
+        sched_yield();
+        owner = 0;
+    }
+
+    // 序号改成奇数；崩溃的写者留下的已经是奇数，直接沿用，写完再改成偶数，序号不会回退
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    if ((seq & 1) == 0) {
+        seq++;
+        atomic_store_explicit(&slot->seq, seq, memory_order_relaxed);
+    }
+
+    atomic_thread_fence(memory_order_release);  // 奇数序号先于数据可见
+    slot->rec = *rec;
+    slot->stored = (uint32_t)time(NULL);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+    atomic_store_explicit(writer, 0, memory_order_release);
+    atomic_store_explicit(&shm->latest, (uint32_t)idx + 1, memory_order_release);
+    return 0;
+}
+
+// 读第idx个槽（0 <= idx < WEATHER_SHM_SLOTS，可用于遍历），成功返回true，stored可为NULL
+static inline bool weather_shm_read_slot(const weather_shm_t *shm, int idx, weather_record_t *out, uint32_t *stored) {
+    const weather_shm_slot_t *slot = &shm->slots[idx];
+    for (int i = 0; i < WEATHER_SHM_READ_TRIES; i++) {
+        uint32_t begin = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (begin == 0) {
+            return false;           // 还没写过
+        }
+        if (begin & 1) {
+            continue;               // 正在写
+        }
+        *out = slot->rec;
+        uint32_t when = slot->stored;
+        atomic_thread_fence(memory_order_acquire);  // 数据读完再读结束序号
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == begin) {
+            if (stored != NULL) {
+                *stored = when;
+            }
+            return weather_record_check(out, sizeof(*out));
+        }
+    }
+    return false;
+}
+
+// 读某个城市的最新记录，成功返回true
+static inline bool weather_shm_get(const weather_shm_t *shm, const char *city_id, weather_record_t *out, uint32_t *stored) {
+    if (shm == NULL || city_id == NULL) {
+        return false;
+    }
+    int idx = weather_shm_find(shm, city_id);
+    return idx >= 0 && weather_shm_read_slot(shm, idx, out, stored);
+}
+
+// 读最近一次写入的记录（不区分城市），成功返回true
+static inline bool weather_shm_latest(const weather_shm_t *shm, weather_record_t *out, uint32_t *stored) {
+    if (shm == NULL) {
+        return false;
+    }
+    uint32_t latest = atomic_load_explicit(&shm->latest, memory_order_acquire);
+    return latest > 0 && latest <= WEATHER_SHM_SLOTS && weather_shm_read_slot(shm, (int)latest - 1, out, stored);
+}
+
+#endif
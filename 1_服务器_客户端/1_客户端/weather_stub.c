@@ -0,0 +1,444 @@
+// 本地天气API替身服务器
+// 按请求路径和location参数回放fixtures目录下录制好的响应（如now.json），
+// 可配置延迟、抖动、错误率、断连率和分块传输，用于离线压测和回归测试client A。
+// 请求头带Accept-Encoding: gzip时按真实上游的做法gzip压缩响应体，-Z关闭压缩用于对比。
+// -m 选择模拟的提供方（请求路径格式不同），录制数据文件名前缀相应为：
+//   seniverse  /v3/weather/now.json?location=xx  -> now_xx.json、now.json（默认）
+//   wttr       /xx?format=j1                     -> wttr_xx.json、wttr.json
+//   owm        /data/2.5/weather?q=xx            -> owm_xx.json、owm.json
+// 多个替身各用一个端口、各设不同延迟，即可离线测试client A的多提供方选优。
+//
+// 用法: ./weather_stub [-p 端口] [-d 目录] [-m 提供方] [-l 延迟ms] [-j 抖动ms]
+//                      [-t 慢请求率%] [-T 慢请求额外延迟ms]
+//                      [-e 错误率%] [-k 断连率%] [-c 分块字节数] [-s] [-Z]
+// 客户端A设置 WEATHER_API_HOST=127.0.0.1 WEATHER_API_PORT=<端口> 即可指向替身。
+
+#define _GNU_SOURCE
+#include <time.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <zlib.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define DEFAULT_PORT 8080
+#define REQUEST_SIZE 4096
+#define PATH_SIZE 512
+#define BODY_MAX (256 * 1024)
+
+// 模拟的提供方
+typedef enum {
+    STUB_SENIVERSE,
+    STUB_WTTR,
+    STUB_OWM
+} stub_mode_t;
+
+// 替身服务器配置
+typedef struct {
+    int port;
+    const char *dir;        // 录制数据目录
+    stub_mode_t mode;
+    int latency_ms;         // 固定延迟
+    int jitter_ms;          // 在固定延迟上叠加 [0, jitter) 的随机抖动
+    int slow_pct;           // 长尾：这部分请求额外再慢slow_ms
+    int slow_ms;
+    int error_pct;          // 返回503的概率
+    int drop_pct;           // 不回应直接断开的概率
+    int chunk_size;         // >0时使用chunked编码，每块这么多字节
+    bool strict;            // 没有对应城市的录制数据时返回404，而不是回退到默认数据
+    bool no_gzip;           // 不压缩响应体，即使客户端声明支持
+} stub_config_t;
+
+static stub_config_t config = {
+    .port = DEFAULT_PORT,
+    .dir = "fixtures",
+};
+
+static unsigned long request_count = 0;
+static pthread_mutex_t count_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// URL百分号解码，并把ASCII字母转成小写
+static void url_decode_lower(const char *src, size_t len, char *dst, size_t dst_len) {
+    size_t j = 0;
+    for (size_t i = 0; i < len && j + 1 < dst_len; i++) {
+        if (src[i] == '%' && i + 2 < len && isxdigit((unsigned char)src[i + 1]) &&
+            isxdigit((unsigned char)src[i + 2])) {
+            char hex[3] = {src[i + 1], src[i + 2], '\0'};
+            dst[j++] = (char)strtol(hex, NULL, 16);
+            i += 2;
+        } else if (src[i] == '+') {
+            dst[j++] = ' ';
+        } else {
+            dst[j++] = (char)tolower((unsigned char)src[i]);
+        }
+    }
+    dst[j] = '\0';
+}
+
+// 从查询串中取出参数值（已解码）
+static bool query_param(const char *query, const char *name, char *out, size_t out_len) {
+    size_t name_len = strlen(name);
+    const char *p = query;
+    while (p != NULL && *p) {
+        if (strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            const char *v = p + name_len + 1;
+            size_t len = strcspn(v, "& ");
+            url_decode_lower(v, len, out, out_len);
+            return true;
+        }
+        p = strchr(p, '&');
+        if (p != NULL) {
+            p++;
+        }
+    }
+    return false;
+}
+
+// 读取整个文件到buf，返回长度，失败返回-1
+static long load_file(const char *path, char *buf, size_t buf_len) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    size_t n = fread(buf, 1, buf_len - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+    return (long)n;
+}
+
+// 把整个缓冲写完
+static bool send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+// gzip压缩，返回新分配的压缩数据，失败返回NULL
+static char *gzip_body(const char *body, size_t body_len, size_t *out_len) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // windowBits 15+16：输出gzip格式
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+
+    size_t cap = deflateBound(&zs, body_len);
+    char *out = malloc(cap);
+    if (out == NULL) {
+        deflateEnd(&zs);
+        return NULL;
+    }
+    zs.next_in = (Bytef *)body;
+    zs.avail_in = body_len;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = cap;
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        deflateEnd(&zs);
+        free(out);
+        return NULL;
+    }
+    *out_len = zs.total_out;
+    deflateEnd(&zs);
+    return out;
+}
+
+static void send_response(int fd, int status, const char *reason, const char *body, size_t body_len,
+                          bool gzip) {
+    char header[320];
+    char *packed = NULL;
+    const char *encoding = "";
+    int n;
+
+    if (gzip && body_len > 0) {
+        size_t packed_len;
+        packed = gzip_body(body, body_len, &packed_len);
+        if (packed != NULL) {
+            body = packed;
+            body_len = packed_len;
+            encoding = "Content-Encoding: gzip\r\n";
+        }
+    }
+
+    if (config.chunk_size > 0) {
+        n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: application/json; charset=utf-8\r\n"
+                     "%s"
+                     "Transfer-Encoding: chunked\r\n"
+                     "Connection: close\r\n\r\n", status, reason, encoding);
+        if (!send_all(fd, header, n)) {
+            free(packed);
+            return;
+        }
+
+        // 每块单独发送，模拟慢速上游的逐段到达
+        for (size_t off = 0; off < body_len; off += config.chunk_size) {
+            size_t len = body_len - off;
+            if (len > (size_t)config.chunk_size) {
+                len = config.chunk_size;
+            }
+            n = snprintf(header, sizeof(header), "%zx\r\n", len);
+            if (!send_all(fd, header, n) || !send_all(fd, body + off, len) ||
+                !send_all(fd, "\r\n", 2)) {
+                free(packed);
+                return;
+            }
+        }
+        send_all(fd, "0\r\n\r\n", 5);
+    } else {
+        n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: application/json; charset=utf-8\r\n"
+                     "%s"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n", status, reason, encoding, body_len);
+        if (send_all(fd, header, n)) {
+            send_all(fd, body, body_len);
+        }
+    }
+    free(packed);
+}
+
+static void *handle_request(void *arg) {
+    int fd = *(int *)arg;
+    free(arg);
+
+    unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)fd ^ (unsigned int)pthread_self();
+    char request[REQUEST_SIZE];
+    size_t used = 0;
+
+    // 读到请求头结束
+    while (used < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+        if (n <= 0) {
+            close(fd);
+            return NULL;
+        }
+        used += n;
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL) {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&count_lock);
+    unsigned long id = ++request_count;
+    pthread_mutex_unlock(&count_lock);
+
+    // 解析请求行: GET /v3/weather/now.json?location=xx HTTP/1.1
+    char path[PATH_SIZE] = {0};
+    if (sscanf(request, "GET %511s", path) != 1) {
+        send_response(fd, 400, "Bad Request", "", 0, false);
+        close(fd);
+        return NULL;
+    }
+
+    // 客户端声明支持gzip才压缩
+    bool gzip = false;
+    if (!config.no_gzip) {
+        char *accept = strcasestr(request, "\r\nAccept-Encoding:");
+        char *line_end = accept != NULL ? strstr(accept + 2, "\r\n") : NULL;
+        if (line_end != NULL) {
+            *line_end = '\0';
+            gzip = strstr(accept, "gzip") != NULL;
+            *line_end = '\r';
+        }
+    }
+
+    char *query = strchr(path, '?');
+    if (query != NULL) {
+        *query++ = '\0';
+    }
+
+    // 路径最后一段去掉.json作为数据名，如now、daily
+    char *last = strrchr(path, '/');
+    last = last != NULL ? last + 1 : path;
+    char *ext = strstr(last, ".json");
+    if (ext != NULL) {
+        *ext = '\0';
+    }
+
+    // 按模拟的提供方取数据名和地点
+    const char *name = last;
+    char location[128] = "";
+    if (config.mode == STUB_WTTR) {
+        url_decode_lower(last, strlen(last), location, sizeof(location));
+        name = "wttr";
+    } else if (config.mode == STUB_OWM) {
+        if (query != NULL) {
+            query_param(query, "q", location, sizeof(location));
+        }
+        name = "owm";
+    } else if (query != NULL) {
+        query_param(query, "location", location, sizeof(location));
+    }
+    if (strchr(location, '/') != NULL) {
+        location[0] = '\0';    // 不允许跳出数据目录
+    }
+
+    // 模拟上游延迟和抖动
+    int delay = config.latency_ms;
+    if (config.jitter_ms > 0) {
+        delay += rand_r(&seed) % config.jitter_ms;
+    }
+    if (config.slow_pct > 0 && rand_r(&seed) % 100 < config.slow_pct) {
+        delay += config.slow_ms;
+    }
+    if (delay > 0) {
+        usleep(delay * 1000);
+    }
+
+    if (config.drop_pct > 0 && rand_r(&seed) % 100 < config.drop_pct) {
+        printf("[%lu] %s location=%s -> 断开连接\n", id, name, location);
+        close(fd);
+        return NULL;
+    }
+
+    if (config.error_pct > 0 && rand_r(&seed) % 100 < config.error_pct) {
+        const char *body = "{\"status\":\"Service unavailable\",\"status_code\":\"AP100001\"}";
+        printf("[%lu] %s location=%s -> 503\n", id, name, location);
+        send_response(fd, 503, "Service Unavailable", body, strlen(body), gzip);
+        close(fd);
+        return NULL;
+    }
+
+    // 先找城市专属数据 <name>_<location>.json，再回退到 <name>.json
+    char *body = malloc(BODY_MAX);
+    char file[PATH_SIZE + 256];
+    if (body == NULL) {
+        close(fd);
+        return NULL;
+    }
+    long len = -1;
+    if (location[0] != '\0') {
+        snprintf(file, sizeof(file), "%s/%s_%s.json", config.dir, name, location);
+        len = load_file(file, body, BODY_MAX);
+    }
+    if (len < 0 && !config.strict) {
+        snprintf(file, sizeof(file), "%s/%s.json", config.dir, name);
+        len = load_file(file, body, BODY_MAX);
+    }
+
+    if (len < 0) {
+        const char *err = "{\"status\":\"The location can not be found.\",\"status_code\":\"AP010010\"}";
+        printf("[%lu] %s location=%s -> 404\n", id, name, location);
+        send_response(fd, 404, "Not Found", err, strlen(err), gzip);
+    } else {
+        printf("[%lu] %s location=%s -> 200 %s (%ld字节%s)\n", id, name, location, file, len,
+               gzip ? "，gzip" : "");
+        send_response(fd, 200, "OK", body, len, gzip);
+    }
+
+    free(body);
+    close(fd);
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-p 端口] [-d 目录] [-m seniverse|wttr|owm] [-l 延迟ms] [-j 抖动ms] [-t 慢请求率%%] [-T 慢请求额外延迟ms]\n"
+           "       [-e 错误率%%] [-k 断连率%%] [-c 分块字节数] [-s] [-Z 不压缩]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:m:l:j:t:T:e:k:c:sZh")) != -1) {
+        switch (opt) {
+            case 'p': config.port = atoi(optarg); break;
+            case 'd': config.dir = optarg; break;
+            case 'm':
+                if (strcmp(optarg, "wttr") == 0) {
+                    config.mode = STUB_WTTR;
+                } else if (strcmp(optarg, "owm") == 0) {
+                    config.mode = STUB_OWM;
+                } else if (strcmp(optarg, "seniverse") == 0) {
+                    config.mode = STUB_SENIVERSE;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'l': config.latency_ms = atoi(optarg); break;
+            case 'j': config.jitter_ms = atoi(optarg); break;
+            case 't': config.slow_pct = atoi(optarg); break;
+            case 'T': config.slow_ms = atoi(optarg); break;
+            case 'e': config.error_pct = atoi(optarg); break;
+            case 'k': config.drop_pct = atoi(optarg); break;
+            case 'c': config.chunk_size = atoi(optarg); break;
+            case 's': config.strict = true; break;
+            case 'Z': config.no_gzip = true; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("创建socket失败");
+        return 1;
+    }
+
+    int optval = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config.port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("绑定端口失败");
+        close(server_fd);
+        return 1;
+    }
+
+    if (listen(server_fd, 128) < 0) {
+        perror("监听失败");
+        close(server_fd);
+        return 1;
+    }
+
+    static const char *mode_names[] = {"seniverse", "wttr", "owm"};
+    printf("天气API替身服务器启动，端口: %d，数据目录: %s，模拟: %s\n", config.port, config.dir,
+           mode_names[config.mode]);
+    printf("延迟: %dms 抖动: %dms 慢请求: %d%%/+%dms 错误率: %d%% 断连率: %d%% 分块: %d 压缩: %s\n",
+           config.latency_ms, config.jitter_ms, config.slow_pct, config.slow_ms,
+           config.error_pct, config.drop_pct, config.chunk_size, config.no_gzip ? "关" : "gzip");
+
+    while (1) {
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0) {
+            perror("接受连接失败");
+            continue;
+        }
+
+        pthread_t tid;
+        int *client_ptr = malloc(sizeof(int));
+        *client_ptr = client_fd;
+        if (pthread_create(&tid, NULL, handle_request, client_ptr) != 0) {
+            perror("创建线程失败");
+            close(client_fd);
+            free(client_ptr);
+            continue;
+        }
+        pthread_detach(tid);
+    }
+
+    close(server_fd);
+    return 0;
+}
@@ -9,6 +9,8 @@
 #include <time.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <poll.h>
 
 #if defined(WIN32) || defined(WIN64)
 #include "windows.h"
@@ -32,6 +34,9 @@
 
 // 包含客户端C头文件
 #include "client_c.h"
+#include "weather_shm.h"
+#include "iot_decode.h"
+#include "property_report.h"
 
 // 全局变量
 char* workPath = ".";
@@ -56,6 +61,59 @@ static pthread_t fifo_listener_thread_id = 0;
 static volatile bool fifo_listener_running = false;
 static int weather_fifo_fd = -1;
 
+// 属性上报：只上报相对上次有变化的服务和字段，每PROPERTY_FULL_REPORT_INTERVAL_S秒全量上报一次
+#define PROPERTY_FULL_REPORT_INTERVAL_S 300
+
+enum { SMOKE_ALARM, SMOKE_CONCENTRATION, SMOKE_TEMPERATURE, SMOKE_HUMIDITY, SMOKE_FIELD_NUM };
+enum { WEATHER_CITY, WEATHER_TEXT, WEATHER_TEMPERATURE, WEATHER_HUMIDITY, WEATHER_WIND_DIRECTION, WEATHER_FIELD_NUM };
+enum { CONTROL_LED, CONTROL_BUZZER, CONTROL_FIELD_NUM };
+
+static property_field_t smoke_fields[SMOKE_FIELD_NUM] = {
+    [SMOKE_ALARM]         = { .name = "alarm", .type = PROPERTY_INT },
+    [SMOKE_CONCENTRATION] = { .name = "smokeConcentration", .type = PROPERTY_NUMBER, .deadband = 2.0 },
+    [SMOKE_TEMPERATURE]   = { .name = "temperature", .type = PROPERTY_STRING },
+    [SMOKE_HUMIDITY]      = { .name = "humidity", .type = PROPERTY_INT, .deadband = 3 },
+};
+static property_field_t weather_fields[WEATHER_FIELD_NUM] = {
+    [WEATHER_CITY]           = { .name = "city", .type = PROPERTY_STRING },
+    [WEATHER_TEXT]           = { .name = "weather", .type = PROPERTY_STRING },
+    [WEATHER_TEMPERATURE]    = { .name = "temperature", .type = PROPERTY_STRING },
+    [WEATHER_HUMIDITY]       = { .name = "humidity", .type = PROPERTY_STRING },
+    [WEATHER_WIND_DIRECTION] = { .name = "wind_direction", .type = PROPERTY_STRING },
+};
+static property_field_t control_fields[CONTROL_FIELD_NUM] = {
+    [CONTROL_LED]    = { .name = "led_status", .type = PROPERTY_INT },
+    [CONTROL_BUZZER] = { .name = "buzzer_status", .type = PROPERTY_INT },
+};
+
+#define REPORT_SERVICE_NUM 3
+static property_service_t report_services[REPORT_SERVICE_NUM] = {
+    { "smokeDetector", smoke_fields, SMOKE_FIELD_NUM },
+    { "Weather", weather_fields, WEATHER_FIELD_NUM },
+    { "Control", control_fields, CONTROL_FIELD_NUM },
+};
+
+// 上报统计：周期数、实际发布次数、无变化跳过的周期、上报的服务数和属性字节数
+static struct {
+    unsigned long ticks;
+    unsigned long publishes;
+    unsigned long skipped;
+    unsigned long full_reports;
+    unsigned long services;
+    unsigned long bytes;
+} report_stats;
+
+// 最新天气快照：客户端C的天气回调（同进程）和FIFO监听线程（其他进程写入天气FIFO）把收到的记录写进来，
+// 上报时直接取用结构体。用序号锁保护，与共享天气表weather_shm.h的槽相同：写者把序号改成奇数、写数据、
+// 再改回偶数（两个写者靠CAS排队）；读者前后两次读到同一个偶数序号才算读到完整记录，
+// 读者不加锁、不做系统调用，几十纳秒就能读完，也不会被写者阻塞太久。
+#define WEATHER_SNAPSHOT_READ_TRIES 64
+
+static struct {
+    _Atomic uint32_t seq;       // 0表示还没有数据
+    weather_record_t rec;
+} weather_snapshot;
+
 // 函数声明
 void timeSleep(int ms);
 void setConnectConfig(void);
@@ -90,13 +148,22 @@ void handleEventsDown(void* context, int messageId, int code, char *message);
 // 新增函数声明
 static void* fifo_listener_thread(void* arg);
 static void* command_handler_thread_func(void* arg);
+static void handle_fifo_command(char* line);
 static void client_c_status_callback(client_c_state_t state);
+static void client_c_command_callback(const actuator_cmd_t* command);
+static void client_c_weather_callback(const weather_record_t* rec);
+static void publish_latest_weather(const weather_record_t* rec);
+static bool read_latest_weather(weather_record_t* out);
+static void set_weather_properties(const weather_record_t* rec);
 static bool write_command_to_fifo(const char* command);
+static void send_actuator_command(const actuator_cmd_t* cmd);
+static void send_led_command(int on);
+static void send_buzzer_command(int on);
 static void start_fifo_listener(void);
 static void start_command_handler_thread(void);
 static void stop_command_handler_thread(void);
 static void stop_fifo_listener(void);
-char* read_weather_from_fifo(void);
+bool read_weather_from_shm(weather_record_t* out);
 void deleteSubStr(char *str, const char *substr);
 
 // 时间睡眠函数
@@ -121,56 +188,106 @@ void deleteSubStr(char *str, const char *substr)
     }
 }
 
-// 从FIFO读取天气数据
-char* read_weather_from_fifo()
+// 客户端C的天气回调：更新最新天气快照
+static void client_c_weather_callback(const weather_record_t* rec)
 {
-    static char weather_json[1024] = {0};
-    static char last_weather_json[1024] = {0};
-    
-    memset(weather_json, 0, sizeof(weather_json));
-    
-    // 检查FIFO是否存在
-    if (access(WEATHER_FIFO, F_OK) != 0) {
-        if (strlen(last_weather_json) > 0) {
-            return last_weather_json;
+    publish_latest_weather(rec);
+}
+
+// 写入最新天气快照
+static void publish_latest_weather(const weather_record_t* rec)
+{
+    // 抢写锁：序号由偶数改成奇数
+    uint32_t seq = atomic_load_explicit(&weather_snapshot.seq, memory_order_relaxed);
+    while ((seq & 1) != 0 ||
+           !atomic_compare_exchange_weak_explicit(&weather_snapshot.seq, &seq, seq + 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+        if (seq & 1) {
+            sched_yield();
+            seq = atomic_load_explicit(&weather_snapshot.seq, memory_order_relaxed);
         }
-        return NULL;
     }
-    
-    // 使用阻塞模式打开，确保能读到数据
-    int fd = open(WEATHER_FIFO, O_RDONLY);
-    if (fd < 0) {
-        if (strlen(last_weather_json) > 0) {
-            return last_weather_json;
+    atomic_thread_fence(memory_order_release);  // 奇数序号先于数据可见
+    weather_snapshot.rec = *rec;
+    atomic_store_explicit(&weather_snapshot.seq, seq + 2, memory_order_release);
+}
+
+// 读取最新天气快照，还没有数据（或一直在写）时返回false
+static bool read_latest_weather(weather_record_t* out)
+{
+    for (int i = 0; i < WEATHER_SNAPSHOT_READ_TRIES; i++) {
+        uint32_t begin = atomic_load_explicit(&weather_snapshot.seq, memory_order_acquire);
+        if (begin == 0) {
+            return false;
+        }
+        if (begin & 1) {
+            continue;
+        }
+        *out = weather_snapshot.rec;
+        atomic_thread_fence(memory_order_acquire);  // 数据读完再读结束序号
+        if (atomic_load_explicit(&weather_snapshot.seq, memory_order_relaxed) == begin) {
+            return true;
         }
-        return NULL;
     }
-    
-    // 读取数据
-    int bytes = read(fd, weather_json, sizeof(weather_json) - 1);
-    close(fd);
-    
-    if (bytes > 0) {
-        weather_json[bytes] = '\0';
-        // 去除可能的换行符
-        char* newline = strchr(weather_json, '\n');
-        if (newline) {
-            *newline = '\0';
+    return false;
+}
+
+// 天气记录写入Weather服务的字段（与物模型一致，值都是字符串），rec为NULL或字段无数据时填默认值
+static void set_weather_properties(const weather_record_t* rec)
+{
+    char temperature[16] = "25.5";
+    char humidity[8] = "60";
+    const char* city = "Unknown";
+    const char* weather = "Unknown";
+    const char* wind_direction = "North";
+
+    if (rec != NULL) {
+        if (rec->city_name[0] != '\0') {
+            city = rec->city_name;
         }
-        
-        printfLog(EN_LOG_LEVEL_INFO, "从FIFO读取到天气数据: %s\n", weather_json);
-        
-        // 保存为上次数据
-        strcpy(last_weather_json, weather_json);
-        return weather_json;
-    } else if (bytes == 0) {
-        // 没有新数据，返回上次的数据
-        if (strlen(last_weather_json) > 0) {
-            return last_weather_json;
+        if (rec->text[0] != '\0') {
+            weather = rec->text;
+        }
+        if (rec->temp_x10 != WEATHER_RECORD_NONE_I16) {
+            snprintf(temperature, sizeof(temperature), "%.1f", rec->temp_x10 / 10.0);
+        }
+        if (rec->humidity != WEATHER_RECORD_NONE_U8) {
+            snprintf(humidity, sizeof(humidity), "%u%%", rec->humidity);
+        }
+        if (rec->wind_direction[0] != '\0') {
+            wind_direction = rec->wind_direction;
         }
     }
-    
-    return NULL;
+
+    property_set_string(&weather_fields[WEATHER_CITY], city);
+    property_set_string(&weather_fields[WEATHER_TEXT], weather);
+    property_set_string(&weather_fields[WEATHER_TEMPERATURE], temperature);
+    property_set_string(&weather_fields[WEATHER_HUMIDITY], humidity);
+    property_set_string(&weather_fields[WEATHER_WIND_DIRECTION], wind_direction);
+}
+
+// 从同机共享天气表读取最新天气记录（客户端A写入），映射建立后读取不做系统调用
+bool read_weather_from_shm(weather_record_t* out)
+{
+    static weather_shm_t *shm = NULL;
+    static time_t next_open = 0;
+
+    // 客户端A可能还没启动，打开失败时隔一段时间再试
+    if (shm == NULL) {
+        time_t now = time(NULL);
+        if (now < next_open) {
+            return false;
+        }
+        shm = weather_shm_open(false);
+        if (shm == NULL) {
+            next_open = now + 10;
+            return false;
+        }
+        printfLog(EN_LOG_LEVEL_INFO, "已映射共享天气表%s\n", WEATHER_SHM_NAME);
+    }
+
+    // 每个上报周期都会读一次，只在建立映射时记日志
+    return weather_shm_latest(shm, out, NULL);
 }
 
 // FIFO监听线程函数
@@ -189,45 +306,85 @@ static void* fifo_listener_thread(void* arg)
         mkfifo(WEATHER_FIFO, 0666);
     }
     
-    weather_fifo_fd = open(WEATHER_FIFO, O_RDONLY);
+    // 非阻塞打开，没有写者时不会卡在open上；自己再持有一个写端，写者全部退出时read不会一直返回0，
+    // poll带超时，client_c_stop/stop_fifo_listener能及时让线程退出
+    weather_fifo_fd = open(WEATHER_FIFO, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
     if (weather_fifo_fd < 0) {
         printfLog(EN_LOG_LEVEL_ERROR, "打开天气FIFO失败: %s\n", strerror(errno));
         return NULL;
     }
+    int keep_writer_fd = open(WEATHER_FIFO, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
     
-    char buffer[1024];
+    weather_record_t rec;
     
     while (fifo_listener_running) {
-        memset(buffer, 0, sizeof(buffer));
-        
-        int bytes = read(weather_fifo_fd, buffer, sizeof(buffer) - 1);
+        struct pollfd pfd = { .fd = weather_fifo_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+        // 写端每条记录一次write（小于PIPE_BUF，是原子的），一次read正好读一条
+        int bytes = read(weather_fifo_fd, &rec, sizeof(rec));
         if (bytes > 0) {
-            buffer[bytes] = '\0';
-            if (buffer[strlen(buffer)-1] == '\n') {
-                buffer[strlen(buffer)-1] = '\0';
+            if (weather_record_check(&rec, bytes)) {
+                publish_latest_weather(&rec);
+                printfLog(EN_LOG_LEVEL_INFO, "FIFO监听线程收到天气记录: 城市=%s, 天气=%s, 温度=%.1f\n",
+                          rec.city_name, rec.text, rec.temp_x10 / 10.0);
+            } else {
+                printfLog(EN_LOG_LEVEL_WARNING, "FIFO监听线程收到无效数据(%d字节)\n", bytes);
             }
-            
-            printfLog(EN_LOG_LEVEL_INFO, "FIFO监听线程收到天气数据: %s\n", buffer);
         } else if (bytes == 0) {
-            // FIFO写入端关闭，短暂等待后继续
+            // 没有拿到自己的写端时，写入端全部关闭会一直读到0，短暂等待后继续
             timeSleep(100);
         } else {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
                 printfLog(EN_LOG_LEVEL_ERROR, "读取FIFO失败: %s\n", strerror(errno));
                 break;
             }
         }
     }
     
-    if (weather_fifo_fd >= 0) {
-        close(weather_fifo_fd);
-        weather_fifo_fd = -1;
+    if (keep_writer_fd >= 0) {
+        close(keep_writer_fd);
     }
+    close(weather_fifo_fd);
+    weather_fifo_fd = -1;
     
     printfLog(EN_LOG_LEVEL_INFO, "FIFO监听线程退出\n");
     return NULL;
 }
 
+// 处理command_fifo中的一条命令（一行，不含换行）：按命令表校验，
+// 转发规范文本（补全省略的参数、命令名统一大写）
+static void handle_fifo_command(char* line)
+{
+    line[strcspn(line, "\r")] = '\0';
+    if (line[0] == '\0') {
+        return;
+    }
+    printfLog(EN_LOG_LEVEL_INFO, "从command_fifo收到命令: %s\n", line);
+    
+    actuator_cmd_t cmd;
+    int cmd_ret = actuator_cmd_parse(line, strlen(line), &cmd);
+    if (cmd_ret != 0) {
+        printfLog(EN_LOG_LEVEL_WARNING, "忽略%s的命令: %s\n",
+                  cmd_ret == ACTUATOR_CMD_BAD_PARAM ? "参数不合法" : "未知", line);
+        return;
+    }
+    char text[64];
+    actuator_cmd_format(&cmd, text, sizeof(text));
+    
+    // 通过TCP发送命令到服务器
+    if (client_c_initialized && client_c_is_connected()) {
+        if (client_c_send_command(text)) {
+            printfLog(EN_LOG_LEVEL_INFO, "命令已发送到服务器\n");
+        } else {
+            printfLog(EN_LOG_LEVEL_ERROR, "发送命令到服务器失败\n");
+        }
+    } else {
+        printfLog(EN_LOG_LEVEL_WARNING, "客户端C未连接，无法发送命令\n");
+    }
+}
+
 // 命令处理线程函数
 static void* command_handler_thread_func(void* arg)
 {
@@ -251,30 +408,37 @@ static void* command_handler_thread_func(void* arg)
     }
     
     char buffer[1024];
+    size_t buffer_len = 0;      // 缓冲中还没遇到换行的半条命令
     
     while (command_handler_running) {
-        memset(buffer, 0, sizeof(buffer));
-        
-        int bytes = read(command_fifo_fd, buffer, sizeof(buffer) - 1);
+        int bytes = read(command_fifo_fd, buffer + buffer_len, sizeof(buffer) - 1 - buffer_len);
         if (bytes > 0) {
-            buffer[bytes] = '\0';
-            if (buffer[strlen(buffer)-1] == '\n') {
-                buffer[strlen(buffer)-1] = '\0';
-            }
+            buffer_len += bytes;
             
-            printfLog(EN_LOG_LEVEL_INFO, "从command_fifo收到命令: %s\n", buffer);
+            // 一次read可能读到几条命令，也可能只有半条：按换行逐条处理，半条留到下次
+            char* start = buffer;
+            char* nl;
+            while ((nl = memchr(start, '\n', buffer + buffer_len - start)) != NULL) {
+                *nl = '\0';
+                handle_fifo_command(start);
+                start = nl + 1;
+            }
+            buffer_len -= start - buffer;
+            memmove(buffer, start, buffer_len);
             
-            // 通过TCP发送命令到服务器
-            if (client_c_initialized && client_c_is_connected()) {
-                if (client_c_send_command(buffer)) {
-                    printfLog(EN_LOG_LEVEL_INFO, "命令已发送到服务器\n");
-                } else {
-                    printfLog(EN_LOG_LEVEL_ERROR, "发送命令到服务器失败\n");
-                }
-            } else {
-                printfLog(EN_LOG_LEVEL_WARNING, "客户端C未连接，无法发送命令\n");
+            // 一行太长装不下，截断当作一条
+            if (buffer_len == sizeof(buffer) - 1) {
+                buffer[buffer_len] = '\0';
+                handle_fifo_command(buffer);
+                buffer_len = 0;
             }
         } else if (bytes == 0) {
+            // 写端都已关闭：最后一条命令没有换行也算收全了
+            if (buffer_len > 0) {
+                buffer[buffer_len] = '\0';
+                handle_fifo_command(buffer);
+                buffer_len = 0;
+            }
             timeSleep(100);
         } else {
             if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -305,6 +469,29 @@ static void client_c_status_callback(client_c_state_t state)
     printfLog(EN_LOG_LEVEL_INFO, "客户端C状态: %s\n", state_str);
 }
 
+// 客户端C命令回调函数：中继转来的执行器命令同步到Control服务的属性
+static void client_c_command_callback(const actuator_cmd_t* command)
+{
+    switch (command->id) {
+        case ACTUATOR_CMD_LED_ON:
+        case ACTUATOR_CMD_LED_PATTERN:
+            led_status = 1;
+            break;
+        case ACTUATOR_CMD_LED_OFF:
+            led_status = 0;
+            break;
+        case ACTUATOR_CMD_BUZZER_ON:
+            buzzer_status = 1;
+            break;
+        case ACTUATOR_CMD_BUZZER_OFF:
+            buzzer_status = 0;
+            break;
+        default:
+            return;
+    }
+    printfLog(EN_LOG_LEVEL_INFO, "收到执行器命令: %s\n", actuator_cmd_name(command->id));
+}
+
 // 写入命令到FIFO
 static bool write_command_to_fifo(const char* command)
 {
@@ -342,6 +529,51 @@ static bool write_command_to_fifo(const char* command)
     return true;
 }
 
+// 发送执行器命令：文本由actuator_cmd_format按命令表生成，写入FIFO并通过TCP发送
+static void send_actuator_command(const actuator_cmd_t* cmd)
+{
+    char text[64];
+    if (actuator_cmd_format(cmd, text, sizeof(text)) <= 0) {
+        printfLog(EN_LOG_LEVEL_ERROR, "生成执行器命令失败: %s\n", actuator_cmd_name(cmd->id));
+        return;
+    }
+    write_command_to_fifo(text);
+    
+    if (client_c_initialized && client_c_is_connected()) {
+        client_c_send_command(text);
+    }
+}
+
+// LED开关命令（0号LED，打开时全亮）
+static void send_led_command(int on)
+{
+    actuator_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    if (on) {
+        cmd.id = ACTUATOR_CMD_LED_ON;
+        cmd.led_on.index = 0;
+        cmd.led_on.brightness = 100;
+    } else {
+        cmd.id = ACTUATOR_CMD_LED_OFF;
+        cmd.led_off.index = 0;
+    }
+    send_actuator_command(&cmd);
+}
+
+// 蜂鸣器开关命令（打开时一直响，直到关闭）
+static void send_buzzer_command(int on)
+{
+    actuator_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    if (on) {
+        cmd.id = ACTUATOR_CMD_BUZZER_ON;
+        cmd.buzzer_on.duration_ms = 0;
+    } else {
+        cmd.id = ACTUATOR_CMD_BUZZER_OFF;
+    }
+    send_actuator_command(&cmd);
+}
+
 // 启动FIFO监听线程
 static void start_fifo_listener(void)
 {
@@ -383,10 +615,6 @@ static void stop_fifo_listener(void)
     
     printfLog(EN_LOG_LEVEL_INFO, "正在停止FIFO监听线程...\n");
     fifo_listener_running = false;
-    if (weather_fifo_fd >= 0) {
-        close(weather_fifo_fd);
-        weather_fifo_fd = -1;
-    }
     if (fifo_listener_thread_id) {
         pthread_join(fifo_listener_thread_id, NULL);
         fifo_listener_thread_id = 0;
@@ -524,84 +752,83 @@ void Test_messageReport()
 
 void Test_propertiesReport()
 {
-    // 创建3个服务
-    int serviceNum = 3;
-    ST_IOTA_SERVICE_DATA_INFO services[serviceNum];
+    static time_t next_full_report = 0;
+    static double smoke_concentration = 20.0;
+    static long smoke_humidity = 50;
+    time_t now = time(NULL);
+    bool full = now >= next_full_report;
+
+    report_stats.ticks++;
+
+    // 1. 烟感检测服务（模拟传感器：在上次读数附近小幅波动）
+    smoke_concentration += (rand() % 11 - 5) / 10.0;
+    smoke_concentration = smoke_concentration < 10.0 ? 10.0 : (smoke_concentration > 100.0 ? 100.0 : smoke_concentration);
+    smoke_humidity += rand() % 3 - 1;
+    smoke_humidity = smoke_humidity < 0 ? 0 : (smoke_humidity > 100 ? 100 : smoke_humidity);
+    property_set_int(&smoke_fields[SMOKE_ALARM], alarmValue);
+    property_set_number(&smoke_fields[SMOKE_CONCENTRATION], smoke_concentration);
+    property_set_string(&smoke_fields[SMOKE_TEMPERATURE], "25.5");
+    property_set_int(&smoke_fields[SMOKE_HUMIDITY], smoke_humidity);
 
-    char city[64] = "Unknown";
-    char weather[64] = "Unknown";
-    char temperature_str[32] = "25.5";
-    char humidity_str[32] = "60";
-    // 1. 烟感检测服务 - 使用cJSON
-    cJSON *smokeRoot = cJSON_CreateObject();
-    cJSON_AddNumberToObject(smokeRoot, "alarm", alarmValue);
-    cJSON_AddNumberToObject(smokeRoot, "smokeConcentration", (double)(rand()%900+100)/10);
-    cJSON_AddStringToObject(smokeRoot, "temperature", temperature_str);
-    cJSON_AddNumberToObject(smokeRoot, "humidity", rand() % 100);
-    
-    char *smokePayload = cJSON_Print(smokeRoot);
-    cJSON_Delete(smokeRoot);
-    
-    services[0].event_time = getEventTimeStamp();
-    services[0].service_id = "smokeDetector";
-    services[0].properties = smokePayload;
-    
     // 2. 天气服务
-    cJSON *weatherRoot = cJSON_CreateObject();
-    
+    // 天气在网关内全程是weather_record_t：优先用最新天气快照（客户端C回调和FIFO监听线程写入，
+    // 读取不做系统调用），还没有时读同机共享天气表；字段值直接取自结构体，不建cJSON树
+    weather_record_t rec;
+    bool has_weather = read_latest_weather(&rec) || read_weather_from_shm(&rec);
+    set_weather_properties(has_weather ? &rec : NULL);
 
-    
-    // 尝试从FIFO读取天气数据
-    char* weather_json = read_weather_from_fifo();
-    if (weather_json) {
-        // 使用parse_weather_json函数（已在client_c.c中定义）
-        if (parse_weather_json(weather_json, city, weather, temperature_str, humidity_str)) {
-            printfLog(EN_LOG_LEVEL_INFO, "使用FIFO天气数据: 城市=%s, 天气=%s, 温度=%s, 湿度=%s\n", 
-                   city, weather, temperature_str, humidity_str);
+    // 3. 控制服务
+    property_set_int(&control_fields[CONTROL_LED], led_status);
+    property_set_int(&control_fields[CONTROL_BUZZER], buzzer_status);
+
+    // 只上报有变化的服务（全量周期上报全部）；字段表只在这里读写，format和commit之间不会变
+    ST_IOTA_SERVICE_DATA_INFO services[REPORT_SERVICE_NUM];
+    char payloads[REPORT_SERVICE_NUM][PROPERTY_PAYLOAD_LEN];
+    int reported[REPORT_SERVICE_NUM];
+    int serviceNum = 0;
+    size_t bytes = 0;
+
+    for (int i = 0; i < REPORT_SERVICE_NUM; i++) {
+        int len = property_service_format(&report_services[i], full, payloads[serviceNum], PROPERTY_PAYLOAD_LEN);
+        if (len < 0) {
+            printfLog(EN_LOG_LEVEL_ERROR, "服务%s的属性超出缓冲，本次不上报\n", report_services[i].service_id);
+            continue;
         }
+        if (len == 0) {
+            continue;
+        }
+        services[serviceNum].event_time = getEventTimeStamp();
+        services[serviceNum].service_id = (char*)report_services[i].service_id;
+        services[serviceNum].properties = payloads[serviceNum];
+        reported[serviceNum] = i;
+        serviceNum++;
+        bytes += (size_t)len;
     }
-    
-    cJSON_AddStringToObject(weatherRoot, "city", city);
-    cJSON_AddStringToObject(weatherRoot, "weather", weather);
-    cJSON_AddStringToObject(weatherRoot, "temperature", temperature_str);
-    cJSON_AddStringToObject(weatherRoot, "humidity", humidity_str);
-    cJSON_AddStringToObject(weatherRoot, "wind_direction", "North");
-    
-    char *weatherPayload = cJSON_Print(weatherRoot);
-    cJSON_Delete(weatherRoot);
-    
-    services[1].event_time = getEventTimeStamp();
-    services[1].service_id = "Weather";
-    services[1].properties = weatherPayload;
-    
-    // 3. 控制服务
-    cJSON *controlRoot = cJSON_CreateObject();
-    cJSON_AddNumberToObject(controlRoot, "led_status", led_status);
-    cJSON_AddNumberToObject(controlRoot, "buzzer_status", buzzer_status);
-    
-    char *controlPayload = cJSON_Print(controlRoot);
-    cJSON_Delete(controlRoot);
-    
-    services[2].event_time = getEventTimeStamp();
-    services[2].service_id = "Control";
-    services[2].properties = controlPayload;
-    
-    // 上报所有服务
+
+    if (serviceNum == 0) {
+        report_stats.skipped++;
+        return;
+    }
+
     int messageId = IOTA_PropertiesReport(services, serviceNum);
     if(messageId != 0)
     {
+        // 不记为已上报，下次还会带上这些变化
         printfLog(EN_LOG_LEVEL_ERROR, "Test_propertiesReport() failed, messageId %d\n", messageId);
+        return;
     }
-    else
-    {
-        printfLog(EN_LOG_LEVEL_INFO, "所有服务上报成功\n");
+
+    for (int k = 0; k < serviceNum; k++) {
+        property_service_commit(&report_services[reported[k]], full);
     }
-    
-    // 释放内存
-    // 注意：cJSON_Print返回的字符串需要释放
-    if (smokePayload) free(smokePayload);
-    if (weatherPayload) free(weatherPayload);
-    if (controlPayload) free(controlPayload);
+    if (full) {
+        next_full_report = now + PROPERTY_FULL_REPORT_INTERVAL_S;
+        report_stats.full_reports++;
+    }
+    report_stats.publishes++;
+    report_stats.services += serviceNum;
+    report_stats.bytes += bytes;
+    printfLog(EN_LOG_LEVEL_INFO, "%s上报%d个服务，%zu字节\n", full ? "全量" : "变化", serviceNum, bytes);
 }
 
 void Test_batchPropertiesReport()
@@ -714,73 +941,27 @@ void handleCommandRequest(void* context, int messageId, int code, char *message,
 {
     printfLog(EN_LOG_LEVEL_INFO, "收到命令请求: %s, requestId: %s\n", message, requestId);
     
-    // 解析JSON
-    cJSON *root = cJSON_Parse(message);
-    if (!root) {
+    // 用生成的解码器直接取出需要的字段，不建立cJSON树
+    iot_command_t cmd_msg;
+    if (iot_command_decode(message, strlen(message), &cmd_msg) != 0) {
         printfLog(EN_LOG_LEVEL_ERROR, "解析命令请求失败\n");
         return;
     }
     
-    char* service_id = NULL;
-    char* command_name = NULL;
-    cJSON* paras = NULL;
-    
-    cJSON *service_id_obj = cJSON_GetObjectItem(root, "service_id");
-    if (service_id_obj && cJSON_IsString(service_id_obj)) {
-        service_id = service_id_obj->valuestring;
-    }
-    
-    cJSON *command_name_obj = cJSON_GetObjectItem(root, "command_name");
-    if (command_name_obj && cJSON_IsString(command_name_obj)) {
-        command_name = command_name_obj->valuestring;
-    }
-    
-    paras = cJSON_GetObjectItem(root, "paras");
-    
     // 处理控制命令
-    if (service_id && command_name && paras) {
-        if (strcmp(service_id, "Control") == 0) {
-            if (strcmp(command_name, "control_led") == 0) {
-                cJSON *action_obj = cJSON_GetObjectItem(paras, "action");
-                if (action_obj && cJSON_IsNumber(action_obj)) {
-                    int action = action_obj->valueint;
-                    led_status = action;
-                    printfLog(EN_LOG_LEVEL_INFO, "控制LED命令: action=%d\n", action);
-                    
-                    // 写入FIFO
-                    char cmd[32];
-                    snprintf(cmd, sizeof(cmd), "LED_%s", action ? "ON" : "OFF");
-                    write_command_to_fifo(cmd);
-                    
-                    // 通过TCP发送
-                    if (client_c_initialized && client_c_is_connected()) {
-                        client_c_send_command(cmd);
-                    }
-                }
-            }
-            else if (strcmp(command_name, "control_buzzer") == 0) {
-                cJSON *action_obj = cJSON_GetObjectItem(paras, "action");
-                if (action_obj && cJSON_IsNumber(action_obj)) {
-                    int action = action_obj->valueint;
-                    buzzer_status = action;
-                    printfLog(EN_LOG_LEVEL_INFO, "控制蜂鸣器命令: action=%d\n", action);
-                    
-                    // 写入FIFO
-                    char cmd[32];
-                    snprintf(cmd, sizeof(cmd), "BUZZER_%s", action ? "ON" : "OFF");
-                    write_command_to_fifo(cmd);
-                    
-                    // 通过TCP发送
-                    if (client_c_initialized && client_c_is_connected()) {
-                        client_c_send_command(cmd);
-                    }
-                }
-            }
+    if (strcmp(cmd_msg.service_id, "Control") == 0 && cmd_msg.action != JSON_NONE_INT) {
+        int action = cmd_msg.action;
+        if (strcmp(cmd_msg.command_name, "control_led") == 0) {
+            led_status = action;
+            printfLog(EN_LOG_LEVEL_INFO, "控制LED命令: action=%d\n", action);
+            send_led_command(action);
+        } else if (strcmp(cmd_msg.command_name, "control_buzzer") == 0) {
+            buzzer_status = action;
+            printfLog(EN_LOG_LEVEL_INFO, "控制蜂鸣器命令: action=%d\n", action);
+            send_buzzer_command(action);
         }
     }
     
-    cJSON_Delete(root);
-    
     // 发送响应
     Test_commandResponse(requestId);
 }
@@ -790,65 +971,36 @@ void handlePropertiesSet(void* context, int messageId, int code, char *message,
 {
     printfLog(EN_LOG_LEVEL_INFO, "收到属性设置请求: %s, requestId: %s\n", message, requestId);
     
-    cJSON *root = cJSON_Parse(message);
-    if (!root) {
+    iot_properties_set_t set_msg;
+    if (iot_properties_set_decode(message, strlen(message), &set_msg) != 0) {
         printfLog(EN_LOG_LEVEL_ERROR, "解析属性设置请求失败\n");
         return;
     }
     
-    cJSON *services = cJSON_GetObjectItem(root, "services");
-    if (services && cJSON_IsArray(services)) {
-        int size = cJSON_GetArraySize(services);
-        for (int i = 0; i < size; i++) {
-            cJSON *service = cJSON_GetArrayItem(services, i);
-            cJSON *service_id_obj = cJSON_GetObjectItem(service, "service_id");
-            cJSON *properties = cJSON_GetObjectItem(service, "properties");
+    for (int i = 0; i < set_msg.service_num; i++) {
+        const iot_properties_set_service_t *service = &set_msg.service[i];
+        
+        if (strcmp(service->service_id, "smokeDetector") == 0) {
+            if (service->alarm != JSON_NONE_INT) {
+                alarmValue = service->alarm;
+                printfLog(EN_LOG_LEVEL_INFO, "设置烟感报警值: %d\n", alarmValue);
+            }
+        }
+        else if (strcmp(service->service_id, "Control") == 0) {
+            if (service->led_status != JSON_NONE_INT) {
+                led_status = service->led_status;
+                printfLog(EN_LOG_LEVEL_INFO, "设置LED状态: %d\n", led_status);
+                send_led_command(led_status);
+            }
             
-            if (service_id_obj && properties) {
-                char *service_id = service_id_obj->valuestring;
-                
-                if (strcmp(service_id, "smokeDetector") == 0) {
-                    cJSON *alarm_obj = cJSON_GetObjectItem(properties, "alarm");
-                    if (alarm_obj && cJSON_IsNumber(alarm_obj)) {
-                        alarmValue = alarm_obj->valueint;
-                        printfLog(EN_LOG_LEVEL_INFO, "设置烟感报警值: %d\n", alarmValue);
-                    }
-                }
-                else if (strcmp(service_id, "Control") == 0) {
-                    cJSON *led_obj = cJSON_GetObjectItem(properties, "led_status");
-                    cJSON *buzzer_obj = cJSON_GetObjectItem(properties, "buzzer_status");
-                    
-                    if (led_obj && cJSON_IsNumber(led_obj)) {
-                        led_status = led_obj->valueint;
-                        printfLog(EN_LOG_LEVEL_INFO, "设置LED状态: %d\n", led_status);
-                        
-                        char cmd[32];
-                        snprintf(cmd, sizeof(cmd), "LED_%s", led_status ? "ON" : "OFF");
-                        write_command_to_fifo(cmd);
-                        
-                        if (client_c_initialized && client_c_is_connected()) {
-                            client_c_send_command(cmd);
-                        }
-                    }
-                    
-                    if (buzzer_obj && cJSON_IsNumber(buzzer_obj)) {
-                        buzzer_status = buzzer_obj->valueint;
-                        printfLog(EN_LOG_LEVEL_INFO, "设置蜂鸣器状态: %d\n", buzzer_status);
-                        
-                        char cmd[32];
-                        snprintf(cmd, sizeof(cmd), "BUZZER_%s", buzzer_status ? "ON" : "OFF");
-                        write_command_to_fifo(cmd);
-                        
-                        if (client_c_initialized && client_c_is_connected()) {
-                            client_c_send_command(cmd);
-                        }
-                    }
-                }
+            if (service->buzzer_status != JSON_NONE_INT) {
+                buzzer_status = service->buzzer_status;
+                printfLog(EN_LOG_LEVEL_INFO, "设置蜂鸣器状态: %d\n", buzzer_status);
+                send_buzzer_command(buzzer_status);
             }
         }
     }
     
-    cJSON_Delete(root);
     Test_propSetResponse(requestId);
 }
 
@@ -891,8 +1043,9 @@ int main(int argc, char **argv)
         .server_ip = SERVER_IP,
         .server_port = SERVER_PORT,
         .client_id = CLIENT_C_ID,
-        .weather_callback = NULL,
-        .command_callback = NULL,
+        .weather_callback = client_c_weather_callback,
+        .no_weather_fifo = true,        // 本进程从回调取天气，FIFO监听线程只接收其他进程写入的天气
+        .command_callback = client_c_command_callback,
         .status_callback = client_c_status_callback
     };
     
@@ -961,7 +1114,9 @@ int main(int argc, char **argv)
         
         // 每10次输出一次状态
         if (count % 10 == 0) {
-            printfLog(EN_LOG_LEVEL_INFO, "运行中... 已循环 %d 次\n", count);
+            printfLog(EN_LOG_LEVEL_INFO, "运行中... 已循环 %d 次，属性上报%lu次（全量%lu次，无变化跳过%lu次），%lu个服务，%lu字节\n",
+                      count, report_stats.publishes, report_stats.full_reports, report_stats.skipped,
+                      report_stats.services, report_stats.bytes);
         }
     }
     
@@ -0,0 +1,199 @@
+// 由gen_commands.py根据actuator_commands.json生成，请勿手工修改
+#include "actuator_cmd.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+    const char *name;
+    uint16_t offset;                // 在actuator_cmd_t中的偏移
+    uint8_t size;                   // 字节数：1/2/4
+    uint32_t min, max, def;
+    const char *const *values;      // 枚举参数的取值（NULL结尾），数值参数为NULL
+} actuator_cmd_param_spec_t;
+
+typedef struct {
+    const char *name;
+    uint8_t name_len;
+    uint8_t param_num;
+    const actuator_cmd_param_spec_t *params;
+} actuator_cmd_spec_t;
+
+static const char *const pattern_values[] = { "flow", "blink", "breath", NULL };
+
+static const actuator_cmd_param_spec_t led_on_params[] = {
+    { "index", offsetof(actuator_cmd_t, led_on.index), 1, 0, 4, 0, NULL },
+    { "brightness", offsetof(actuator_cmd_t, led_on.brightness), 1, 0, 100, 100, NULL },
+};
+
+static const actuator_cmd_param_spec_t led_off_params[] = {
+    { "index", offsetof(actuator_cmd_t, led_off.index), 1, 0, 4, 0, NULL },
+};
+
+static const actuator_cmd_param_spec_t led_pattern_params[] = {
+    { "pattern", offsetof(actuator_cmd_t, led_pattern.pattern), 1, 0, 2, 0, pattern_values },
+    { "period_ms", offsetof(actuator_cmd_t, led_pattern.period_ms), 2, 50, 10000, 500, NULL },
+};
+
+static const actuator_cmd_param_spec_t buzzer_on_params[] = {
+    { "duration_ms", offsetof(actuator_cmd_t, buzzer_on.duration_ms), 4, 0, 600000, 0, NULL },
+};
+
+static const actuator_cmd_spec_t actuator_cmd_specs[ACTUATOR_CMD_NUM] = {
+    [ACTUATOR_CMD_LED_ON] = { "LED_ON", 6, 2, led_on_params },
+    [ACTUATOR_CMD_LED_OFF] = { "LED_OFF", 7, 1, led_off_params },
+    [ACTUATOR_CMD_LED_PATTERN] = { "LED_PATTERN", 11, 2, led_pattern_params },
+    [ACTUATOR_CMD_BUZZER_ON] = { "BUZZER_ON", 9, 1, buzzer_on_params },
+    [ACTUATOR_CMD_BUZZER_OFF] = { "BUZZER_OFF", 10, 0, NULL },
+};
+
+// 完美哈希：种子0下各命令名落在不同的槽，-1为空槽
+#define ACTUATOR_CMD_HASH_SEED 0u
+#define ACTUATOR_CMD_HASH_SIZE 16
+static const int8_t actuator_cmd_slots[ACTUATOR_CMD_HASH_SIZE] = {
+    0, -1, -1, 4, -1, -1, -1, 2, 1, -1, 3, -1, -1, -1, -1, -1,
+};
+
+static int is_space(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// 取下一个空白分隔的单词，没有了返回0
+static size_t next_token(const char **p, const char *end, const char **tok) {
+    while (*p < end && is_space(**p)) {
+        (*p)++;
+    }
+    *tok = *p;
+    while (*p < end && !is_space(**p)) {
+        (*p)++;
+    }
+    return (size_t)(*p - *tok);
+}
+
+static void store_param(actuator_cmd_t *cmd, const actuator_cmd_param_spec_t *ps, uint32_t v) {
+    char *field = (char *)cmd + ps->offset;
+    if (ps->size == 1) {
+        uint8_t x = (uint8_t)v;
+        memcpy(field, &x, 1);
+    } else if (ps->size == 2) {
+        uint16_t x = (uint16_t)v;
+        memcpy(field, &x, 2);
+    } else {
+        memcpy(field, &v, 4);
+    }
+}
+
+static uint32_t load_param(const actuator_cmd_t *cmd, const actuator_cmd_param_spec_t *ps) {
+    const char *field = (const char *)cmd + ps->offset;
+    if (ps->size == 1) {
+        uint8_t x;
+        memcpy(&x, field, 1);
+        return x;
+    } else if (ps->size == 2) {
+        uint16_t x;
+        memcpy(&x, field, 2);
+        return x;
+    }
+    uint32_t x;
+    memcpy(&x, field, 4);
+    return x;
+}
+
+// 解析一个参数，成功返回0
+static int parse_param(const actuator_cmd_param_spec_t *ps, const char *tok, size_t len, uint32_t *out) {
+    if (ps->values != NULL) {
+        for (uint32_t i = 0; ps->values[i] != NULL; i++) {
+            if (strlen(ps->values[i]) == len && strncasecmp(ps->values[i], tok, len) == 0) {
+                *out = i;
+                return 0;
+            }
+        }
+        return -1;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (tok[i] < '0' || tok[i] > '9') {
+            return -1;
+        }
+        uint32_t d = (uint32_t)(tok[i] - '0');
+        if (d > ps->max || v > (ps->max - d) / 10) {
+            return -1;      // 超过上限
+        }
+        v = v * 10 + d;
+    }
+    if (v < ps->min) {
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+int actuator_cmd_parse(const char *text, size_t len, actuator_cmd_t *out) {
+    const char *p = text;
+    const char *end = text + len;
+    const char *tok;
+    size_t tok_len = next_token(&p, end, &tok);
+    if (tok_len == 0 || tok_len > ACTUATOR_CMD_NAME_MAX) {
+        return ACTUATOR_CMD_UNKNOWN;
+    }
+
+    // 转大写的同时算哈希
+    char name[ACTUATOR_CMD_NAME_MAX];
+    uint32_t h = 2166136261u ^ ACTUATOR_CMD_HASH_SEED;
+    for (size_t i = 0; i < tok_len; i++) {
+        char ch = tok[i];
+        name[i] = (ch >= 'a' && ch <= 'z') ? (char)(ch - 'a' + 'A') : ch;
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+    h ^= h >> 16;
+    int idx = actuator_cmd_slots[h & (ACTUATOR_CMD_HASH_SIZE - 1)];
+    if (idx < 0 || actuator_cmd_specs[idx].name_len != tok_len || memcmp(actuator_cmd_specs[idx].name, name, tok_len) != 0) {
+        return ACTUATOR_CMD_UNKNOWN;
+    }
+
+    const actuator_cmd_spec_t *spec = &actuator_cmd_specs[idx];
+    memset(out, 0, sizeof(*out));
+    out->id = (actuator_cmd_id_t)idx;
+    for (int i = 0; i < spec->param_num; i++) {
+        const actuator_cmd_param_spec_t *ps = &spec->params[i];
+        uint32_t v = ps->def;
+        tok_len = next_token(&p, end, &tok);
+        if (tok_len > 0 && parse_param(ps, tok, tok_len, &v) != 0) {
+            return ACTUATOR_CMD_BAD_PARAM;
+        }
+        store_param(out, ps, v);
+    }
+    if (next_token(&p, end, &tok) > 0) {
+        return ACTUATOR_CMD_BAD_PARAM;     // 多余的参数
+    }
+    return 0;
+}
+
+const char *actuator_cmd_name(actuator_cmd_id_t id) {
+    if ((int)id < 0 || id >= ACTUATOR_CMD_NUM) {
+        return NULL;
+    }
+    return actuator_cmd_specs[id].name;
+}
+
+int actuator_cmd_format(const actuator_cmd_t *cmd, char *out, size_t out_len) {
+    const char *name = actuator_cmd_name(cmd->id);
+    if (name == NULL) {
+        return -1;
+    }
+    const actuator_cmd_spec_t *spec = &actuator_cmd_specs[cmd->id];
+    size_t n = (size_t)snprintf(out, out_len, "%s", name);
+    for (int i = 0; i < spec->param_num; i++) {
+        const actuator_cmd_param_spec_t *ps = &spec->params[i];
+        uint32_t v = load_param(cmd, ps);
+        char *dst = n < out_len ? out + n : NULL;
+        size_t room = n < out_len ? out_len - n : 0;
+        if (ps->values != NULL) {
+            n += (size_t)snprintf(dst, room, " %s", v <= ps->max ? ps->values[v] : "?");
+        } else {
+            n += (size_t)snprintf(dst, room, " %u", (unsigned int)v);
+        }
+    }
+    return (int)n;
+}
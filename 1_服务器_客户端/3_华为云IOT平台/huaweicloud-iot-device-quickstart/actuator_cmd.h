@@ -0,0 +1,72 @@
+// 由gen_commands.py根据actuator_commands.json生成，请勿手工修改
+#ifndef _ACTUATOR_CMD_H
+#define _ACTUATOR_CMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    ACTUATOR_CMD_LED_ON,
+    ACTUATOR_CMD_LED_OFF,
+    ACTUATOR_CMD_LED_PATTERN,
+    ACTUATOR_CMD_BUZZER_ON,
+    ACTUATOR_CMD_BUZZER_OFF,
+    ACTUATOR_CMD_NUM
+} actuator_cmd_id_t;
+
+#define ACTUATOR_CMD_UNKNOWN     (-1)   // 不是命令
+#define ACTUATOR_CMD_BAD_PARAM   (-2)   // 是命令，但参数不合法
+#define ACTUATOR_CMD_NAME_MAX    11     // 最长命令名
+#define ACTUATOR_CMD_PARAM_MAX   2      // 一条命令最多的参数数
+
+// 参数pattern的取值
+typedef enum {
+    ACTUATOR_CMD_PATTERN_FLOW,
+    ACTUATOR_CMD_PATTERN_BLINK,
+    ACTUATOR_CMD_PATTERN_BREATH,
+} actuator_cmd_pattern_t;
+
+// LED_ON 打开LED
+typedef struct {
+    uint8_t index;               // 0~4，LED编号，0表示全部，默认0
+    uint8_t brightness;          // 0~100，亮度（%），默认100
+} actuator_cmd_led_on_t;
+
+// LED_OFF 关闭LED
+typedef struct {
+    uint8_t index;               // 0~4，LED编号，0表示全部，默认0
+} actuator_cmd_led_off_t;
+
+// LED_PATTERN LED灯效
+typedef struct {
+    uint8_t pattern;             // actuator_cmd_pattern_t，流水/闪烁/呼吸，默认flow
+    uint16_t period_ms;          // 50~10000，一个周期的时长（毫秒），默认500
+} actuator_cmd_led_pattern_t;
+
+// BUZZER_ON 打开蜂鸣器
+typedef struct {
+    uint32_t duration_ms;        // 0~600000，鸣叫时长（毫秒），0表示一直响到BUZZER_OFF，默认0
+} actuator_cmd_buzzer_on_t;
+
+// 一条解析好的命令，参数按id取对应的成员
+typedef struct {
+    actuator_cmd_id_t id;
+    union {
+        actuator_cmd_led_on_t led_on;
+        actuator_cmd_led_off_t led_off;
+        actuator_cmd_led_pattern_t led_pattern;
+        actuator_cmd_buzzer_on_t buzzer_on;
+    };
+} actuator_cmd_t;
+
+// 解析一条命令文本"NAME 参数1 参数2..."：命令名不区分大小写，参数按顺序给出，省略的取默认值。
+// 成功返回0；不是命令返回ACTUATOR_CMD_UNKNOWN；参数不合法或多余返回ACTUATOR_CMD_BAD_PARAM
+int actuator_cmd_parse(const char *text, size_t len, actuator_cmd_t *out);
+
+// 命令名，id无效返回NULL
+const char *actuator_cmd_name(actuator_cmd_id_t id);
+
+// 把命令写成规范文本（命令名加全部参数），返回值同snprintf
+int actuator_cmd_format(const actuator_cmd_t *cmd, char *out, size_t out_len);
+
+#endif
@@ -0,0 +1,144 @@
+// 执行器命令解析基准
+// 对下面录制的命令文本（合法命令、省略参数、小写命令名、参数越界、不是命令），先检查actuator_cmd_parse()的
+// 返回值和actuator_cmd_format()写回的规范文本是否符合预期、规范文本再解析是否得到同一条命令，
+// 再各循环若干次统计每条命令的解析和格式化耗时，并与原先client_c.c里逐个strstr()只认命令名的方式对比：
+//   make actuator_cmd_bench && ./actuator_cmd_bench -n 1000000
+// 结果不符合预期时返回1。
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "actuator_cmd.h"
+
+typedef struct {
+    const char* text;
+    int ret;                    // 期望的解析结果
+    const char* canonical;      // 期望的规范文本（解析成功时）
+} sample_t;
+
+static const sample_t samples[] = {
+    { "LED_ON 2 50",            0,                       "LED_ON 2 50" },
+    { "LED_ON",                 0,                       "LED_ON 0 100" },
+    { "led_off 3",              0,                       "LED_OFF 3" },
+    { "LED_PATTERN blink 200",  0,                       "LED_PATTERN blink 200" },
+    { "LED_PATTERN breath",     0,                       "LED_PATTERN breath 500" },
+    { "BUZZER_ON 1500",         0,                       "BUZZER_ON 1500" },
+    { "BUZZER_OFF",             0,                       "BUZZER_OFF" },
+    { "LED_ON 9 50",            ACTUATOR_CMD_BAD_PARAM,  NULL },
+    { "LED_PATTERN rainbow",    ACTUATOR_CMD_BAD_PARAM,  NULL },
+    { "BUZZER_OFF 1",           ACTUATOR_CMD_BAD_PARAM,  NULL },
+    { "CONNECTED",              ACTUATOR_CMD_UNKNOWN,    NULL },
+    { "无法获取 火星 的天气信息", ACTUATOR_CMD_UNKNOWN,    NULL },
+};
+
+#define SAMPLE_NUM (int)(sizeof(samples) / sizeof(samples[0]))
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 原先client_c.c的识别方式（基准）：只认4个不带参数的命令名，参数不解析
+static int parse_reference(const char* message) {
+    if (strstr(message, "LED_ON") || strstr(message, "led_on")) {
+        return 1;
+    } else if (strstr(message, "LED_OFF") || strstr(message, "led_off")) {
+        return 2;
+    } else if (strstr(message, "BUZZER_ON") || strstr(message, "buzzer_on")) {
+        return 3;
+    } else if (strstr(message, "BUZZER_OFF") || strstr(message, "buzzer_off")) {
+        return 4;
+    }
+    return 0;
+}
+
+// 检查一条样本，符合预期返回1
+static int check_sample(const sample_t* s, size_t len) {
+    actuator_cmd_t cmd, again;
+    char text[64];
+    memset(&cmd, 0, sizeof(cmd));
+    memset(&again, 0, sizeof(again));
+
+    int ret = actuator_cmd_parse(s->text, len, &cmd);
+    if (ret != s->ret) {
+        printf("%-28s 返回%d，期望%d  不符!\n", s->text, ret, s->ret);
+        return 0;
+    }
+    if (ret != 0) {
+        printf("%-28s 返回%d\n", s->text, ret);
+        return 1;
+    }
+    int n = actuator_cmd_format(&cmd, text, sizeof(text));
+    int ok = n > 0 && strcmp(text, s->canonical) == 0 &&
+             actuator_cmd_parse(text, (size_t)n, &again) == 0 && memcmp(&cmd, &again, sizeof(cmd)) == 0;
+    printf("%-28s -> %-24s %s\n", s->text, text, ok ? "一致" : "不符!");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            iterations = atoi(optarg);
+        } else {
+            fprintf(stderr, "用法: %s [-n 每条循环次数]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t lens[SAMPLE_NUM];
+    int failed = 0;
+    for (int i = 0; i < SAMPLE_NUM; i++) {
+        lens[i] = strlen(samples[i].text);
+        if (!check_sample(&samples[i], lens[i])) {
+            failed = 1;
+        }
+    }
+
+    actuator_cmd_t cmd;
+    volatile int sink = 0;
+    double total = (double)iterations * SAMPLE_NUM;
+
+    double start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < SAMPLE_NUM; i++) {
+            sink += parse_reference(samples[i].text);
+        }
+    }
+    double ref_ns = (now_ns() - start) / total;
+
+    start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < SAMPLE_NUM; i++) {
+            sink += actuator_cmd_parse(samples[i].text, lens[i], &cmd);
+        }
+    }
+    double parse_ns = (now_ns() - start) / total;
+
+    // 格式化只对解析成功的命令做
+    actuator_cmd_t parsed[SAMPLE_NUM];
+    int parsed_num = 0;
+    for (int i = 0; i < SAMPLE_NUM; i++) {
+        if (actuator_cmd_parse(samples[i].text, lens[i], &parsed[parsed_num]) == 0) {
+            parsed_num++;
+        }
+    }
+    char text[64];
+    start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < parsed_num; i++) {
+            sink += actuator_cmd_format(&parsed[i], text, sizeof(text));
+        }
+    }
+    double format_ns = (now_ns() - start) / ((double)iterations * parsed_num);
+
+    printf("strstr只认命令名:   每条%.1fns\n", ref_ns);
+    printf("actuator_cmd_parse: 每条%.1fns（含参数解析和范围检查）\n", parse_ns);
+    printf("actuator_cmd_format: 每条%.1fns\n", format_ns);
+    return failed;
+}
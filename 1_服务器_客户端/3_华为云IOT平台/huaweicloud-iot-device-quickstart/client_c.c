@@ -1,4 +1,5 @@
 #include "client_c.h"
+#include "weather_text.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,11 +10,30 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
 #include <time.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <stdatomic.h>
 #include "include/util/LogUtil.h"
-#include "include/third_party/cjson/cJSON.h"
-#include "include/util/JSONUtil.h"
+
+// 断线重连和心跳
+// 连接失败后按指数退避重试，从几毫秒开始，每次翻倍并加随机抖动，上限几秒，一直重试到client_c_stop；
+// 中继重启时通常几十毫秒内就能连回去。连上后空闲一个心跳周期就发"PING\n"，服务器回"PONG\n"，
+// 收到任何数据都算对端活着；连续heartbeat_miss_max个心跳没有回应就认为连接已死，主动断开重连，
+// 不用等recv返回0（对端掉电或网线断开时recv可能永远等不到）。内核层面另开TCP保活兜底。
+#define BACKOFF_MIN_MS          10      // 第一次重试前的等待
+#define BACKOFF_MAX_MS          5000    // 重试等待上限
+#define CONNECT_TIMEOUT_MS      2000    // 单次连接超时
+#define HEARTBEAT_INTERVAL_MS   1000    // 默认心跳周期
+#define HEARTBEAT_MISS_MAX      3       // 默认允许连续没有回应的心跳数
+#define KEEPALIVE_IDLE_S        10      // TCP保活：空闲多久开始探测
+#define KEEPALIVE_INTERVAL_S    2       // TCP保活：探测间隔
+#define KEEPALIVE_COUNT         3       // TCP保活：探测失败几次断开
+
 // 内部状态
 static client_c_config_t client_config = {
     .server_ip = SERVER_IP,
@@ -21,25 +41,140 @@ static client_c_config_t client_config = {
     .client_id = CLIENT_C_ID,
     .weather_callback = NULL,
     .command_callback = NULL,
-    .status_callback = NULL
+    .status_callback = NULL,
+    .heartbeat_interval_ms = HEARTBEAT_INTERVAL_MS,
+    .heartbeat_miss_max = HEARTBEAT_MISS_MAX
 };
 
 static int tcp_socket = -1;
 static pthread_t tcp_thread = 0;
 static volatile bool tcp_running = false;
 static volatile client_c_state_t client_state = CLIENT_C_DISCONNECTED;
-static pthread_mutex_t tcp_mutex = PTHREAD_MUTEX_INITIALIZER;
 static bool debug_mode = false;
 
+static const char heartbeat_ping[] = "PING\n";
+static const char heartbeat_pong[] = "PONG\n";
+
+static client_c_link_stats_t link_stats;
+static unsigned int backoff_seed = 0;
+
+// FIFO写端：打开一次长期持有，每条消息一次writev。
+// 只在派发线程（或调用client_c_dispatch的宿主线程）里写，不需要加锁；计数器只增不减，读取时不要求精确。
+#define FIFO_REOPEN_INTERVAL 1  // 没有读者时重新打开的最短间隔（秒），期间的消息直接计入丢弃
+
+typedef struct {
+    const char* path;
+    int fd;
+    time_t retry_at;            // 打开失败后，到这个时间之前不再尝试
+    unsigned long written;      // 写入成功的消息数
+    unsigned long lost;         // 没有读者、管道已满等原因丢弃的消息数
+    bool lost_reported;         // 本轮丢弃已经打过日志
+} fifo_writer_t;
+
+// 接收缓冲：服务器按字节流转发，一次recv可能包含多条消息，也可能只有半条天气记录或半行文本。
+// 每次recv尽量多读，读到的完整消息全部处理完，剩下的半条移到缓冲开头等下次补齐。
+// 文本消息以换行结尾，没有换行的半行要等换行到了（或缓冲满了）才处理。
+#define RX_BUF_SIZE 8192
+
+static char rx_buf[RX_BUF_SIZE + 1];   // 多一个字节，文本消息处理时临时放结束符
+static size_t rx_len = 0;
+
+static fifo_writer_t command_fifo = { .path = COMMAND_FIFO, .fd = -1 };
+static fifo_writer_t weather_fifo = { .path = WEATHER_FIFO, .fd = -1 };
+
+// 事件队列：TCP线程只负责收和解码，解码好的天气记录和命令放进单生产者单消费者的无锁环形队列，
+// 回调和FIFO写入由派发线程（或宿主事件循环）执行，消费者再慢也不会耽误读socket。
+// 队列满时丢弃新事件并计数。消费者没事可做时先置consumer_waiting再检查一次队列才睡，
+// 生产者放入后看到这个标志才写eventfd唤醒，平时放入不做系统调用。
+#define EVENT_RING_SIZE 64      // 2的幂
+#define EVENT_TEXT_LEN 64       // 命令原文（写入命令FIFO）的长度上限
+
+typedef enum {
+    EVENT_WEATHER,
+    EVENT_COMMAND
+} event_kind_t;
+
+typedef struct {
+    event_kind_t kind;
+    double enqueued_ms;
+    union {
+        weather_record_t weather;
+        struct {
+            actuator_cmd_t cmd;
+            char text[EVENT_TEXT_LEN];
+        } command;
+    };
+} client_c_event_t;
+
+static client_c_event_t event_ring[EVENT_RING_SIZE];
+static _Atomic uint32_t ring_head = 0;      // 下一个要取的位置，只有消费者写
+static _Atomic uint32_t ring_tail = 0;      // 下一个要放的位置，只有生产者写
+static _Atomic int consumer_waiting = 0;    // 消费者准备睡眠，生产者放入后需要唤醒
+static int event_fd = -1;
+static pthread_t dispatch_thread = 0;
+static volatile bool dispatch_running = false;
+
+// 队列统计：enqueued/dropped/max_depth只由生产者写，dispatched/wait只由消费者写
+static unsigned long queue_enqueued = 0;
+static unsigned long queue_dropped = 0;
+static unsigned int queue_max_depth = 0;
+static unsigned long queue_dispatched = 0;
+static double queue_wait_total_ms = 0;
+static double queue_wait_max_ms = 0;
+
+// 发送队列：client_c_send_command可能在云平台SDK的回调线程里调用，不能在那里等网络。
+// 调用方把命令复制进多生产者单消费者的无锁队列（每个槽带序号，生产者用CAS抢位置）就返回；
+// TCP线程在同一个poll里等socket和tx_event_fd，醒来后把排着的命令一次sendmsg（writev加MSG_NOSIGNAL）发出。
+// 所有写socket的操作（身份标识、心跳、命令）都在TCP线程里，不再需要互斥锁。
+// 断线期间排着的命令重连后补发，排队超过TX_MAX_AGE_MS的不再发送，计入过期。
+// 每条命令在槽里以换行结尾，一次发出的多条命令到了对端仍能按换行分开。
+#define TX_QUEUE_SIZE   64      // 2的幂
+#define TX_CMD_MAX      256     // 单条命令的长度上限
+#define TX_MAX_AGE_MS   5000    // 命令排队超过这个时间就不再发送
+
+typedef struct {
+    _Atomic uint32_t seq;       // 等于位置号时空闲可写，等于位置号+1时已写好可发
+    uint16_t len;
+    double enqueued_ms;
+    char data[TX_CMD_MAX + 1];  // 命令加结尾的换行
+} tx_slot_t;
+
+static tx_slot_t tx_queue[TX_QUEUE_SIZE];
+static _Atomic uint32_t tx_enqueue_pos = 0;     // 生产者抢占的下一个位置
+static uint32_t tx_dequeue_pos = 0;             // 只有TCP线程读写
+static _Atomic int tx_signalled = 0;            // 已写过tx_event_fd、TCP线程还没处理，后来的生产者不必再写
+static int tx_event_fd = -1;
+
+// 发送统计：生产者侧用原子计数，其余只由TCP线程写
+static _Atomic unsigned long tx_queued = 0;
+static _Atomic unsigned long tx_overflow = 0;
+static unsigned long tx_sent = 0;
+static unsigned long tx_expired = 0;
+static unsigned long tx_failed = 0;
+static unsigned long tx_batches = 0;
+static unsigned int tx_max_batch = 0;
+static double tx_latency_total_ms = 0;
+static double tx_latency_max_ms = 0;
+
 // 内部函数声明
 static void* tcp_client_thread_func(void* arg);
 static bool tcp_connect_to_server(void);
 static void tcp_disconnect(void);
 static bool tcp_send_identity(void);
-static bool tcp_receive_message(char* buffer, int buffer_size, int timeout_ms);
+static int tcp_receive(int timeout_ms);
+static int tcp_flush_outbound(void);
+static void tcp_dispatch_messages(void);
+static void tcp_session(void);
+static double now_ms(void);
 static void update_state(client_c_state_t new_state);
-static void parse_and_handle_message(const char* message);
-static command_type_t parse_command_type(const char* message);
+static void tcp_handle_text(char* text, size_t len);
+static void parse_and_handle_message(const char* message, int len);
+static void handle_weather_record(const weather_record_t* rec);
+static client_c_event_t* event_reserve(void);
+static void event_publish(client_c_event_t* ev);
+static void* dispatch_thread_func(void* arg);
+static bool fifo_writer_write(fifo_writer_t* w, const struct iovec* iov, int iovcnt);
+static void fifo_writer_close(fifo_writer_t* w);
 
 // 初始化客户端C
 bool client_c_init(client_c_config_t* config) {
@@ -67,12 +202,34 @@ bool client_c_init(client_c_config_t* config) {
     if (config->status_callback) {
         client_config.status_callback = config->status_callback;
     }
+    client_config.external_dispatch = config->external_dispatch;
+    client_config.no_weather_fifo = config->no_weather_fifo;
+    // 心跳周期为0取默认值，小于0关闭心跳；允许的未回应心跳数为0取默认值
+    client_config.heartbeat_interval_ms = config->heartbeat_interval_ms != 0 ?
+                                          config->heartbeat_interval_ms : HEARTBEAT_INTERVAL_MS;
+    client_config.heartbeat_miss_max = config->heartbeat_miss_max > 0 ?
+                                       config->heartbeat_miss_max : HEARTBEAT_MISS_MAX;
     
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 初始化成功\n");
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 服务器地址: %s:%d\n", 
               client_config.server_ip, client_config.server_port);
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 客户端ID: %s\n", client_config.client_id);
     
+    // 发送队列：每个槽的序号初始为自己的位置号，表示空闲
+    if (tx_event_fd < 0) {
+        for (uint32_t i = 0; i < TX_QUEUE_SIZE; i++) {
+            atomic_init(&tx_queue[i].seq, i);
+        }
+        tx_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (tx_event_fd < 0) {
+            printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 创建eventfd失败: %s\n", strerror(errno));
+            return false;
+        }
+    }
+    
+    // FIFO读端退出后写入会触发SIGPIPE，默认动作会终止整个网关；忽略后write返回EPIPE，由写端重新打开
+    signal(SIGPIPE, SIG_IGN);
+    
     return true;
 }
 
@@ -86,6 +243,30 @@ bool client_c_start(void) {
     update_state(CLIENT_C_CONNECTING);
     tcp_running = true;
     
+    if (event_fd < 0) {
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd < 0) {
+            printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 创建eventfd失败: %s\n", strerror(errno));
+            tcp_running = false;
+            update_state(CLIENT_C_ERROR);
+            return false;
+        }
+    }
+    
+    // 创建派发线程（宿主自己派发时不需要）
+    if (!client_config.external_dispatch && !dispatch_running) {
+        dispatch_running = true;
+        int ret = pthread_create(&dispatch_thread, NULL, dispatch_thread_func, NULL);
+        if (ret != 0) {
+            printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 创建派发线程失败: %s\n", strerror(ret));
+            dispatch_running = false;
+            tcp_running = false;
+            update_state(CLIENT_C_ERROR);
+            return false;
+        }
+        pthread_detach(dispatch_thread);
+    }
+    
     // 创建TCP客户端线程
     int ret = pthread_create(&tcp_thread, NULL, tcp_client_thread_func, NULL);
     if (ret != 0) {
@@ -111,6 +292,13 @@ void client_c_stop(void) {
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 正在停止...\n");
     tcp_running = false;
     
+    // 唤醒派发线程让它退出
+    if (dispatch_running) {
+        dispatch_running = false;
+        uint64_t one = 1;
+        write(event_fd, &one, sizeof(one));
+    }
+    
     // 关闭socket以唤醒阻塞的recv
     if (tcp_socket >= 0) {
         shutdown(tcp_socket, SHUT_RDWR);
@@ -122,70 +310,128 @@ void client_c_stop(void) {
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已停止\n");
 }
 
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 第attempt次重试前的等待：指数增长，取[一半, 全部]之间的随机值，避免多个网关同时重连
+static int backoff_delay_ms(int attempt) {
+    int base = BACKOFF_MIN_MS;
+    for (int i = 1; i < attempt && base < BACKOFF_MAX_MS; i++) {
+        base *= 2;
+    }
+    if (base > BACKOFF_MAX_MS) {
+        base = BACKOFF_MAX_MS;
+    }
+    return base / 2 + rand_r(&backoff_seed) % (base / 2 + 1);
+}
+
+// 等待ms毫秒，期间client_c_stop能及时打断
+static void sleep_while_running(int ms) {
+    double until = now_ms() + ms;
+    while (tcp_running) {
+        double left = until - now_ms();
+        if (left <= 0) {
+            break;
+        }
+        poll(NULL, 0, left < 100 ? (int)left + 1 : 100);
+    }
+}
+
 // TCP客户端线程函数
 static void* tcp_client_thread_func(void* arg) {
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: TCP客户端线程启动\n");
     
-    // 连接重试机制
-    int retry_count = 0;
-    const int max_retries = 10;
+    backoff_seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+    int attempt = 0;
+    bool was_connected = false;
+    double down_since = now_ms();
     
     while (tcp_running) {
-        if (tcp_connect_to_server()) {
-            retry_count = 0; // 连接成功，重置重试计数
-            
-            // 发送身份标识
-            if (!tcp_send_identity()) {
-                printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 发送身份标识失败\n");
-                tcp_disconnect();
-                continue;
-            }
-            
-            // 主消息循环
-            char buffer[4096];
-            while (tcp_running && tcp_socket >= 0) {
-                memset(buffer, 0, sizeof(buffer));
-                
-                if (tcp_receive_message(buffer, sizeof(buffer), 5000)) {
-                    // 处理接收到的消息
-                    parse_and_handle_message(buffer);
-                } else {
-                    // 接收超时或错误
-                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                        // 超时或中断，继续循环
-                        continue;
-                    } else {
-                        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 接收消息错误: %s\n", strerror(errno));
-                        break;
-                    }
-                }
+        if (!tcp_connect_to_server() || !tcp_send_identity()) {
+            tcp_disconnect();
+            attempt++;
+            int delay = backoff_delay_ms(attempt);
+            printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 连接失败，%dms后重试（第%d次）\n", delay, attempt);
+            sleep_while_running(delay);
+            continue;
+        }
+        
+        // 连上了：记录从断开到恢复用了多久
+        double downtime = now_ms() - down_since;
+        if (was_connected) {
+            link_stats.reconnects++;
+            link_stats.last_downtime_ms = downtime;
+            if (downtime > link_stats.max_downtime_ms) {
+                link_stats.max_downtime_ms = downtime;
             }
+            printfLog(EN_LOG_LEVEL_INFO, "Client_C: 重连成功，断开%.1fms，尝试%d次（累计重连%lu次）\n",
+                      downtime, attempt + 1, link_stats.reconnects);
         } else {
-            retry_count++;
-            if (retry_count < max_retries) {
-                printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 连接失败，%d秒后重试 (%d/%d)\n", 
-                          retry_count, retry_count, max_retries);
-                sleep(retry_count); // 指数退避
-            } else {
-                printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 达到最大重试次数\n");
-                update_state(CLIENT_C_ERROR);
-                break;
-            }
+            printfLog(EN_LOG_LEVEL_INFO, "Client_C: 首次连接用时%.1fms，尝试%d次\n", downtime, attempt + 1);
         }
+        was_connected = true;
+        attempt = 0;
         
-        // 断开连接
-        tcp_disconnect();
+        tcp_session();
         
-        // 如果还在运行状态，等待一会儿再重连
-        if (tcp_running) {
-            sleep(2);
-        }
+        tcp_disconnect();
+        down_since = now_ms();
     }
     
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: TCP客户端线程退出\n");
     return NULL;
 }
 
+// 一次连接的消息循环：收消息、空闲时发心跳，连接断开或心跳超时返回
+static void tcp_session(void) {
+    int interval = client_config.heartbeat_interval_ms;
+    double now = now_ms();
+    double next_ping = now + interval;
+    int misses = 0;
+    
+    rx_len = 0;
+    while (tcp_running && tcp_socket >= 0) {
+        // 没有心跳时也定期醒来检查tcp_running
+        int wait = 5000;
+        if (interval > 0) {
+            double left = next_ping - now;
+            wait = left <= 0 ? 0 : (left < wait ? (int)left + 1 : wait);
+        }
+        
+        int len = tcp_receive(wait);
+        if (len < 0) {
+            return;
+        }
+        now = now_ms();
+        if (len > 0) {
+            // 收到任何数据都说明对端活着
+            misses = 0;
+            next_ping = now + interval;
+            tcp_dispatch_messages();
+            continue;
+        }
+        
+        if (interval <= 0 || now < next_ping) {
+            continue;
+        }
+        if (misses >= client_config.heartbeat_miss_max) {
+            link_stats.heartbeat_timeouts++;
+            printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 连续%d次心跳没有回应，连接已失效，重新连接\n", misses);
+            return;
+        }
+        ssize_t sent = send(tcp_socket, heartbeat_ping, sizeof(heartbeat_ping) - 1, MSG_NOSIGNAL);
+        if (sent < 0) {
+            printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 发送心跳失败: %s\n", strerror(errno));
+            return;
+        }
+        misses++;
+        next_ping = now + interval;
+    }
+}
+
 // 连接到服务器
 static bool tcp_connect_to_server(void) {
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 正在连接到服务器 %s:%d\n", 
@@ -198,15 +444,22 @@ static bool tcp_connect_to_server(void) {
         return false;
     }
     
-    // 设置socket选项
+    // 设置socket选项：小消息立即发出；开TCP保活，对端消失而应用层心跳又被关闭时由内核兜底
     int opt = 1;
     setsockopt(tcp_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    // 设置接收超时
-    struct timeval tv;
-    tv.tv_sec = 5;
-    tv.tv_usec = 0;
-    setsockopt(tcp_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(tcp_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    setsockopt(tcp_socket, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+    int keep_idle = KEEPALIVE_IDLE_S;
+    int keep_interval = KEEPALIVE_INTERVAL_S;
+    int keep_count = KEEPALIVE_COUNT;
+    setsockopt(tcp_socket, IPPROTO_TCP, TCP_KEEPIDLE, &keep_idle, sizeof(keep_idle));
+    setsockopt(tcp_socket, IPPROTO_TCP, TCP_KEEPINTVL, &keep_interval, sizeof(keep_interval));
+    setsockopt(tcp_socket, IPPROTO_TCP, TCP_KEEPCNT, &keep_count, sizeof(keep_count));
+#ifdef TCP_USER_TIMEOUT
+    // 发出的数据这么久没有被确认就断开，不等内核默认的十几分钟重传
+    unsigned int user_timeout = (KEEPALIVE_IDLE_S + KEEPALIVE_INTERVAL_S * KEEPALIVE_COUNT) * 1000;
+    setsockopt(tcp_socket, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout));
+#endif
     
     // 准备服务器地址
     struct sockaddr_in server_addr;
@@ -221,13 +474,29 @@ static bool tcp_connect_to_server(void) {
         return false;
     }
     
-    // 连接服务器
+    // 连接服务器：非阻塞连接加超时，服务器不可达时不会卡在内核的SYN重传上
+    int flags = fcntl(tcp_socket, F_GETFL, 0);
+    fcntl(tcp_socket, F_SETFL, flags | O_NONBLOCK);
+    int err = 0;
     if (connect(tcp_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 连接失败: %s\n", strerror(errno));
+        err = errno;
+        if (err == EINPROGRESS) {
+            struct pollfd pfd = { .fd = tcp_socket, .events = POLLOUT };
+            socklen_t err_len = sizeof(err);
+            if (poll(&pfd, 1, CONNECT_TIMEOUT_MS) <= 0) {
+                err = ETIMEDOUT;
+            } else if (getsockopt(tcp_socket, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0) {
+                err = errno;
+            }
+        }
+    }
+    if (err != 0) {
+        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 连接失败: %s\n", strerror(err));
         close(tcp_socket);
         tcp_socket = -1;
         return false;
     }
+    fcntl(tcp_socket, F_SETFL, flags);
     
     printfLog(EN_LOG_LEVEL_INFO, "Client_C: 连接服务器成功\n");
     update_state(CLIENT_C_CONNECTED);
@@ -251,9 +520,7 @@ static bool tcp_send_identity(void) {
     }
     
     // 发送身份标识 "CLIENT_C"
-    pthread_mutex_lock(&tcp_mutex);
-    int bytes_sent = send(tcp_socket, "CLIENT_C", 8, 0);
-    pthread_mutex_unlock(&tcp_mutex);
+    int bytes_sent = send(tcp_socket, "CLIENT_C", 8, MSG_NOSIGNAL);
     
     if (bytes_sent < 0) {
         printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 发送身份标识失败: %s\n", strerror(errno));
@@ -264,62 +531,284 @@ static bool tcp_send_identity(void) {
     }
 }
 
-// 接收消息（带超时）
-static bool tcp_receive_message(char* buffer, int buffer_size, int timeout_ms) {
-    if (tcp_socket < 0 || buffer == NULL || buffer_size <= 0) {
-        return false;
+// 收到的数据中开头的心跳回应直接跳过，返回跳过的字节数
+static size_t skip_heartbeats(const char* p, size_t left) {
+    size_t skipped = 0;
+    size_t n = sizeof(heartbeat_pong) - 1;
+    while (left - skipped >= n && memcmp(p + skipped, heartbeat_pong, n) == 0) {
+        skipped += n;
     }
+    return skipped;
+}
+
+// 把iov全部发出，部分发送时接着发剩下的；失败返回false
+static bool tcp_send_all(struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)iovcnt };
+        ssize_t sent = sendmsg(tcp_socket, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        while (iovcnt > 0 && (size_t)sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+// 发送队列中排着的命令（TCP线程调用），发送失败返回-1
+static int tcp_flush_outbound(void) {
+    uint64_t count;
+    read(tx_event_fd, &count, sizeof(count));
+    // 先清标志再取，取的过程中新放入的命令会重新通知，不会漏
+    atomic_store(&tx_signalled, 0);
     
-    // 设置接收超时
-    struct timeval tv;
-    tv.tv_sec = timeout_ms / 1000;
-    tv.tv_usec = (timeout_ms % 1000) * 1000;
-    setsockopt(tcp_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    
-    int bytes_received = recv(tcp_socket, buffer, buffer_size - 1, 0);
-    
-    if (bytes_received > 0) {
-        buffer[bytes_received] = '\0';
+    for (;;) {
+        struct iovec iov[TX_QUEUE_SIZE];
+        int iovcnt = 0;
+        uint32_t start = tx_dequeue_pos;
+        double now = now_ms();
+        
+        while (tx_dequeue_pos - start < TX_QUEUE_SIZE) {
+            tx_slot_t* slot = &tx_queue[tx_dequeue_pos & (TX_QUEUE_SIZE - 1)];
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tx_dequeue_pos + 1) {
+                break;
+            }
+            double latency = now - slot->enqueued_ms;
+            if (latency > TX_MAX_AGE_MS) {
+                tx_expired++;
+                printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 命令排队%.0fms未能发出，丢弃: %.*s\n",
+                          latency, (int)slot->len - 1, slot->data);
+            } else {
+                iov[iovcnt].iov_base = slot->data;
+                iov[iovcnt].iov_len = slot->len;
+                iovcnt++;
+                tx_latency_total_ms += latency;
+                if (latency > tx_latency_max_ms) {
+                    tx_latency_max_ms = latency;
+                }
+            }
+            tx_dequeue_pos++;
+        }
+        if (tx_dequeue_pos == start) {
+            return 0;
+        }
         
-        // 去除可能的换行符
-        if (buffer[bytes_received - 1] == '\n') {
-            buffer[bytes_received - 1] = '\0';
+        bool ok = iovcnt == 0 || tcp_send_all(iov, iovcnt);
+        if (iovcnt > 0) {
+            tx_batches++;
+            if ((unsigned int)iovcnt > tx_max_batch) {
+                tx_max_batch = (unsigned int)iovcnt;
+            }
+            if (ok) {
+                tx_sent += iovcnt;
+                if (debug_mode) {
+                    printfLog(EN_LOG_LEVEL_DEBUG, "Client_C: 一次发送%d条命令\n", iovcnt);
+                }
+            } else {
+                tx_failed += iovcnt;
+                printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 发送命令失败: %s\n", strerror(errno));
+            }
         }
         
-        return true;
+        // 发完再把槽还给生产者（iov指向槽里的数据）
+        for (uint32_t pos = start; pos != tx_dequeue_pos; pos++) {
+            atomic_store_explicit(&tx_queue[pos & (TX_QUEUE_SIZE - 1)].seq, pos + TX_QUEUE_SIZE,
+                                  memory_order_release);
+        }
+        if (!ok) {
+            return -1;
+        }
+    }
+}
+
+// 等待并接收数据（poll计时，不再每次设置SO_RCVTIMEO），返回读到的字节数，超时返回0，对端关闭或出错返回-1。
+// 等待期间有命令排队时顺便发出
+static int tcp_receive(int timeout_ms) {
+    if (tcp_socket < 0) {
+        return -1;
+    }
+    
+    struct pollfd pfd[2] = {
+        { .fd = tcp_socket, .events = POLLIN },
+        { .fd = tx_event_fd, .events = POLLIN },
+    };
+    int ret = poll(pfd, 2, timeout_ms);
+    if (ret == 0 || (ret < 0 && errno == EINTR)) {
+        return 0;
+    }
+    if (ret < 0) {
+        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 等待数据错误: %s\n", strerror(errno));
+        return -1;
+    }
+    if (pfd[1].revents & POLLIN) {
+        if (tcp_flush_outbound() < 0) {
+            return -1;
+        }
+    }
+    if (pfd[0].revents == 0) {
+        return 0;
+    }
+    
+    // 缓冲满了还凑不出一条完整消息，说明数据已乱，丢弃重新开始
+    if (rx_len == RX_BUF_SIZE) {
+        printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 接收缓冲已满，丢弃%zu字节\n", rx_len);
+        rx_len = 0;
+    }
+    
+    ssize_t bytes_received = recv(tcp_socket, rx_buf + rx_len, RX_BUF_SIZE - rx_len, MSG_DONTWAIT);
+    if (bytes_received > 0) {
+        rx_len += bytes_received;
+        return (int)bytes_received;
     } else if (bytes_received == 0) {
         printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 服务器关闭连接\n");
-        return false;
+        return -1;
     } else {
-        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
-            printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 接收数据错误: %s\n", strerror(errno));
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
         }
-        return false;
+        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 接收数据错误: %s\n", strerror(errno));
+        return -1;
     }
 }
 
-// 解析命令类型
-static command_type_t parse_command_type(const char* message) {
-    if (message == NULL) {
-        return CMD_UNKNOWN;
+// 文本的结束位置，0表示还没有完整的文本，等下次recv：
+// 遇到下一条天气记录的魔数时，前面的文本到此为止（没有换行也算完整）；
+// 否则只取到最后一个换行，末尾没有换行的半行、以及缓冲末尾魔数的前1~3个字节都留在缓冲里。
+// 缓冲已满（full）还凑不出换行时，整段当作文本处理
+static size_t text_message_end(const char* data, size_t len, bool full) {
+    uint32_t magic = WEATHER_RECORD_MAGIC;
+    size_t line_end = 0;
+    for (size_t i = 0; i < len; i++) {
+        size_t head = len - i < sizeof(magic) ? len - i : sizeof(magic);
+        if (i > 0 && memcmp(data + i, &magic, head) == 0) {
+            if (head == sizeof(magic)) {
+                return i;
+            }
+            break;
+        }
+        if (data[i] == '\n') {
+            line_end = i + 1;
+        }
     }
+    return line_end > 0 ? line_end : (full ? len : 0);
+}
+
+// 从接收缓冲中取出所有完整消息逐条处理：以记录魔数开头的按定长天气记录切分，
+// 其他按文本处理（文本消息没有长度前缀，以换行或下一条记录为界）
+static void tcp_dispatch_messages(void) {
+    uint32_t magic = WEATHER_RECORD_MAGIC;
+    size_t pos = 0;
     
-    if (strstr(message, "LED_ON") || strstr(message, "led_on")) {
-        return CMD_LED_ON;
-    } else if (strstr(message, "LED_OFF") || strstr(message, "led_off")) {
-        return CMD_LED_OFF;
-    } else if (strstr(message, "BUZZER_ON") || strstr(message, "buzzer_on")) {
-        return CMD_BUZZER_ON;
-    } else if (strstr(message, "BUZZER_OFF") || strstr(message, "buzzer_off")) {
-        return CMD_BUZZER_OFF;
+    while (pos < rx_len) {
+        char* p = rx_buf + pos;
+        size_t left = rx_len - pos;
+        size_t head = left < sizeof(magic) ? left : sizeof(magic);
+        
+        size_t pong = skip_heartbeats(p, left);
+        if (pong > 0) {
+            pos += pong;
+            continue;
+        }
+        
+        if (memcmp(p, &magic, head) == 0) {
+            if (left < sizeof(weather_record_t)) {
+                break;      // 天气记录还没收全，等下次recv补齐
+            }
+            if (weather_record_check(p, sizeof(weather_record_t))) {
+                // 记录在缓冲中的位置不一定对齐，直接复制进队列
+                client_c_event_t* ev = event_reserve();
+                if (ev != NULL) {
+                    ev->kind = EVENT_WEATHER;
+                    memcpy(&ev->weather, p, sizeof(ev->weather));
+                    event_publish(ev);
+                }
+                pos += sizeof(weather_record_t);
+                continue;
+            }
+        }
+        
+        size_t len = text_message_end(p, left, rx_len == RX_BUF_SIZE);
+        if (len == 0) {
+            break;      // 半行文本或半个魔数，等下次recv
+        }
+        tcp_handle_text(p, len);
+        pos += len;
     }
     
-    return CMD_UNKNOWN;
+    memmove(rx_buf, rx_buf + pos, rx_len - pos);
+    rx_len -= pos;
+}
+
+// 旧版文本天气块收齐了（后面是别的消息或这段文本结束）：补上缺的字段后走天气记录的流程
+static void flush_text_weather(weather_record_t* rec, int* fields) {
+    if (*fields == 0) {
+        return;
+    }
+    if (rec->city_name[0] == '\0') {
+        snprintf(rec->city_name, sizeof(rec->city_name), "Unknown");
+    }
+    if (rec->text[0] == '\0') {
+        snprintf(rec->text, sizeof(rec->text), "Unknown");
+    }
+    handle_weather_record(rec);
+    weather_record_init(rec);
+    *fields = 0;
+}
+
+// 处理一段完整的文本（可能有多行），逐行处理：兼容旧版客户端A发来的多行文本天气块，
+// 块里的"键: 值"行一遍扫描写进同一条天气记录，块结束时走天气记录的流程；
+// 其他行（客户端C连发的命令、服务器的确认消息各占一行，可能和天气块在同一段里）照常逐行处理
+static void tcp_handle_text(char* text, size_t len) {
+    weather_record_t rec;
+    weather_record_init(&rec);
+    int fields = 0;
+    
+    char* end = text + len;
+    while (text < end) {
+        char* nl = memchr(text, '\n', end - text);
+        size_t line_len = (nl != NULL ? nl : end) - text;
+        if (line_len > 0 && text[line_len - 1] == '\r') {
+            line_len--;
+        }
+        // 夹在文本中间的心跳应答不是消息
+        bool pong = line_len == sizeof(heartbeat_pong) - 2 && memcmp(text, heartbeat_pong, line_len) == 0;
+        int found = pong ? 0 : weather_text_parse(text, line_len, &rec);
+        if (found > 0) {
+            fields += found;
+        } else if (!pong && line_len > 0) {
+            flush_text_weather(&rec, &fields);
+            // 临时放结束符，处理完恢复（后面可能紧跟着下一行或下一条记录）
+            char saved = text[line_len];
+            text[line_len] = '\0';
+            parse_and_handle_message(text, (int)line_len);
+            text[line_len] = saved;
+        }
+        text = nl != NULL ? nl + 1 : end;
+    }
+    flush_text_weather(&rec, &fields);
 }
 
 // 解析和处理消息
-static void parse_and_handle_message(const char* message) {
-    if (message == NULL || strlen(message) == 0) {
+static void parse_and_handle_message(const char* message, int len) {
+    if (message == NULL || len <= 0) {
+        return;
+    }
+    
+    // 客户端A发来的定长天气记录，字段直接可用，不需要任何文本解析
+    if (weather_record_check(message, len)) {
+        weather_record_t rec;
+        memcpy(&rec, message, sizeof(rec));
+        handle_weather_record(&rec);
         return;
     }
     
@@ -331,134 +820,232 @@ static void parse_and_handle_message(const char* message) {
         return;
     }
     
-    // 检查是否是命令
-    command_type_t cmd_type = parse_command_type(message);
-    if (cmd_type != CMD_UNKNOWN) {
-        // 写入命令FIFO
-        if (access(COMMAND_FIFO, F_OK) == 0) {
-            int fifo_fd = open(COMMAND_FIFO, O_WRONLY | O_NONBLOCK);
-            if (fifo_fd >= 0) {
-                write(fifo_fd, message, strlen(message));
-                write(fifo_fd, "\n", 1);
-                close(fifo_fd);
-                printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已将命令写入FIFO: %s\n", message);
-            }
+    // 检查是否是命令（命令名查生成的完美哈希表，参数按命令表解析；"COMMAND:"前缀来自client_c_send_message）
+    const char* cmd_text = message;
+    if (strncmp(cmd_text, "COMMAND:", 8) == 0) {
+        cmd_text += 8;
+    }
+    actuator_cmd_t cmd;
+    int cmd_ret = actuator_cmd_parse(cmd_text, len - (cmd_text - message), &cmd);
+    if (cmd_ret == ACTUATOR_CMD_BAD_PARAM) {
+        printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 命令参数不合法，忽略: %s\n", cmd_text);
+        return;
+    }
+    if (cmd_ret == 0) {
+        // 命令原文和解析结果一起交给派发线程，写FIFO和回调都在那边
+        client_c_event_t* ev = event_reserve();
+        if (ev != NULL) {
+            ev->kind = EVENT_COMMAND;
+            ev->command.cmd = cmd;
+            snprintf(ev->command.text, sizeof(ev->command.text), "%s", cmd_text);
+            event_publish(ev);
+        }
+        return;
+    }
+    
+    // 其他类型消息
+    if (debug_mode) {
+        printfLog(EN_LOG_LEVEL_DEBUG, "Client_C: 无法识别的消息: %s\n", message);
+    }
+}
+
+// 把一条天气记录交给派发线程
+static void handle_weather_record(const weather_record_t* rec) {
+    client_c_event_t* ev = event_reserve();
+    if (ev != NULL) {
+        ev->kind = EVENT_WEATHER;
+        ev->weather = *rec;
+        event_publish(ev);
+    }
+}
+
+// ==================== 事件队列 ====================
+
+// 取一个空槽（生产者调用），队列满时计入丢弃并返回NULL
+static client_c_event_t* event_reserve(void) {
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    if (tail - head >= EVENT_RING_SIZE) {
+        queue_dropped++;
+        if (queue_dropped == 1 || queue_dropped % 100 == 0) {
+            printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 事件队列已满，消费者太慢，累计丢弃%lu条\n", queue_dropped);
+        }
+        return NULL;
+    }
+    return &event_ring[tail & (EVENT_RING_SIZE - 1)];
+}
+
+// 发布event_reserve取到的槽（生产者调用）
+static void event_publish(client_c_event_t* ev) {
+    ev->enqueued_ms = now_ms();
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed) + 1;
+    atomic_store(&ring_tail, tail);     // seq_cst：与消费者对consumer_waiting的写读配对，不会漏唤醒
+    queue_enqueued++;
+    uint32_t depth = tail - atomic_load_explicit(&ring_head, memory_order_relaxed);
+    if (depth > queue_max_depth) {
+        queue_max_depth = depth;
+    }
+    
+    // 宿主事件循环自己派发时每次都通知；派发线程只在准备睡眠时才需要唤醒
+    if (client_config.external_dispatch ||
+        (atomic_load(&consumer_waiting) && atomic_exchange(&consumer_waiting, 0))) {
+        uint64_t one = 1;
+        write(event_fd, &one, sizeof(one));
+    }
+}
+
+// 执行一个事件：写FIFO、调回调
+static void event_deliver(const client_c_event_t* ev) {
+    if (ev->kind == EVENT_COMMAND) {
+        // 写入命令FIFO，命令和换行一次写入，读端不会读到半条命令
+        struct iovec iov[2] = {
+            { .iov_base = (void*)ev->command.text, .iov_len = strlen(ev->command.text) },
+            { .iov_base = "\n", .iov_len = 1 },
+        };
+        if (fifo_writer_write(&command_fifo, iov, 2)) {
+            printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已将命令写入FIFO: %s\n", ev->command.text);
         }
         
         // 调用命令回调函数
         if (client_config.command_callback) {
-            client_config.command_callback(cmd_type);
+            client_config.command_callback(&ev->command.cmd);
         }
         return;
     }
     
-    // 检查是否是天气数据（包含中文关键词）
-    if (strstr(message, "城市") || strstr(message, "天气") || 
-        strstr(message, "温度") || strstr(message, "湿度")) {
-        
-        // 解析文本格式的天气数据
-        char city[64] = "Unknown";
-        char weather[64] = "Unknown";
-        char temperature[32] = "25.0";
-        char humidity[32] = "60";
-        
-        // 按行分割消息
-        char *message_copy = strdup(message);
-        char *line = strtok(message_copy, "\n");
-        
-        while (line != NULL) {
-            // 去除首尾空白字符
-            char *trimmed = line;
-            while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-            
-            // 查找冒号分隔符
-            char *colon = strstr(trimmed, ":");
-            if (colon) {
-                *colon = '\0';
-                char *key = trimmed;
-                char *value = colon + 1;
-                
-                // 去除value的首尾空白
-                while (*value == ' ' || *value == '\t') value++;
-                char *end = value + strlen(value) - 1;
-                while (end > value && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
-                    *end = '\0';
-                    end--;
-                }
-                
-                // 根据key存储对应的value
-                if (strstr(key, "城市")) {
-                    strncpy(city, value, sizeof(city) - 1);
-                } else if (strstr(key, "天气")) {
-                    strncpy(weather, value, sizeof(weather) - 1);
-                } else if (strstr(key, "温度")) {
-                    // 提取温度数字部分（去除单位）
-                    char temp_num[32] = {0};
-                    int i = 0, j = 0;
-                    for (i = 0; value[i] != '\0' && j < 30; i++) {
-                        if ((value[i] >= '0' && value[i] <= '9') || 
-                            value[i] == '.' || value[i] == '-') {
-                            temp_num[j++] = value[i];
-                        }
-                    }
-                    temp_num[j] = '\0';
-                    if (strlen(temp_num) > 0) {
-                        strncpy(temperature, temp_num, sizeof(temperature) - 1);
-                    }
-                } else if (strstr(key, "湿度")) {
-                    // 提取湿度数字部分
-                    char hum_num[32] = {0};
-                    int i = 0, j = 0;
-                    for (i = 0; value[i] != '\0' && j < 30; i++) {
-                        if ((value[i] >= '0' && value[i] <= '9') || 
-                            value[i] == '.' || value[i] == '-') {
-                            hum_num[j++] = value[i];
-                        }
-                    }
-                    hum_num[j] = '\0';
-                    if (strlen(hum_num) > 0) {
-                        strncpy(humidity, hum_num, sizeof(humidity) - 1);
-                        strcat(humidity, "%");
-                    } else if (strstr(value, "N/A")) {
-                        strcpy(humidity, "N/A");
-                    }
-                }
-            }
-            line = strtok(NULL, "\n");
+    const weather_record_t* rec = &ev->weather;
+    printfLog(EN_LOG_LEVEL_INFO, "Client_C: 收到天气记录: 城市=%s, 天气=%s, 温度=%.1f, 湿度=%u\n",
+              rec->city_name, rec->text, rec->temp_x10 / 10.0, rec->humidity);
+    
+    // 写入天气FIFO，记录小于PIPE_BUF，单次写入是原子的，读端按记录大小读取
+    if (!client_config.no_weather_fifo) {
+        struct iovec iov = { .iov_base = (void*)rec, .iov_len = sizeof(*rec) };
+        if (fifo_writer_write(&weather_fifo, &iov, 1)) {
+            printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已将天气记录写入FIFO\n");
         }
-        
-        free(message_copy);
-        
-        // 构建JSON格式的天气数据
-        char json_buffer[1024];
-        snprintf(json_buffer, sizeof(json_buffer),
-                "{\"city\":\"%s\",\"weather\":\"%s\",\"temperature\":\"%s\",\"humidity\":\"%s\"}",
-                city, weather, temperature, humidity);
-        
-        printfLog(EN_LOG_LEVEL_INFO, "Client_C: 解析后天气数据: %s\n", json_buffer);
-        
-        // 写入天气FIFO
-        if (access(WEATHER_FIFO, F_OK) == 0) {
-            int fifo_fd = open(WEATHER_FIFO, O_WRONLY | O_NONBLOCK);
-            if (fifo_fd >= 0) {
-                write(fifo_fd, json_buffer, strlen(json_buffer));
-                write(fifo_fd, "\n", 1);
-                close(fifo_fd);
-                printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已将天气数据写入FIFO\n");
-            }
+    }
+    
+    // 调用天气回调函数
+    if (client_config.weather_callback) {
+        client_config.weather_callback(rec);
+    }
+}
+
+// 处理队列中的事件（消费者调用），max<=0表示处理到队列为空，返回处理的个数
+int client_c_dispatch(int max) {
+    int n = 0;
+    while (max <= 0 || n < max) {
+        uint32_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        if (head == atomic_load_explicit(&ring_tail, memory_order_acquire)) {
+            break;
         }
-        
-        // 调用天气回调函数
-        if (client_config.weather_callback) {
-            client_config.weather_callback(json_buffer);
+        const client_c_event_t* ev = &event_ring[head & (EVENT_RING_SIZE - 1)];
+        double wait = now_ms() - ev->enqueued_ms;
+        queue_wait_total_ms += wait;
+        if (wait > queue_wait_max_ms) {
+            queue_wait_max_ms = wait;
+        }
+        event_deliver(ev);
+        queue_dispatched++;
+        atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+        n++;
+    }
+    return n;
+}
+
+// 派发线程：有事件就处理，没有就在eventfd上睡
+static void* dispatch_thread_func(void* arg) {
+    (void)arg;
+    while (dispatch_running) {
+        if (client_c_dispatch(0) > 0) {
+            continue;
+        }
+        atomic_store(&consumer_waiting, 1);
+        if (atomic_load(&ring_head) != atomic_load(&ring_tail)) {
+            atomic_store(&consumer_waiting, 0);
+            continue;
         }
+        struct pollfd pfd = { .fd = event_fd, .events = POLLIN };
+        poll(&pfd, 1, 1000);
+        uint64_t count;
+        read(event_fd, &count, sizeof(count));
+        atomic_store(&consumer_waiting, 0);
+    }
+    fifo_writer_close(&command_fifo);
+    fifo_writer_close(&weather_fifo);
+    return NULL;
+}
+
+// 宿主事件循环用：可读时调用client_c_dispatch
+int client_c_event_fd(void) {
+    return event_fd;
+}
+
+// 获取事件队列统计
+void client_c_get_queue_stats(client_c_queue_stats_t* stats) {
+    if (stats == NULL) {
         return;
     }
-    
-    // 其他类型消息
-    if (debug_mode) {
-        printfLog(EN_LOG_LEVEL_DEBUG, "Client_C: 无法识别的消息: %s\n", message);
+    uint32_t head = atomic_load(&ring_head);
+    uint32_t tail = atomic_load(&ring_tail);
+    stats->capacity = EVENT_RING_SIZE;
+    stats->depth = tail - head;
+    stats->max_depth = queue_max_depth;
+    stats->enqueued = queue_enqueued;
+    stats->dispatched = queue_dispatched;
+    stats->dropped = queue_dropped;
+    stats->avg_wait_ms = queue_dispatched > 0 ? queue_wait_total_ms / queue_dispatched : 0;
+    stats->max_wait_ms = queue_wait_max_ms;
+}
+
+// 打开FIFO写端：非阻塞打开，没有读者时open返回ENXIO，之后一段时间内不再重试
+static bool fifo_writer_open(fifo_writer_t* w) {
+    time_t now = time(NULL);
+    if (now < w->retry_at) {
+        return false;
+    }
+    w->fd = open(w->path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (w->fd < 0) {
+        w->retry_at = now + FIFO_REOPEN_INTERVAL;
+        return false;
+    }
+    return true;
+}
+
+static void fifo_writer_close(fifo_writer_t* w) {
+    if (w->fd >= 0) {
+        close(w->fd);
+        w->fd = -1;
+    }
+}
+
+// 写一条消息（各段拼成一次writev，不超过PIPE_BUF时整条写入或整条不写），成功返回true。
+// 读端退出时writev返回EPIPE，关闭后重新打开再试一次；新的读端还没出现就计入丢弃。
+static bool fifo_writer_write(fifo_writer_t* w, const struct iovec* iov, int iovcnt) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (w->fd < 0 && !fifo_writer_open(w)) {
+            break;
+        }
+        ssize_t ret = writev(w->fd, iov, iovcnt);
+        if (ret >= 0) {
+            w->written++;
+            if (w->lost_reported) {
+                printfLog(EN_LOG_LEVEL_INFO, "Client_C: %s读端已恢复，此前累计丢弃%lu条\n", w->path, w->lost);
+                w->lost_reported = false;
+            }
+            return true;
+        }
+        if (errno != EPIPE) {
+            break;      // EAGAIN：读端没有及时读，管道已满
+        }
+        fifo_writer_close(w);
+    }
+    w->lost++;
+    if (!w->lost_reported) {
+        printfLog(EN_LOG_LEVEL_WARNING, "Client_C: %s没有读者或已满，消息丢弃（累计%lu条）\n", w->path, w->lost);
+        w->lost_reported = true;
     }
+    return false;
 }
 
 // 发送命令到服务器
@@ -467,17 +1054,55 @@ bool client_c_send_command(const char* command) {
         printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 无法发送命令，未连接或命令为空\n");
         return false;
     }
+    // 换行是命令之间的分隔，调用方带的结尾换行去掉，中间有换行的命令不发
+    size_t len = strlen(command);
+    while (len > 0 && (command[len - 1] == '\n' || command[len - 1] == '\r')) {
+        len--;
+    }
+    if (len == 0 || len > TX_CMD_MAX) {
+        printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 命令长度%zu超出范围(1~%d)，不发送\n", len, TX_CMD_MAX);
+        return false;
+    }
+    if (memchr(command, '\n', len) != NULL) {
+        printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 命令中间不能有换行，不发送\n");
+        return false;
+    }
     
-    pthread_mutex_lock(&tcp_mutex);
-    int bytes_sent = send(tcp_socket, command, strlen(command), 0);
-    pthread_mutex_unlock(&tcp_mutex);
+    // 抢一个位置：槽的序号等于位置号说明空闲；比位置号小说明消费者还没取走，队列已满
+    uint32_t pos = atomic_load_explicit(&tx_enqueue_pos, memory_order_relaxed);
+    tx_slot_t* slot;
+    for (;;) {
+        slot = &tx_queue[pos & (TX_QUEUE_SIZE - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&tx_enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            unsigned long overflow = atomic_fetch_add(&tx_overflow, 1) + 1;
+            printfLog(EN_LOG_LEVEL_WARNING, "Client_C: 发送队列已满，命令丢弃（累计%lu条）: %s\n", overflow, command);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&tx_enqueue_pos, memory_order_relaxed);
+        }
+    }
     
-    if (bytes_sent < 0) {
-        printfLog(EN_LOG_LEVEL_ERROR, "Client_C: 发送命令失败: %s\n", strerror(errno));
-        return false;
+    memcpy(slot->data, command, len);
+    slot->data[len] = '\n';
+    slot->len = (uint16_t)(len + 1);
+    slot->enqueued_ms = now_ms();
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    atomic_fetch_add(&tx_queued, 1);
+    
+    // TCP线程已被通知过就不必再写eventfd，连发的命令合并成一次发送
+    if (!atomic_exchange(&tx_signalled, 1)) {
+        uint64_t one = 1;
+        write(tx_event_fd, &one, sizeof(one));
     }
     
-    printfLog(EN_LOG_LEVEL_INFO, "Client_C: 已发送命令: %s\n", command);
+    printfLog(EN_LOG_LEVEL_INFO, "Client_C: 命令已排队: %.*s\n", (int)len, command);
     return true;
 }
 
@@ -503,74 +1128,45 @@ bool client_c_send_message(msg_type_t type, const char* data) {
     return client_c_send_command(buffer);
 }
 
-// 解析天气JSON函数定义
-bool parse_weather_json(const char* json_str, char* city, char* weather, char* temperature, char* humidity) {
-    if (!json_str || !city || !weather || !temperature || !humidity) {
-        return false;
-    }
-    
-    // 直接使用cJSON解析
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root) {
-        return false;
-    }
-    
-    // 获取城市
-    cJSON *city_obj = cJSON_GetObjectItem(root, "city");
-    if (city_obj && cJSON_IsString(city_obj)) {
-        strncpy(city, city_obj->valuestring, 63);
-        city[63] = '\0';
-    } else {
-        strcpy(city, "Unknown");
-    }
-    
-    // 获取天气
-    cJSON *weather_obj = cJSON_GetObjectItem(root, "weather");
-    if (weather_obj && cJSON_IsString(weather_obj)) {
-        strncpy(weather, weather_obj->valuestring, 63);
-        weather[63] = '\0';
-    } else {
-        strcpy(weather, "Unknown");
-    }
-    
-    // 获取温度
-    cJSON *temp_obj = cJSON_GetObjectItem(root, "temperature");
-    if (temp_obj) {
-        if (cJSON_IsString(temp_obj)) {
-            strncpy(temperature, temp_obj->valuestring, 31);
-            temperature[31] = '\0';
-        } else if (cJSON_IsNumber(temp_obj)) {
-            snprintf(temperature, 31, "%.1f", temp_obj->valuedouble);
-        } else {
-            strcpy(temperature, "25.0");
-        }
-    } else {
-        strcpy(temperature, "25.0");
-    }
-    
-    // 获取湿度
-    cJSON *hum_obj = cJSON_GetObjectItem(root, "humidity");
-    if (hum_obj) {
-        if (cJSON_IsString(hum_obj)) {
-            strncpy(humidity, hum_obj->valuestring, 31);
-            humidity[31] = '\0';
-        } else if (cJSON_IsNumber(hum_obj)) {
-            snprintf(humidity, 31, "%.0f%%", hum_obj->valuedouble);
-        } else {
-            strcpy(humidity, "60%");
-        }
-    } else {
-        strcpy(humidity, "60%");
+// 获取客户端C当前状态
+client_c_state_t client_c_get_state(void) {
+    return client_state;
+}
+
+// 获取FIFO写入统计
+void client_c_get_fifo_stats(client_c_fifo_stats_t* stats) {
+    if (stats == NULL) {
+        return;
     }
-    
-    cJSON_Delete(root);
-    return true;
+    stats->weather_written = weather_fifo.written;
+    stats->weather_lost = weather_fifo.lost;
+    stats->command_written = command_fifo.written;
+    stats->command_lost = command_fifo.lost;
 }
 
+// 获取连接统计
+void client_c_get_link_stats(client_c_link_stats_t* stats) {
+    if (stats != NULL) {
+        *stats = link_stats;
+    }
+}
 
-// 获取客户端C当前状态
-client_c_state_t client_c_get_state(void) {
-    return client_state;
+// 获取命令发送统计
+void client_c_get_tx_stats(client_c_tx_stats_t* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->capacity = TX_QUEUE_SIZE;
+    stats->depth = atomic_load(&tx_enqueue_pos) - tx_dequeue_pos;
+    stats->queued = atomic_load(&tx_queued);
+    stats->overflow = atomic_load(&tx_overflow);
+    stats->sent = tx_sent;
+    stats->expired = tx_expired;
+    stats->failed = tx_failed;
+    stats->batches = tx_batches;
+    stats->max_batch = tx_max_batch;
+    stats->avg_latency_ms = tx_sent + tx_failed > 0 ? tx_latency_total_ms / (tx_sent + tx_failed) : 0;
+    stats->max_latency_ms = tx_latency_max_ms;
 }
 
 // 检查是否连接
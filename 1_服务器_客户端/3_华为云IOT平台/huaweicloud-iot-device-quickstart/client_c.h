@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <pthread.h>
 
+#include "weather_record.h"     // 与客户端A共用的定长天气记录（位于1_客户端）
+#include "actuator_cmd.h"       // 执行器命令（由actuator_commands.json生成）
+
 // ==================== FIFO路径定义 ====================
 #define FIFO_BASE_PATH "/home/gec/fifofile"
 #define WEATHER_FIFO FIFO_BASE_PATH "/weather_fifo"
@@ -30,18 +33,9 @@ typedef enum {
     MSG_TYPE_IDENTITY
 } msg_type_t;
 
-// 命令类型
-typedef enum {
-    CMD_LED_ON,
-    CMD_LED_OFF,
-    CMD_BUZZER_ON,
-    CMD_BUZZER_OFF,
-    CMD_UNKNOWN
-} command_type_t;
-
 // 客户端C回调函数类型
-typedef void (*client_c_weather_callback_t)(const char* weather_data);
-typedef void (*client_c_command_callback_t)(command_type_t command);
+typedef void (*client_c_weather_callback_t)(const weather_record_t* weather);
+typedef void (*client_c_command_callback_t)(const actuator_cmd_t* command);
 typedef void (*client_c_status_callback_t)(client_c_state_t state);
 
 // 客户端C初始化配置
@@ -52,8 +46,56 @@ typedef struct {
     client_c_weather_callback_t weather_callback;
     client_c_command_callback_t command_callback;
     client_c_status_callback_t status_callback;
+    int heartbeat_interval_ms;      // 心跳周期，0取默认值，小于0关闭心跳
+    int heartbeat_miss_max;         // 连续多少个心跳没有回应就断开重连，0取默认值
+    bool external_dispatch;         // true时不启动派发线程，由宿主事件循环监听client_c_event_fd()并调用client_c_dispatch()
+    bool no_weather_fifo;           // true时天气记录只交给weather_callback，不写weather_fifo（宿主在同一进程里
+                                    // 已经拿到记录，weather_fifo只留给其他进程写入的天气）
 } client_c_config_t;
 
+// 事件队列统计（网络线程到回调之间）
+typedef struct {
+    unsigned int capacity;
+    unsigned int depth;                 // 当前排队的事件数
+    unsigned int max_depth;             // 最深的一次
+    unsigned long enqueued;
+    unsigned long dispatched;
+    unsigned long dropped;              // 队列满而丢弃的事件数
+    double avg_wait_ms;                 // 事件在队列中的平均等待时间
+    double max_wait_ms;
+} client_c_queue_stats_t;
+
+// 命令发送统计（client_c_send_command到socket之间）
+typedef struct {
+    unsigned int capacity;
+    unsigned int depth;                 // 当前排队的命令数
+    unsigned long queued;               // 成功排队的命令数
+    unsigned long overflow;             // 队列满而拒绝的命令数
+    unsigned long sent;
+    unsigned long expired;              // 断线太久、排队超时而丢弃的命令数
+    unsigned long failed;               // 写socket失败的命令数
+    unsigned long batches;              // 发送次数，sent/batches即平均每次合并的命令数
+    unsigned int max_batch;
+    double avg_latency_ms;              // 从排队到发出的平均时间
+    double max_latency_ms;
+} client_c_tx_stats_t;
+
+// 连接统计
+typedef struct {
+    unsigned long reconnects;           // 断开后重连成功的次数
+    unsigned long heartbeat_timeouts;   // 因心跳没有回应而主动断开的次数
+    double last_downtime_ms;            // 最近一次从断开到重连成功的时间
+    double max_downtime_ms;             // 最长的一次
+} client_c_link_stats_t;
+
+// 天气/命令FIFO写入统计
+typedef struct {
+    unsigned long weather_written;
+    unsigned long weather_lost;     // 没有读者或管道已满而丢弃的天气记录数
+    unsigned long command_written;
+    unsigned long command_lost;     // 没有读者或管道已满而丢弃的命令数
+} client_c_fifo_stats_t;
+
 // ==================== 函数声明 ====================
 
 // 初始化客户端C
@@ -65,7 +107,8 @@ bool client_c_start(void);
 // 停止客户端C
 void client_c_stop(void);
 
-// 发送命令到服务器
+// 发送命令到服务器：复制进发送队列后立即返回，不等网络，由TCP线程合并发送。
+// 命令发出时以换行结尾（调用方不用带换行，命令中间不能有换行）。未连接、命令过长或队列已满时返回false
 bool client_c_send_command(const char* command);
 
 // 发送消息到服务器（带类型）
@@ -77,9 +120,26 @@ client_c_state_t client_c_get_state(void);
 // 检查是否连接
 bool client_c_is_connected(void);
 
+// 处理排队的天气记录和命令（写FIFO、调回调），max<=0表示处理到队列为空，返回处理的个数。
+// 默认由内部派发线程调用；external_dispatch时由宿主在同一个线程里调用
+int client_c_dispatch(int max);
+
+// 有事件排队时可读的eventfd，供external_dispatch的宿主放进自己的poll/epoll
+int client_c_event_fd(void);
+
+// 获取事件队列统计
+void client_c_get_queue_stats(client_c_queue_stats_t* stats);
+
+// 获取命令发送统计
+void client_c_get_tx_stats(client_c_tx_stats_t* stats);
+
+// 获取连接统计
+void client_c_get_link_stats(client_c_link_stats_t* stats);
+
+// 获取FIFO写入统计
+void client_c_get_fifo_stats(client_c_fifo_stats_t* stats);
+
 // 设置调试模式
 void client_c_set_debug(bool enable);
 
-// 解析天气JSON函数声明
-bool parse_weather_json(const char* json_str, char* city, char* weather, char* temperature, char* humidity);
 #endif // CLIENT_C_H
\ No newline at end of file
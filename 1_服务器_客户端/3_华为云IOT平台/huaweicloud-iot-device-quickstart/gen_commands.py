@@ -0,0 +1,423 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""根据命令表生成执行器命令的解析代码（C代码）
+
+用法: python3 gen_commands.py actuator_commands.json
+在命令表所在目录生成 <output>.h 和 <output>.c。
+
+命令表格式：
+{
+  "output": "actuator_cmd",                 生成的文件名，也是类型和函数名的前缀
+  "commands": [{
+    "name": "LED_ON",                       命令名（大写），文本中不区分大小写
+    "comment": "...",
+    "params": [                             按顺序给出的参数，文本中省略的取default
+      {"name": "index", "type": "u8", "min": 0, "max": 4, "default": 0, "comment": "..."},
+      {"name": "pattern", "type": "enum", "values": ["flow", "blink"], "default": "flow"}
+    ]
+  }]
+}
+
+参数类型：u8/u16/u32（十进制非负整数，检查min/max），enum（取值列表中的一个单词，存为下标）。
+命令文本形如"LED_ON 2 80"，命令名和参数之间用空白分隔。
+命令名用完美哈希查找：生成时搜索一个种子，使所有命令名的哈希落在不同的槽里，
+运行时算一次哈希、比较一次命令名就能确定命令，不做子串扫描。加新命令只需改命令表后重新生成。
+"""
+
+import json
+import os
+import re
+import sys
+
+# 参数类型：C类型、字节数、取值上限
+PARAM_TYPES = {
+    "u8":   ("uint8_t",  1, 0xff),
+    "u16":  ("uint16_t", 2, 0xffff),
+    "u32":  ("uint32_t", 4, 0xffffffff),
+    "enum": ("uint8_t",  1, 0xff),
+}
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+MAX_SEED = 1 << 20
+
+
+class TableError(Exception):
+    pass
+
+
+def c_ident(text):
+    if not re.match(r"^[A-Za-z_][A-Za-z0-9_]*$", text):
+        raise TableError("不是合法的标识符: %s" % text)
+    return text
+
+
+def cmd_hash(name, seed):
+    h = (FNV_OFFSET ^ seed) & 0xffffffff
+    for c in name.encode("ascii"):
+        h = ((h ^ c) * FNV_PRIME) & 0xffffffff
+    return h ^ (h >> 16)
+
+
+def find_seed(names):
+    """找一个种子和槽数（2的幂，不少于命令数的2倍），使命令名的哈希互不冲突"""
+    size = 1
+    while size < len(names) * 2:
+        size *= 2
+    while True:
+        for seed in range(MAX_SEED):
+            slots = set(cmd_hash(n, seed) & (size - 1) for n in names)
+            if len(slots) == len(names):
+                return seed, size
+        size *= 2
+
+
+class Generator:
+    def __init__(self, table):
+        self.prefix = c_ident(table["output"])
+        self.upper = self.prefix.upper()
+        self.commands = table["commands"]
+        self.enums = {}         # 参数名 -> 取值列表
+        self.check()
+
+    def check(self):
+        names = set()
+        for cmd in self.commands:
+            name = c_ident(cmd["name"])
+            if name != name.upper():
+                raise TableError("命令名应为大写: %s" % name)
+            if name in names:
+                raise TableError("命令重复: %s" % name)
+            names.add(name)
+            pnames = set()
+            for p in cmd.get("params", []):
+                c_ident(p["name"])
+                if p["name"] in pnames:
+                    raise TableError("%s的参数重复: %s" % (name, p["name"]))
+                pnames.add(p["name"])
+                if p["type"] not in PARAM_TYPES:
+                    raise TableError("%s.%s: 未知的参数类型%s" % (name, p["name"], p["type"]))
+                if p["type"] == "enum":
+                    values = p["values"]
+                    if not values or len(values) > 0xff:
+                        raise TableError("%s.%s: 取值列表为空或太长" % (name, p["name"]))
+                    for v in values:
+                        c_ident(v)
+                    if p["name"] in self.enums and self.enums[p["name"]] != values:
+                        raise TableError("同名枚举参数%s的取值不一致" % p["name"])
+                    self.enums[p["name"]] = values
+                    if p["default"] not in values:
+                        raise TableError("%s.%s: 默认值不在取值列表中" % (name, p["name"]))
+                else:
+                    limit = PARAM_TYPES[p["type"]][2]
+                    if not (0 <= p["min"] <= p["default"] <= p["max"] <= limit):
+                        raise TableError("%s.%s: 需要0 <= min <= default <= max <= %d" % (name, p["name"], limit))
+
+    def param_default(self, p):
+        if p["type"] == "enum":
+            return p["values"].index(p["default"])
+        return p["default"]
+
+    def param_range(self, p):
+        if p["type"] == "enum":
+            return 0, len(p["values"]) - 1
+        return p["min"], p["max"]
+
+    def generate(self, table_name):
+        P, U = self.prefix, self.upper
+        names = [c["name"] for c in self.commands]
+        seed, size = find_seed(names)
+        name_max = max(len(n) for n in names)
+        param_max = max([len(c.get("params", [])) for c in self.commands] + [1])
+        guard = "_" + U + "_H"
+        banner = "// 由gen_commands.py根据%s生成，请勿手工修改" % table_name
+
+        h = [banner, "#ifndef " + guard, "#define " + guard, "",
+             "#include <stddef.h>", "#include <stdint.h>", ""]
+        h.append("typedef enum {")
+        for n in names:
+            h.append("    %s_%s," % (U, n))
+        h.append("    %s_NUM" % U)
+        h.append("} %s_id_t;" % P)
+        h.append("")
+        for macro, value, comment in (("UNKNOWN", "(-1)", "不是命令"),
+                                      ("BAD_PARAM", "(-2)", "是命令，但参数不合法"),
+                                      ("NAME_MAX", str(name_max), "最长命令名"),
+                                      ("PARAM_MAX", str(param_max), "一条命令最多的参数数")):
+            h.append("#define %-24s %-6s // %s" % (U + "_" + macro, value, comment))
+        h.append("")
+        for pname, values in self.enums.items():
+            h.append("// 参数%s的取值" % pname)
+            h.append("typedef enum {")
+            for v in values:
+                h.append("    %s_%s_%s," % (U, pname.upper(), v.upper()))
+            h.append("} %s_%s_t;" % (P, pname))
+            h.append("")
+        for cmd in self.commands:
+            params = cmd.get("params", [])
+            if not params:
+                continue
+            h.append("// %s %s" % (cmd["name"], cmd.get("comment", "")))
+            h.append("typedef struct {")
+            for p in params:
+                ctype = PARAM_TYPES[p["type"]][0]
+                comment = p.get("comment", "")
+                if p["type"] == "enum":
+                    comment = ("%s_%s_t，" % (P, p["name"])) + comment
+                else:
+                    comment = ("%d~%d，" % (p["min"], p["max"])) + comment
+                comment += "，默认%s" % p["default"]
+                decl = "    %s %s;" % (ctype, p["name"])
+                h.append("%-32s // %s" % (decl, comment))
+            h.append("} %s_%s_t;" % (P, cmd["name"].lower()))
+            h.append("")
+        h.append("// 一条解析好的命令，参数按id取对应的成员")
+        h.append("typedef struct {")
+        h.append("    %s_id_t id;" % P)
+        h.append("    union {")
+        for cmd in self.commands:
+            if cmd.get("params"):
+                h.append("        %s_%s_t %s;" % (P, cmd["name"].lower(), cmd["name"].lower()))
+        h.append("    };")
+        h.append("} %s_t;" % P)
+        h.append("")
+        h.append("// 解析一条命令文本\"NAME 参数1 参数2...\"：命令名不区分大小写，参数按顺序给出，省略的取默认值。")
+        h.append("// 成功返回0；不是命令返回%s_UNKNOWN；参数不合法或多余返回%s_BAD_PARAM" % (U, U))
+        h.append("int %s_parse(const char *text, size_t len, %s_t *out);" % (P, P))
+        h.append("")
+        h.append("// 命令名，id无效返回NULL")
+        h.append("const char *%s_name(%s_id_t id);" % (P, P))
+        h.append("")
+        h.append("// 把命令写成规范文本（命令名加全部参数），返回值同snprintf")
+        h.append("int %s_format(const %s_t *cmd, char *out, size_t out_len);" % (P, P))
+        h.append("")
+        h.append("#endif")
+
+        c = [banner, '#include "%s.h"' % P, "", "#include <stdio.h>", "#include <string.h>", "#include <strings.h>", ""]
+        c.append("typedef struct {")
+        c.append("    const char *name;")
+        c.append("    uint16_t offset;                // 在%s_t中的偏移" % P)
+        c.append("    uint8_t size;                   // 字节数：1/2/4")
+        c.append("    uint32_t min, max, def;")
+        c.append("    const char *const *values;      // 枚举参数的取值（NULL结尾），数值参数为NULL")
+        c.append("} %s_param_spec_t;" % P)
+        c.append("")
+        c.append("typedef struct {")
+        c.append("    const char *name;")
+        c.append("    uint8_t name_len;")
+        c.append("    uint8_t param_num;")
+        c.append("    const %s_param_spec_t *params;" % P)
+        c.append("} %s_spec_t;" % P)
+        c.append("")
+        for pname, values in self.enums.items():
+            c.append("static const char *const %s_values[] = { %s, NULL };" %
+                     (pname, ", ".join('"%s"' % v for v in values)))
+        if self.enums:
+            c.append("")
+        for cmd in self.commands:
+            params = cmd.get("params", [])
+            if not params:
+                continue
+            member = cmd["name"].lower()
+            c.append("static const %s_param_spec_t %s_params[] = {" % (P, member))
+            for p in params:
+                lo, hi = self.param_range(p)
+                values = "%s_values" % p["name"] if p["type"] == "enum" else "NULL"
+                c.append('    { "%s", offsetof(%s_t, %s.%s), %d, %d, %d, %d, %s },' %
+                         (p["name"], P, member, p["name"], PARAM_TYPES[p["type"]][1], lo, hi,
+                          self.param_default(p), values))
+            c.append("};")
+            c.append("")
+        c.append("static const %s_spec_t %s_specs[%s_NUM] = {" % (P, P, U))
+        for cmd in self.commands:
+            params = cmd.get("params", [])
+            c.append('    [%s_%s] = { "%s", %d, %d, %s },' %
+                     (U, cmd["name"], cmd["name"], len(cmd["name"]), len(params),
+                      "%s_params" % cmd["name"].lower() if params else "NULL"))
+        c.append("};")
+        c.append("")
+        slots = [-1] * size
+        for i, n in enumerate(names):
+            slots[cmd_hash(n, seed) & (size - 1)] = i
+        c.append("// 完美哈希：种子%u下各命令名落在不同的槽，-1为空槽" % seed)
+        c.append("#define %s_HASH_SEED %uu" % (U, seed))
+        c.append("#define %s_HASH_SIZE %d" % (U, size))
+        c.append("static const int8_t %s_slots[%s_HASH_SIZE] = {" % (P, U))
+        for i in range(0, size, 16):
+            c.append("    " + ", ".join("%d" % s for s in slots[i:i + 16]) + ",")
+        c.append("};")
+        c.append("")
+        c.append(RUNTIME.replace("PREFIX", P).replace("UPPER", U))
+        return "\n".join(h) + "\n", "\n".join(c).rstrip("\n") + "\n"
+
+
+# 与命令表无关的解析代码，PREFIX/UPPER替换为前缀
+RUNTIME = r'''static int is_space(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// 取下一个空白分隔的单词，没有了返回0
+static size_t next_token(const char **p, const char *end, const char **tok) {
+    while (*p < end && is_space(**p)) {
+        (*p)++;
+    }
+    *tok = *p;
+    while (*p < end && !is_space(**p)) {
+        (*p)++;
+    }
+    return (size_t)(*p - *tok);
+}
+
+static void store_param(PREFIX_t *cmd, const PREFIX_param_spec_t *ps, uint32_t v) {
+    char *field = (char *)cmd + ps->offset;
+    if (ps->size == 1) {
+        uint8_t x = (uint8_t)v;
+        memcpy(field, &x, 1);
+    } else if (ps->size == 2) {
+        uint16_t x = (uint16_t)v;
+        memcpy(field, &x, 2);
+    } else {
+        memcpy(field, &v, 4);
+    }
+}
+
+static uint32_t load_param(const PREFIX_t *cmd, const PREFIX_param_spec_t *ps) {
+    const char *field = (const char *)cmd + ps->offset;
+    if (ps->size == 1) {
+        uint8_t x;
+        memcpy(&x, field, 1);
+        return x;
+    } else if (ps->size == 2) {
+        uint16_t x;
+        memcpy(&x, field, 2);
+        return x;
+    }
+    uint32_t x;
+    memcpy(&x, field, 4);
+    return x;
+}
+
+// 解析一个参数，成功返回0
+static int parse_param(const PREFIX_param_spec_t *ps, const char *tok, size_t len, uint32_t *out) {
+    if (ps->values != NULL) {
+        for (uint32_t i = 0; ps->values[i] != NULL; i++) {
+            if (strlen(ps->values[i]) == len && strncasecmp(ps->values[i], tok, len) == 0) {
+                *out = i;
+                return 0;
+            }
+        }
+        return -1;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (tok[i] < '0' || tok[i] > '9') {
+            return -1;
+        }
+        uint32_t d = (uint32_t)(tok[i] - '0');
+        if (d > ps->max || v > (ps->max - d) / 10) {
+            return -1;      // 超过上限
+        }
+        v = v * 10 + d;
+    }
+    if (v < ps->min) {
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+int PREFIX_parse(const char *text, size_t len, PREFIX_t *out) {
+    const char *p = text;
+    const char *end = text + len;
+    const char *tok;
+    size_t tok_len = next_token(&p, end, &tok);
+    if (tok_len == 0 || tok_len > UPPER_NAME_MAX) {
+        return UPPER_UNKNOWN;
+    }
+
+    // 转大写的同时算哈希
+    char name[UPPER_NAME_MAX];
+    uint32_t h = 2166136261u ^ UPPER_HASH_SEED;
+    for (size_t i = 0; i < tok_len; i++) {
+        char ch = tok[i];
+        name[i] = (ch >= 'a' && ch <= 'z') ? (char)(ch - 'a' + 'A') : ch;
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+    h ^= h >> 16;
+    int idx = PREFIX_slots[h & (UPPER_HASH_SIZE - 1)];
+    if (idx < 0 || PREFIX_specs[idx].name_len != tok_len || memcmp(PREFIX_specs[idx].name, name, tok_len) != 0) {
+        return UPPER_UNKNOWN;
+    }
+
+    const PREFIX_spec_t *spec = &PREFIX_specs[idx];
+    memset(out, 0, sizeof(*out));
+    out->id = (PREFIX_id_t)idx;
+    for (int i = 0; i < spec->param_num; i++) {
+        const PREFIX_param_spec_t *ps = &spec->params[i];
+        uint32_t v = ps->def;
+        tok_len = next_token(&p, end, &tok);
+        if (tok_len > 0 && parse_param(ps, tok, tok_len, &v) != 0) {
+            return UPPER_BAD_PARAM;
+        }
+        store_param(out, ps, v);
+    }
+    if (next_token(&p, end, &tok) > 0) {
+        return UPPER_BAD_PARAM;     // 多余的参数
+    }
+    return 0;
+}
+
+const char *PREFIX_name(PREFIX_id_t id) {
+    if ((int)id < 0 || id >= UPPER_NUM) {
+        return NULL;
+    }
+    return PREFIX_specs[id].name;
+}
+
+int PREFIX_format(const PREFIX_t *cmd, char *out, size_t out_len) {
+    const char *name = PREFIX_name(cmd->id);
+    if (name == NULL) {
+        return -1;
+    }
+    const PREFIX_spec_t *spec = &PREFIX_specs[cmd->id];
+    size_t n = (size_t)snprintf(out, out_len, "%s", name);
+    for (int i = 0; i < spec->param_num; i++) {
+        const PREFIX_param_spec_t *ps = &spec->params[i];
+        uint32_t v = load_param(cmd, ps);
+        char *dst = n < out_len ? out + n : NULL;
+        size_t room = n < out_len ? out_len - n : 0;
+        if (ps->values != NULL) {
+            n += (size_t)snprintf(dst, room, " %s", v <= ps->max ? ps->values[v] : "?");
+        } else {
+            n += (size_t)snprintf(dst, room, " %u", (unsigned int)v);
+        }
+    }
+    return (int)n;
+}
+'''
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("用法: %s <commands.json>" % sys.argv[0], file=sys.stderr)
+        return 1
+    table_path = sys.argv[1]
+    with open(table_path, encoding="utf-8") as fp:
+        table = json.load(fp)
+    try:
+        header, source = Generator(table).generate(os.path.basename(table_path))
+    except (TableError, KeyError) as e:
+        print("命令表错误: %s" % e, file=sys.stderr)
+        return 1
+
+    out_dir = os.path.dirname(os.path.abspath(table_path))
+    base = os.path.join(out_dir, table["output"])
+    for path, text in ((base + ".h", header), (base + ".c", source)):
+        with open(path, "w", encoding="utf-8") as fp:
+            fp.write(text)
+        print("已生成 " + path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
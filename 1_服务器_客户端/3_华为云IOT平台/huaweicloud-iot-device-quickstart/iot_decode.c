@@ -0,0 +1,178 @@
+// 由gen_decoder.py根据iot_schema.json生成，请勿手工修改
+#include <string.h>
+
+#include "iot_decode.h"
+
+// ---------------- iot_command ----------------
+
+static void iot_command_init(iot_command_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->action = JSON_NONE_INT;
+}
+
+static void iot_command_paras(json_scan_t *js, iot_command_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 6:
+                if (memcmp(key, "action", 6) == 0) {
+                    out->action = json_read_int(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void iot_command_root(json_scan_t *js, iot_command_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 5:
+                if (memcmp(key, "paras", 5) == 0) {
+                    iot_command_paras(js, out);
+                    continue;
+                }
+                break;
+            case 10:
+                if (memcmp(key, "service_id", 10) == 0) {
+                    json_read_text(js, out->service_id, sizeof(out->service_id));
+                    continue;
+                }
+                break;
+            case 12:
+                if (memcmp(key, "command_name", 12) == 0) {
+                    json_read_text(js, out->command_name, sizeof(out->command_name));
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int iot_command_decode(const char *json, size_t len, iot_command_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    iot_command_init(out);
+    iot_command_root(&js, out);
+    return js.error ? -1 : 0;
+}
+
+// ---------------- iot_properties_set ----------------
+
+static void iot_properties_set_service_init(iot_properties_set_service_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->alarm = JSON_NONE_INT;
+    out->led_status = JSON_NONE_INT;
+    out->buzzer_status = JSON_NONE_INT;
+}
+
+static void iot_properties_set_init(iot_properties_set_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+static void iot_properties_set_service_properties(json_scan_t *js, iot_properties_set_service_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 5:
+                if (memcmp(key, "alarm", 5) == 0) {
+                    out->alarm = json_read_int(js);
+                    continue;
+                }
+                break;
+            case 10:
+                if (memcmp(key, "led_status", 10) == 0) {
+                    out->led_status = json_read_int(js);
+                    continue;
+                }
+                break;
+            case 13:
+                if (memcmp(key, "buzzer_status", 13) == 0) {
+                    out->buzzer_status = json_read_int(js);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void iot_properties_set_service_root(json_scan_t *js, iot_properties_set_service_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 10:
+                if (memcmp(key, "service_id", 10) == 0) {
+                    json_read_text(js, out->service_id, sizeof(out->service_id));
+                    continue;
+                }
+                if (memcmp(key, "properties", 10) == 0) {
+                    iot_properties_set_service_properties(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+static void iot_properties_set_services(json_scan_t *js, iot_properties_set_t *out) {
+    if (!json_array_begin(js)) {
+        return;
+    }
+    for (bool first = true; json_array_next(js, &first); ) {
+        if (out->service_num >= 8) {
+            json_skip(js);
+            continue;
+        }
+        iot_properties_set_service_t *elem = &out->service[out->service_num++];
+        iot_properties_set_service_init(elem);
+        iot_properties_set_service_root(js, elem);
+    }
+}
+
+static void iot_properties_set_root(json_scan_t *js, iot_properties_set_t *out) {
+    if (!json_object_begin(js)) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    for (bool first = true; json_object_next(js, &first, &key, &key_len); ) {
+        switch (key_len) {
+            case 8:
+                if (memcmp(key, "services", 8) == 0) {
+                    iot_properties_set_services(js, out);
+                    continue;
+                }
+                break;
+        }
+        json_skip(js);
+    }
+}
+
+int iot_properties_set_decode(const char *json, size_t len, iot_properties_set_t *out) {
+    json_scan_t js;
+    json_scan_init(&js, json, len);
+    iot_properties_set_init(out);
+    iot_properties_set_root(&js, out);
+    return js.error ? -1 : 0;
+}
@@ -0,0 +1,37 @@
+// 由gen_decoder.py根据iot_schema.json生成，请勿手工修改
+#ifndef _IOT_DECODE_H
+#define _IOT_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_scan.h"
+
+// 平台下发的命令
+typedef struct {
+    char service_id[32];         // service_id，缺失为空串
+    char command_name[32];       // command_name，缺失为空串
+    int32_t action;              // paras.action，缺失为JSON_NONE_INT
+} iot_command_t;
+
+// 解码iot_command，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int iot_command_decode(const char *json, size_t len, iot_command_t *out);
+
+// 一个服务的属性
+typedef struct {
+    char service_id[32];         // service_id，缺失为空串
+    int32_t alarm;               // properties.alarm，缺失为JSON_NONE_INT
+    int32_t led_status;          // properties.led_status，缺失为JSON_NONE_INT
+    int32_t buzzer_status;       // properties.buzzer_status，缺失为JSON_NONE_INT
+} iot_properties_set_service_t;
+
+// 平台下发的属性设置
+typedef struct {
+    uint8_t service_num;
+    iot_properties_set_service_t service[8]; // services[]
+} iot_properties_set_t;
+
+// 解码iot_properties_set，缺失的字段取缺失值，返回0；JSON格式错误返回-1
+int iot_properties_set_decode(const char *json, size_t len, iot_properties_set_t *out);
+
+#endif
@@ -0,0 +1,156 @@
+#include "property_report.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+void property_set_int(property_field_t* field, long value)
+{
+    field->value.i = value;
+    field->has_value = true;
+}
+
+void property_set_number(property_field_t* field, double value)
+{
+    field->value.d = value;
+    field->has_value = true;
+}
+
+void property_set_string(property_field_t* field, const char* value)
+{
+    snprintf(field->value.s, sizeof(field->value.s), "%s", value != NULL ? value : "");
+    field->has_value = true;
+}
+
+// 字段相对上次上报是否有需要上报的变化
+static bool field_changed(const property_field_t* field)
+{
+    if (!field->has_value) {
+        return false;
+    }
+    if (!field->has_reported) {
+        return true;
+    }
+    switch (field->type) {
+    case PROPERTY_INT:
+        return labs(field->value.i - field->reported.i) >= (field->deadband > 0 ? (long)field->deadband : 1);
+    case PROPERTY_NUMBER:
+        if (field->deadband > 0) {
+            double diff = field->value.d - field->reported.d;
+            return (diff < 0 ? -diff : diff) >= field->deadband;
+        }
+        return memcmp(&field->value.d, &field->reported.d, sizeof(double)) != 0;
+    case PROPERTY_STRING:
+        return strcmp(field->value.s, field->reported.s) != 0;
+    default:
+        return false;
+    }
+}
+
+// 按格式追加到out[*pos]，空间不够时返回false
+static bool append_format(char* out, size_t out_len, size_t* pos, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(out + *pos, out_len - *pos, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= out_len - *pos) {
+        return false;
+    }
+    *pos += (size_t)n;
+    return true;
+}
+
+// 把字符串作为JSON字符串值追加到out[*pos]，转义引号、反斜杠和控制字符；空间不够时返回false
+static bool append_json_string(char* out, size_t out_len, size_t* pos, const char* str)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t n = *pos;
+
+    if (n + 1 >= out_len) {
+        return false;
+    }
+    out[n++] = '"';
+    for (const unsigned char* p = (const unsigned char*)str; *p != '\0'; p++) {
+        size_t need = (*p == '"' || *p == '\\') ? 2 : (*p < 0x20 ? 6 : 1);
+        if (n + need + 1 >= out_len) {
+            return false;
+        }
+        if (need == 2) {
+            out[n++] = '\\';
+            out[n++] = (char)*p;
+        } else if (need == 6) {
+            memcpy(out + n, "\\u00", 4);
+            out[n + 4] = hex[*p >> 4];
+            out[n + 5] = hex[*p & 0xf];
+            n += 6;
+        } else {
+            out[n++] = (char)*p;
+        }
+    }
+    if (n + 1 >= out_len) {
+        return false;
+    }
+    out[n++] = '"';
+    out[n] = '\0';
+    *pos = n;
+    return true;
+}
+
+int property_service_format(const property_service_t* svc, bool full, char* out, size_t out_len)
+{
+    size_t pos = 0;
+    int count = 0;
+
+    if (out_len == 0) {
+        return -1;
+    }
+    out[0] = '\0';
+    for (int i = 0; i < svc->field_num; i++) {
+        const property_field_t* field = &svc->fields[i];
+        if (!(full ? field->has_value : field_changed(field))) {
+            continue;
+        }
+        if (!append_format(out, out_len, &pos, "%c\"%s\":", count == 0 ? '{' : ',', field->name)) {
+            return -1;
+        }
+        bool ok;
+        switch (field->type) {
+        case PROPERTY_INT:
+            ok = append_format(out, out_len, &pos, "%ld", field->value.i);
+            break;
+        case PROPERTY_NUMBER:
+            // JSON没有NaN/Inf
+            ok = isfinite(field->value.d) ? append_format(out, out_len, &pos, "%.15g", field->value.d)
+                                          : append_format(out, out_len, &pos, "null");
+            break;
+        default:
+            ok = append_json_string(out, out_len, &pos, field->value.s);
+            break;
+        }
+        if (!ok) {
+            return -1;
+        }
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (!append_format(out, out_len, &pos, "}")) {
+        return -1;
+    }
+    return (int)pos;
+}
+
+void property_service_commit(property_service_t* svc, bool full)
+{
+    for (int i = 0; i < svc->field_num; i++) {
+        property_field_t* field = &svc->fields[i];
+        if (full ? field->has_value : field_changed(field)) {
+            field->reported = field->value;
+            field->has_reported = true;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef PROPERTY_REPORT_H
+#define PROPERTY_REPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// 变化驱动的属性上报
+// 每个服务一张字段表，字段带类型，记着当前值和上次成功上报的值。每次上报只把有变化的字段拼成属性JSON，
+// 没有变化的服务不上报；数值字段可以设死区，抖动小于死区不算变化。上报成功后再把这些字段记为已上报，
+// 上报失败下次会重发。定期做一次全量上报，平台侧即使丢过消息也能对齐。
+// 属性JSON直接由字段值生成（不建cJSON树），这是属性在网关里唯一的一次序列化。
+
+#define PROPERTY_STRING_LEN     64      // 字符串字段的最大长度（含结束符）
+#define PROPERTY_PAYLOAD_LEN    2048    // 一个服务属性JSON的缓冲大小，字段不超过4个字符串时一定够用
+
+typedef enum {
+    PROPERTY_INT,
+    PROPERTY_NUMBER,
+    PROPERTY_STRING
+} property_type_t;
+
+typedef union {
+    long i;
+    double d;
+    char s[PROPERTY_STRING_LEN];
+} property_value_t;
+
+typedef struct {
+    const char* name;               // 物模型中的属性名
+    property_type_t type;
+    double deadband;                // 数值字段与上次上报相差小于这个值不算变化，0表示有变化就上报
+    property_value_t value;         // 当前值
+    property_value_t reported;      // 上次成功上报的值
+    bool has_value;
+    bool has_reported;
+} property_field_t;
+
+typedef struct {
+    const char* service_id;
+    property_field_t* fields;
+    int field_num;
+} property_service_t;
+
+// 设置字段的当前值
+void property_set_int(property_field_t* field, long value);
+void property_set_number(property_field_t* field, double value);
+void property_set_string(property_field_t* field, const char* value);
+
+// 生成服务的属性JSON：full为true时包含全部有值的字段，否则只包含相对上次上报有变化的字段。
+// 没有要上报的字段返回0，缓冲不够返回-1，否则返回写入长度
+int property_service_format(const property_service_t* svc, bool full, char* out, size_t out_len);
+
+// 上报成功后调用（full与format时相同）：把这次上报的字段记为已上报
+void property_service_commit(property_service_t* svc, bool full);
+
+#endif // PROPERTY_REPORT_H
@@ -0,0 +1,183 @@
+// 属性上报量对比
+// 模拟网关一天的运行（每5秒一个上报周期，与AgentLiteDemo的sleepTime相同），分别统计：
+//   全量：每个周期上报全部3个服务（原先的做法）
+//   变化：只上报有变化的服务和字段，每300秒全量一次（AgentLiteDemo现在的做法）
+// 的发布次数、服务数和字节数。属性字节是properties JSON的长度，消息字节再加上
+// {"services":[{"service_id":..,"properties":..,"event_time":..}]}外壳的估算。
+//   make property_report_bench && ./property_report_bench
+// 模拟的一天：上午10点做一次1分钟的报警测试；天气每20分钟更新一次，温湿度随昼夜变化，
+// 天气现象一天变4次，风向每4小时变一次；LED开关8次，蜂鸣器开关4次。烟感读数分两种情形各跑一天：
+//   漂移：读数在上次附近小幅波动，接近真实传感器
+//   均匀随机：每个周期重新取均匀随机数（AgentLiteDemo原先的冒烟模拟，浓度10.0~99.9，湿度0~99），
+//             几乎每个周期都越过死区，是变化上报的最坏情形
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "property_report.h"
+
+#define TICK_S              5
+#define DAY_TICKS           (24 * 3600 / TICK_S)
+#define FULL_INTERVAL_S     300
+#define EVENT_TIME_LEN      16      // "20261018T000000Z"
+
+enum { SMOKE_ALARM, SMOKE_CONCENTRATION, SMOKE_TEMPERATURE, SMOKE_HUMIDITY, SMOKE_FIELD_NUM };
+enum { WEATHER_CITY, WEATHER_TEXT, WEATHER_TEMPERATURE, WEATHER_HUMIDITY, WEATHER_WIND_DIRECTION, WEATHER_FIELD_NUM };
+enum { CONTROL_LED, CONTROL_BUZZER, CONTROL_FIELD_NUM };
+
+// 与AgentLiteDemo.c中的字段表相同
+static property_field_t smoke_fields[SMOKE_FIELD_NUM] = {
+    [SMOKE_ALARM]         = { .name = "alarm", .type = PROPERTY_INT },
+    [SMOKE_CONCENTRATION] = { .name = "smokeConcentration", .type = PROPERTY_NUMBER, .deadband = 2.0 },
+    [SMOKE_TEMPERATURE]   = { .name = "temperature", .type = PROPERTY_STRING },
+    [SMOKE_HUMIDITY]      = { .name = "humidity", .type = PROPERTY_INT, .deadband = 3 },
+};
+static property_field_t weather_fields[WEATHER_FIELD_NUM] = {
+    [WEATHER_CITY]           = { .name = "city", .type = PROPERTY_STRING },
+    [WEATHER_TEXT]           = { .name = "weather", .type = PROPERTY_STRING },
+    [WEATHER_TEMPERATURE]    = { .name = "temperature", .type = PROPERTY_STRING },
+    [WEATHER_HUMIDITY]       = { .name = "humidity", .type = PROPERTY_STRING },
+    [WEATHER_WIND_DIRECTION] = { .name = "wind_direction", .type = PROPERTY_STRING },
+};
+static property_field_t control_fields[CONTROL_FIELD_NUM] = {
+    [CONTROL_LED]    = { .name = "led_status", .type = PROPERTY_INT },
+    [CONTROL_BUZZER] = { .name = "buzzer_status", .type = PROPERTY_INT },
+};
+
+#define SERVICE_NUM 3
+static property_service_t report_services[SERVICE_NUM] = {
+    { "smokeDetector", smoke_fields, SMOKE_FIELD_NUM },
+    { "Weather", weather_fields, WEATHER_FIELD_NUM },
+    { "Control", control_fields, CONTROL_FIELD_NUM },
+};
+
+typedef enum {
+    SMOKE_DRIFT,
+    SMOKE_UNIFORM
+} smoke_model_t;
+
+typedef struct {
+    unsigned long publishes;
+    unsigned long services;
+    unsigned long property_bytes;
+    unsigned long message_bytes;
+} report_count_t;
+
+// 设置第tick个周期的模拟数据（两种模式用同一个种子，数据完全相同）
+static void simulate(smoke_model_t model, int tick, unsigned int* seed, double* concentration, long* humidity)
+{
+    static const char* const texts[] = { "晴", "多云", "阴", "小雨", "多云" };
+    static const char* const winds[] = { "东北", "东", "东南", "南", "西南", "西" };
+    int sec = tick * TICK_S;
+
+    if (model == SMOKE_UNIFORM) {
+        *concentration = (rand_r(seed) % 900 + 100) / 10.0;
+        *humidity = rand_r(seed) % 100;
+    } else {
+        *concentration += (rand_r(seed) % 11 - 5) / 10.0;
+        *concentration = *concentration < 10.0 ? 10.0 : (*concentration > 100.0 ? 100.0 : *concentration);
+        *humidity += rand_r(seed) % 3 - 1;
+        *humidity = *humidity < 0 ? 0 : (*humidity > 100 ? 100 : *humidity);
+    }
+    property_set_int(&smoke_fields[SMOKE_ALARM], sec >= 10 * 3600 && sec < 10 * 3600 + 60);
+    property_set_number(&smoke_fields[SMOKE_CONCENTRATION], *concentration);
+    property_set_string(&smoke_fields[SMOKE_TEMPERATURE], "25.5");
+    property_set_int(&smoke_fields[SMOKE_HUMIDITY], *humidity);
+
+    // 天气每20分钟更新一次
+    int refresh = sec / 1200 * 1200;
+    double phase = (refresh / 3600.0 - 9) / 24 * 2 * M_PI;
+    char temperature[16], weather_humidity[8];
+    snprintf(temperature, sizeof(temperature), "%.1f", 15 + 8 * sin(phase));
+    snprintf(weather_humidity, sizeof(weather_humidity), "%d%%", (int)(60 - 20 * sin(phase)));
+    property_set_string(&weather_fields[WEATHER_CITY], "北京");
+    property_set_string(&weather_fields[WEATHER_TEXT], texts[refresh * 5 / (24 * 3600)]);
+    property_set_string(&weather_fields[WEATHER_TEMPERATURE], temperature);
+    property_set_string(&weather_fields[WEATHER_HUMIDITY], weather_humidity);
+    property_set_string(&weather_fields[WEATHER_WIND_DIRECTION], winds[refresh / (4 * 3600)]);
+
+    // LED在8个整点切换，蜂鸣器在4个半点响一分钟
+    int hour = sec / 3600;
+    property_set_int(&control_fields[CONTROL_LED], (hour >= 7 && hour < 9) || (hour >= 12 && hour < 13) ||
+                                                   (hour >= 18 && hour < 20) || (hour >= 21 && hour < 23));
+    property_set_int(&control_fields[CONTROL_BUZZER], (hour == 6 || hour == 15) && sec % 3600 >= 1800 &&
+                                                      sec % 3600 < 1860);
+}
+
+static void run_day(smoke_model_t model, bool delta, report_count_t* count)
+{
+    unsigned int seed = 12345;
+    double concentration = 20.0;
+    long humidity = 50;
+    int next_full = 0;
+    char payload[PROPERTY_PAYLOAD_LEN];
+
+    for (int s = 0; s < SERVICE_NUM; s++) {
+        for (int f = 0; f < report_services[s].field_num; f++) {
+            report_services[s].fields[f].has_value = false;
+            report_services[s].fields[f].has_reported = false;
+        }
+    }
+    memset(count, 0, sizeof(*count));
+
+    for (int tick = 0; tick < DAY_TICKS; tick++) {
+        simulate(model, tick, &seed, &concentration, &humidity);
+        bool full = !delta || tick * TICK_S >= next_full;
+        int services = 0;
+        unsigned long bytes = 0, message = 0;
+        for (int s = 0; s < SERVICE_NUM; s++) {
+            int len = property_service_format(&report_services[s], full, payload, sizeof(payload));
+            if (len <= 0) {
+                continue;
+            }
+            property_service_commit(&report_services[s], full);
+            services++;
+            bytes += (unsigned long)len;
+            message += (unsigned long)len + strlen(report_services[s].service_id) + EVENT_TIME_LEN +
+                       strlen("{\"service_id\":\"\",\"properties\":,\"event_time\":\"\"},");
+        }
+        if (services == 0) {
+            continue;
+        }
+        if (full) {
+            next_full = tick * TICK_S + FULL_INTERVAL_S;
+        }
+        count->publishes++;
+        count->services += services;
+        count->property_bytes += bytes;
+        count->message_bytes += message + strlen("{\"services\":[]}") - 1;
+    }
+}
+
+static double reduction(unsigned long before, unsigned long after)
+{
+    return before > 0 ? 100.0 * (1.0 - (double)after / before) : 0;
+}
+
+// 跑两遍同一天（全量、变化），打印对比表
+static void compare_day(smoke_model_t model, const char* title)
+{
+    report_count_t full, delta;
+    run_day(model, false, &full);
+    run_day(model, true, &delta);
+
+    printf("\n%s\n", title);
+    printf("%-10s %10s %10s %12s %12s\n", "", "发布次数", "服务数", "属性字节", "消息字节");
+    printf("%-10s %10lu %10lu %12lu %12lu\n", "全量", full.publishes, full.services,
+           full.property_bytes, full.message_bytes);
+    printf("%-10s %10lu %10lu %12lu %12lu\n", "变化", delta.publishes, delta.services,
+           delta.property_bytes, delta.message_bytes);
+    printf("%-10s %9.1f%% %9.1f%% %11.1f%% %11.1f%%\n", "减少",
+           reduction(full.publishes, delta.publishes), reduction(full.services, delta.services),
+           reduction(full.property_bytes, delta.property_bytes), reduction(full.message_bytes, delta.message_bytes));
+}
+
+int main(void)
+{
+    printf("一天%d个上报周期（每%d秒）\n", DAY_TICKS, TICK_S);
+    compare_day(SMOKE_DRIFT, "烟感读数漂移：");
+    compare_day(SMOKE_UNIFORM, "烟感读数均匀随机（原先的冒烟模拟）：");
+    return 0;
+}
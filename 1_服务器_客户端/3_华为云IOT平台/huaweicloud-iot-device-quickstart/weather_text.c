@@ -0,0 +1,163 @@
+#include "weather_text.h"
+
+#include <string.h>
+
+// 可识别的键：UTF-8下都是两个汉字6字节，按键的最后6字节比较
+typedef enum {
+    KEY_CITY,
+    KEY_TEXT,
+    KEY_TEMP,
+    KEY_HUMIDITY,
+    KEY_WIND_DIRECTION,
+    KEY_WIND_SPEED,
+    KEY_WIND_SCALE,
+    KEY_NUM
+} text_key_t;
+
+#define KEY_LEN 6
+
+static const char keys[KEY_NUM][KEY_LEN + 1] = {
+    [KEY_CITY]           = "城市",
+    [KEY_TEXT]           = "天气",
+    [KEY_TEMP]           = "温度",
+    [KEY_HUMIDITY]       = "湿度",
+    [KEY_WIND_DIRECTION] = "风向",
+    [KEY_WIND_SPEED]     = "风速",
+    [KEY_WIND_SCALE]     = "风力",
+};
+
+static int is_blank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+// 复制文本值，超长时在UTF-8字符边界截断
+static void copy_text(char* dst, size_t dst_len, const char* src, size_t len) {
+    if (len >= dst_len) {
+        len = dst_len - 1;
+        while (len > 0 && ((unsigned char)src[len] & 0xc0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+// 解析带一位小数的数值（x10，四舍五入），后面的单位忽略；没有数字返回-1
+static int parse_x10(const char* p, const char* end, long* out) {
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = *p == '-';
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return -1;
+    }
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9' && v < 100000) {
+        v = v * 10 + (*p++ - '0');
+    }
+    v *= 10;
+    if (p + 1 < end && *p == '.' && p[1] >= '0' && p[1] <= '9') {
+        v += p[1] - '0';
+        if (p + 2 < end && p[2] >= '5' && p[2] <= '9') {
+            v++;
+        }
+    }
+    *out = neg ? -v : v;
+    return 0;
+}
+
+// 解析非负整数，后面的单位忽略；没有数字返回-1
+static int parse_uint(const char* p, const char* end, long* out) {
+    if (p >= end || *p < '0' || *p > '9') {
+        return -1;
+    }
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9' && v < 100000) {
+        v = v * 10 + (*p++ - '0');
+    }
+    *out = v;
+    return 0;
+}
+
+// 按键写入一个字段，值不可用时不改rec
+static void store_field(text_key_t key, const char* value, const char* end, weather_record_t* rec) {
+    size_t len = (size_t)(end - value);
+    long v;
+    switch (key) {
+    case KEY_CITY:
+        copy_text(rec->city_name, sizeof(rec->city_name), value, len);
+        break;
+    case KEY_TEXT:
+        copy_text(rec->text, sizeof(rec->text), value, len);
+        break;
+    case KEY_TEMP:
+        if (parse_x10(value, end, &v) == 0 && v >= INT16_MIN + 1 && v <= INT16_MAX) {
+            rec->temp_x10 = (int16_t)v;
+        }
+        break;
+    case KEY_HUMIDITY:
+        if (parse_uint(value, end, &v) == 0 && v <= 100) {
+            rec->humidity = (uint8_t)v;
+        }
+        break;
+    case KEY_WIND_DIRECTION:
+        if (!(len == 3 && memcmp(value, "N/A", 3) == 0)) {
+            copy_text(rec->wind_direction, sizeof(rec->wind_direction), value, len);
+        }
+        break;
+    case KEY_WIND_SPEED:
+        if (parse_x10(value, end, &v) == 0 && v >= 0 && v < WEATHER_RECORD_NONE_U16) {
+            rec->wind_speed_x10 = (uint16_t)v;
+        }
+        break;
+    case KEY_WIND_SCALE:
+        if (parse_uint(value, end, &v) == 0 && v < WEATHER_RECORD_NONE_U8) {
+            rec->wind_scale = (uint8_t)v;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int weather_text_parse(const char* text, size_t len, weather_record_t* rec) {
+    const char* p = text;
+    const char* end = text + len;
+    int found = 0;
+
+    // 换行和冒号都用memchr找（glibc按字长/向量一次比较多个字节）
+    while (p < end) {
+        const char* eol = memchr(p, '\n', (size_t)(end - p));
+        if (eol == NULL) {
+            eol = end;
+        }
+        const char* colon = memchr(p, ':', (size_t)(eol - p));
+        if (colon != NULL) {
+            const char* key_end = colon;
+            while (key_end > p && is_blank(key_end[-1])) {
+                key_end--;
+            }
+            const char* value = colon + 1;
+            const char* value_end = eol;
+            while (value < value_end && is_blank(*value)) {
+                value++;
+            }
+            while (value_end > value && is_blank(value_end[-1])) {
+                value_end--;
+            }
+
+            if (key_end - p >= KEY_LEN) {
+                for (int k = 0; k < KEY_NUM; k++) {
+                    if (memcmp(key_end - KEY_LEN, keys[k], KEY_LEN) == 0) {
+                        store_field((text_key_t)k, value, value_end, rec);
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        p = eol + 1;
+    }
+    return found;
+}
@@ -0,0 +1,21 @@
+#ifndef WEATHER_TEXT_H
+#define WEATHER_TEXT_H
+
+#include <stddef.h>
+
+#include "weather_record.h"
+
+// 旧版客户端A发来的文本天气块，每行"键: 值"，如：
+//  城市: 北京
+//  天气: 晴
+//  温度: 25.5°C
+//  湿度: 60%
+//  风向: 东北
+//  风速: 12.6
+//  风力: 3
+// 一遍扫描直接把字段写进rec（调用前rec应已weather_record_init），不复制、不分配内存。
+// 键按结尾匹配（"当前温度"也算温度），数值忽略单位，"N/A"等非数字保持无数据。
+// 返回识别出的字段数，0表示不是天气块
+int weather_text_parse(const char* text, size_t len, weather_record_t* rec);
+
+#endif // WEATHER_TEXT_H
@@ -0,0 +1,161 @@
+// 文本天气块解析基准
+// 对旧版客户端A发出的文本天气块（下面录制的几条），分别用weather_text_parse()和原先client_c.c里
+// strdup/strtok/strstr/strtod的解析方式解析，先比较两者得到的字段是否一致，再各循环若干次
+// 统计每块的耗时和堆分配次数：
+//   make weather_text_bench && ./weather_text_bench -n 200000
+// 结果不一致时返回1。
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "weather_text.h"
+
+// 录制的文本天气块（旧版forecast.c的输出格式，含缺失值、负温度和非ASCII风向）
+static const char* const blocks[] = {
+    " 城市: 北京\n 天气: 晴\n 温度: 25.5°C\n 湿度: 60%\n 风向: 东北\n 风速: 12.6\n 风力: 3\n",
+    " 城市: 哈尔滨\n 天气: 小雪\n 温度: -12.3°C\n 湿度: 85%\n 风向: 西北\n 风速: 20.0\n 风力: 4\n",
+    " 城市: 广州\n 天气: 雷阵雨\n 温度: 31°C\n 湿度: 92%\n 风向: N/A\n 风速: N/A\n 风力: N/A\n",
+    " 城市: 上海\n 天气: 多云\n 温度: N/A°C\n 湿度: N/A%\n 风向: 东\n 风速: 8.4\n 风力: 2\n",
+    " 城市: 乌鲁木齐\n 天气: 扬沙\n 温度: 7.25°C\n 湿度: 18%\n 风向: 西\n 风速: 35.8\n 风力: 6\n",
+};
+
+#define BLOCK_NUM (int)(sizeof(blocks) / sizeof(blocks[0]))
+
+// 堆分配计数：覆盖malloc（转给glibc的__libc_malloc），strdup等内部分配也会经过这里
+extern void* __libc_malloc(size_t size);
+static unsigned long heap_allocs = 0;
+
+void* malloc(size_t size) {
+    heap_allocs++;
+    return __libc_malloc(size);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 原先client_c.c的解析方式（基准），只处理它原来认识的5个字段
+static int parse_reference(const char* message, weather_record_t* rec) {
+    if (!(strstr(message, "城市") || strstr(message, "天气") ||
+          strstr(message, "温度") || strstr(message, "湿度"))) {
+        return 0;
+    }
+    char* message_copy = strdup(message);
+    char* line = strtok(message_copy, "\n");
+    while (line != NULL) {
+        char* trimmed = line;
+        while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
+        char* colon = strstr(trimmed, ":");
+        if (colon) {
+            *colon = '\0';
+            char* key = trimmed;
+            char* value = colon + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            char* end = value + strlen(value) - 1;
+            while (end > value && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
+                *end = '\0';
+                end--;
+            }
+            char* num_end;
+            if (strstr(key, "城市")) {
+                snprintf(rec->city_name, sizeof(rec->city_name), "%s", value);
+            } else if (strstr(key, "天气")) {
+                snprintf(rec->text, sizeof(rec->text), "%s", value);
+            } else if (strstr(key, "温度")) {
+                double temp = strtod(value, &num_end);
+                if (num_end != value) {
+                    rec->temp_x10 = (int16_t)(temp < 0 ? temp * 10 - 0.5 : temp * 10 + 0.5);
+                }
+            } else if (strstr(key, "湿度")) {
+                long hum = strtol(value, &num_end, 10);
+                if (num_end != value && hum >= 0 && hum <= 100) {
+                    rec->humidity = (uint8_t)hum;
+                }
+            } else if (strstr(key, "风向")) {
+                if (strcmp(value, "N/A") != 0) {
+                    snprintf(rec->wind_direction, sizeof(rec->wind_direction), "%s", value);
+                }
+            }
+        }
+        line = strtok(NULL, "\n");
+    }
+    free(message_copy);
+    return 1;
+}
+
+// 两种解析方式共有的字段是否一致
+static int same_fields(const weather_record_t* a, const weather_record_t* b) {
+    return strcmp(a->city_name, b->city_name) == 0 && strcmp(a->text, b->text) == 0 &&
+           a->temp_x10 == b->temp_x10 && a->humidity == b->humidity &&
+           strcmp(a->wind_direction, b->wind_direction) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 200000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            iterations = atoi(argv[optind - 1]);
+        } else {
+            fprintf(stderr, "用法: %s [-n 每块循环次数]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t lens[BLOCK_NUM];
+    int failed = 0;
+    for (int i = 0; i < BLOCK_NUM; i++) {
+        lens[i] = strlen(blocks[i]);
+        weather_record_t fast, ref;
+        weather_record_init(&fast);
+        weather_record_init(&ref);
+        int found = weather_text_parse(blocks[i], lens[i], &fast);
+        parse_reference(blocks[i], &ref);
+        char text[WEATHER_RECORD_FORMAT_LEN];
+        weather_record_format(&fast, text, sizeof(text));
+        printf("[%d] %d个字段 %s  %s\n", i, found, same_fields(&fast, &ref) ? "一致" : "不一致!", text);
+        if (!same_fields(&fast, &ref)) {
+            failed = 1;
+        }
+    }
+
+    weather_record_t rec;
+    volatile int sink = 0;
+    double total_bytes = 0;
+    for (int i = 0; i < BLOCK_NUM; i++) {
+        total_bytes += lens[i];
+    }
+    total_bytes *= iterations;
+
+    heap_allocs = 0;
+    double start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < BLOCK_NUM; i++) {
+            weather_record_init(&rec);
+            sink += parse_reference(blocks[i], &rec);
+        }
+    }
+    double ref_ns = (now_ns() - start) / ((double)iterations * BLOCK_NUM);
+    unsigned long ref_allocs = heap_allocs;
+
+    heap_allocs = 0;
+    start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < BLOCK_NUM; i++) {
+            weather_record_init(&rec);
+            sink += weather_text_parse(blocks[i], lens[i], &rec);
+        }
+    }
+    double fast_ns = (now_ns() - start) / ((double)iterations * BLOCK_NUM);
+    unsigned long fast_allocs = heap_allocs;
+
+    printf("strdup/strtok/strstr: 每块%.1fns  堆分配%lu次\n", ref_ns, ref_allocs);
+    printf("weather_text_parse:   每块%.1fns  堆分配%lu次  %.0fMB/s  快%.1f倍\n", fast_ns, fast_allocs,
+           total_bytes / (fast_ns * iterations * BLOCK_NUM) * 1e3, ref_ns / fast_ns);
+    return failed;
+}